@@ -26,14 +26,16 @@
 #include "image/ImageWriter.h"
 #include "math/ElevationPoint.h"
 #include "geo/ElevationReader.h"
+#include "geo/ElevationPointFile.h"
 #include <sstream>
 #include <fstream>
+#include <iostream>
 #include <ctime>
 #include <map>
+#include <vector>
+#include <algorithm>
 #include <omp.h>
 
-#define MAX_POINTS_IN_MEMORY 20000
-
 namespace ElevationData
 {
    struct SElevationCell
@@ -41,94 +43,225 @@ namespace ElevationData
       std::vector<ElevationPoint*> vecPts;
    };
 
-   int64 points_in_map = 0;
-
    //---------------------------------------------------------------------------
-   // Elevation Map Utils:
-   void AddPoint(std::map< int64, std::list<ElevationPoint> >& streamMap, int64 idx, ElevationPoint& pt)
+   // Points of every tile are collected in a contiguous buffer (x,y,elevation,
+   // weight as double, same layout as the points in the .pts file). Tiles are found in an
+   // open addressing hash table. When the memory budget is used up all buffers
+   // are written to disk, one write per tile.
+
+   class TilePointSpooler
    {
-      std::map< int64, std::list<ElevationPoint> >::iterator it;
-      it = streamMap.find(idx);
-      if (it == streamMap.end()) // not found, create new entry!
+   public:
+      TilePointSpooler(size_t nMemoryBudget)
+         : _nMemoryBudget(nMemoryBudget), _nPoints(0), _nTiles(0), _nActiveTiles(0), _nCapacity(0)
       {
-         std::list<ElevationPoint> lst;
-         lst.push_back(pt);
-         streamMap.insert(std::pair< int64, std::list<ElevationPoint> >(idx, lst));
+         _Allocate(1024);
       }
-      else // key found, add elevation point to existing list
+
+      //------------------------------------------------------------------------
+      // Returns false if the memory budget is used up (call Flush).
+
+      bool AddPoint(int64 idx, const ElevationPoint& pt)
       {
-         it->second.push_back(pt);
+         std::vector<double>& vBuffer = _GetBuffer(idx);
+         size_t nCapacity = vBuffer.capacity();
+         if (vBuffer.size() == 0)
+         {
+            _nActiveTiles++;
+         }
+         vBuffer.push_back(pt.x);
+         vBuffer.push_back(pt.y);
+         vBuffer.push_back(pt.elevation);
+         vBuffer.push_back(pt.weight);
+         _nCapacity += (vBuffer.capacity() - nCapacity)*sizeof(double);
+         _nPoints++;
+         return !IsFull();
       }
 
-      points_in_map++;
+      //------------------------------------------------------------------------
+      // Memory held by the spooler (buffers grow up to twice the size of their
+      // points and keep their capacity after flushing, this must be counted).
 
-   }
+      size_t GetMemory() const
+      {
+         return _nCapacity + _vKeys.size()*(sizeof(int64) + sizeof(std::vector<double>));
+      }
 
-   void WriteMap(boost::shared_ptr<MercatorQuadtree> qQuadtree, std::map< int64, std::list<ElevationPoint> >& streamMap, const std::string& sTileDir, int tilewidth_i, int lod, int64 elvTileX0, int64 elvTileY1)
-   {
-      std::map< int64, std::list<ElevationPoint> >::iterator it = streamMap.begin();
+      //------------------------------------------------------------------------
 
-      while (it!=streamMap.end())
+      bool IsFull() const
       {
-         int64 idx = it->first;
+         return GetMemory() >= _nMemoryBudget;
+      }
 
-         // convert idx to tile coord:
-         int tx = idx % tilewidth_i;
-         int ty = idx / tilewidth_i;
-         int64 tileX = tx + elvTileX0;
-         int64 tileY = elvTileY1 - ty;
+      //------------------------------------------------------------------------
 
-         std::string sQuadcode = qQuadtree->TileCoordToQuadkey(tileX,tileY,lod);
-         std::string sTilefile = ProcessingUtils::GetTilePath(sTileDir, ".pts" , lod, tileX, tileY);
+      size_t GetNumPoints() const { return _nPoints; }
+      size_t GetNumTiles() const { return _nActiveTiles; }  // tiles with points
 
-         /*double px0,py0,px1,py1;
-         qQuadtree->QuadKeyToMercatorCoord(sQuadcode, px0, py1, px1, py0);*/
+      //------------------------------------------------------------------------
+      // Append points to .pts tiles and clear buffers. Returns false if a tile
+      // couldn't be written, the points of such tiles stay in the buffers.
 
-         // LOCK this tile. If this tile is currently locked then wait until the lock is removed.
-         int lockhandle = FileSystem::Lock(sTilefile);
+      bool Flush(boost::shared_ptr<MercatorQuadtree> qQuadtree, const std::string& sTileDir, int tilewidth_i, int lod, int64 elvTileX0, int64 elvTileY1)
+      {
+         // write tiles in order of index
+         std::vector<std::pair<int64, size_t> > vTiles;
+         vTiles.reserve(_nActiveTiles);
+         for (size_t i=0;i<_vKeys.size();i++)
+         {
+            if (_vUsed[i] && _vBuffers[i].size()>0)
+            {
+               vTiles.push_back(std::make_pair(_vKeys[i], i));
+            }
+         }
+         std::sort(vTiles.begin(), vTiles.end());
 
-         std::ofstream fout;
+         bool bOk = true;
+         _nPoints = 0;
+         _nActiveTiles = 0;
 
-         if (FileSystem::FileExists(sTilefile))
+         for (size_t i=0;i<vTiles.size();i++)
          {
-            fout.open(sTilefile.c_str(), std::ios::binary | std::ios::app); // open in append mode
+            int64 idx = vTiles[i].first;
+            std::vector<double>& vBuffer = _vBuffers[vTiles[i].second];
+
+            // convert idx to tile coord:
+            int tx = idx % tilewidth_i;
+            int ty = idx / tilewidth_i;
+            int64 tileX = tx + elvTileX0;
+            int64 tileY = elvTileY1 - ty;
+
+            std::string sTilefile = ProcessingUtils::GetTilePath(sTileDir, ".pts" , lod, tileX, tileY);
+
+            // LOCK this tile. If this tile is currently locked then wait until the lock is removed.
+            int lockhandle = FileSystem::Lock(sTilefile);
+
+            bool bWritten = ElevationPointFile::Append(sTilefile, &vBuffer[0], vBuffer.size()/4);
+
+            // unlock file. Other computers/processes/threads can access it again.
+            FileSystem::Unlock(sTilefile, lockhandle);
+
+            if (bWritten)
+            {
+               vBuffer.clear();
+            }
+            else
+            {
+               std::cout << "ERROR: can't write elevation points to " << sTilefile << "\n";
+               _nPoints += vBuffer.size()/4;
+               _nActiveTiles++;
+               bOk = false;
+            }
          }
-         else
+
+         // buffers are reused for the next points, unless they leave less than
+         // half of the budget for new points.
+         if (bOk && 2*GetMemory() > _nMemoryBudget)
          {
-               fout.open(sTilefile.c_str(), std::ios::binary); // open in append mode
+            _Allocate(1024);
          }
 
-         if (fout.good())
+         return bOk;
+      }
+
+      //------------------------------------------------------------------------
+
+   protected:
+      static size_t _Hash(int64 idx)
+      {
+         uint64 h = uint64(idx);
+         h ^= h >> 33;
+         h *= 0xff51afd7ed558ccdULL;
+         h ^= h >> 33;
+         return size_t(h);
+      }
+
+      //------------------------------------------------------------------------
+
+      void _Allocate(size_t nSize)
+      {
+         _vKeys.assign(nSize, 0);
+         _vUsed.assign(nSize, false);
+         std::vector<std::vector<double> >(nSize).swap(_vBuffers);
+         _nTiles = 0;
+         _nCapacity = 0;
+      }
+
+      //------------------------------------------------------------------------
+
+      size_t _Find(int64 idx) const
+      {
+         size_t mask = _vKeys.size()-1;
+         size_t i = _Hash(idx) & mask;
+         while (_vUsed[i] && _vKeys[i] != idx)
          {
-            std::list<ElevationPoint> lst = it->second;
-            std::list<ElevationPoint>::iterator jt = lst.begin();
+            i = (i+1) & mask;  // linear probing
+         }
+         return i;
+      }
 
-            while (jt != lst.end())
-            {        
-               fout.write((const char*)&(jt->x), sizeof(double));
-               fout.write((const char*)&(jt->y), sizeof(double));
-               fout.write((const char*)&(jt->elevation), sizeof(double));
-               fout.write((const char*)&(jt->weight), sizeof(double));
+      //------------------------------------------------------------------------
 
-               jt++;
+      std::vector<double>& _GetBuffer(int64 idx)
+      {
+         size_t i = _Find(idx);
+         if (!_vUsed[i])
+         {
+            if (2*(_nTiles+1) > _vKeys.size())
+            {
+               _Grow();
+               i = _Find(idx);
             }
+            _vUsed[i] = true;
+            _vKeys[i] = idx;
+            _nTiles++;
          }
-         // unlock file. Other computers/processes/threads can access it again.
-         FileSystem::Unlock(sTilefile, lockhandle);
-
-         it++;
+         return _vBuffers[i];
       }
 
-      streamMap.clear();
-      points_in_map = 0;
+      //------------------------------------------------------------------------
 
-      //std::string sTilefile = ProcessingUtils::GetTilePath(sTileDir, ".pts" , lod, xx, yy);
-   }
+      void _Grow()
+      {
+         std::vector<int64> vKeys;
+         std::vector<bool> vUsed;
+         std::vector<std::vector<double> > vBuffers;
+         vKeys.swap(_vKeys);
+         vUsed.swap(_vUsed);
+         vBuffers.swap(_vBuffers);
+         
+         _Allocate(2*vKeys.size());
+
+         for (size_t i=0;i<vKeys.size();i++)
+         {
+            if (vUsed[i])
+            {
+               size_t j = _Find(vKeys[i]);
+               _vUsed[j] = true;
+               _vKeys[j] = vKeys[i];
+               _vBuffers[j].swap(vBuffers[i]);
+               _nCapacity += _vBuffers[j].capacity()*sizeof(double);
+               _nTiles++;
+            }
+         }
+      }
 
+      //------------------------------------------------------------------------
+
+      size_t _nMemoryBudget;
+      size_t _nPoints;
+      size_t _nTiles;         // used keys (including tiles without points)
+      size_t _nActiveTiles;   // tiles with points
+      size_t _nCapacity;      // capacity of all buffers in bytes
+      std::vector<int64> _vKeys;
+      std::vector<bool> _vUsed;
+      std::vector<std::vector<double> > _vBuffers;
+   };
 
    //---------------------------------------------------------------------------
 
-   int process( boost::shared_ptr<Logger> qLogger, boost::shared_ptr<ProcessingSettings> qSettings, std::string sLayer, bool bVerbose, bool bLock, bool bVirtual, int epsg, std::string sElevationFile, bool bFill, int& out_lod, int64& out_x0, int64& out_y0, int64& out_x1, int64& out_y1)
+   int process( boost::shared_ptr<Logger> qLogger, boost::shared_ptr<ProcessingSettings> qSettings, std::string sLayer, bool bVerbose, bool bLock, bool bVirtual, int epsg, std::string sElevationFile, bool bFill, int nCacheSize, int& out_lod, int64& out_x0, int64& out_y0, int64& out_x1, int64& out_y1)
    {
       DataSetInfo oInfo;
 
@@ -288,12 +421,10 @@ namespace ElevationData
       tilewidth = width_merc / (tilewidth);
       tileheight =  height_merc / (tileheight);
 
-      int max_threads = omp_get_max_threads();
-
-      std::map< int64, std::list<ElevationPoint> >   streamMap;
+      TilePointSpooler oSpooler(size_t(nCacheSize)*1024*1024);
 
       ElevationPoint pt;
-      int n = 0;
+      size_t n = 0;
       while (oElevationReader.GetNextPoint(pt))
       {
          n++;
@@ -301,41 +432,46 @@ namespace ElevationData
           // calculate tile coordinate of current point:         
          int64 ttx = int64((pt.x - x0) / tilewidth);
          int64 tty = int64((pt.y - y0) / tileheight);
-         int64 tileX = ttx+elvTileX0;
-         int64 tileY = tty+elvTileY0;
 
          int64 idx = tty*tilewidth_i+ttx;
 
-         AddPoint(streamMap, idx, pt);
-
-         if (points_in_map>=MAX_POINTS_IN_MEMORY) // flush
+         if (!oSpooler.AddPoint(idx, pt)) // flush
          {
             if (bVerbose)
             {
-               oss << "\nWriting (" << points_in_map << " points to disk. (";
+               oss << "\nWriting " << oSpooler.GetNumPoints() << " points (" << oSpooler.GetNumTiles() << " tiles) to disk. (";
                oss << n << " of " << numpts << " points stored)";
                qLogger->Info(oss.str());
                oss.str("");
             }
 
-            WriteMap(qQuadtree, streamMap, sTileDir, tilewidth_i, lod, elvTileX0, elvTileY1);
+            if (!oSpooler.Flush(qQuadtree, sTileDir, tilewidth_i, lod, elvTileX0, elvTileY1))
+            {
+               qLogger->Error("Failed writing elevation points!");
+               oElevationReader.Close();
+               ProcessingUtils::exit_gdal();
+               return ERROR_FILE;
+            }
          }
       }
 
       //Write remaining points:
 
-      if (bVerbose  && points_in_map>0)
+      if (bVerbose && oSpooler.GetNumPoints()>0)
       {
-         if (bVerbose)
-            {
-               oss << "\nWriting (" << streamMap.size() << " points to disk\n";
-               oss << "status: " << n << " of " << numpts << " points stored.";
-               qLogger->Info(oss.str());
-               oss.str("");
-            }
+         oss << "\nWriting " << oSpooler.GetNumPoints() << " points to disk\n";
+         oss << "status: " << n << " of " << numpts << " points stored.";
+         qLogger->Info(oss.str());
+         oss.str("");
       }
 
-      WriteMap(qQuadtree, streamMap, sTileDir, tilewidth_i, lod, elvTileX0, elvTileY1);
+      if (!oSpooler.Flush(qQuadtree, sTileDir, tilewidth_i, lod, elvTileX0, elvTileY1))
+      {
+         qLogger->Error("Failed writing elevation points!");
+         oElevationReader.Close();
+         ProcessingUtils::exit_gdal();
+         return ERROR_FILE;
+      }
 
       // finished, print stats:
       t1=clock();
@@ -23,7 +23,12 @@
 #include "geo/MercatorQuadtree.h"
 #include "image/ImageLoader.h"
 #include "image/ImageWriter.h"
+#include "image/ImageWarp.h"
+#include "data/LRUCache.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 #include <sstream>
+#include <vector>
 #include <ctime>
 #ifdef _OPENMP
 # include <omp.h>
@@ -47,11 +52,89 @@ namespace ImageData
 
    //------------------------------------------------------------------------------
    const int tilesize = 256;
-   const double dHanc = 1.0/(double(tilesize)-1.0);
-   const double dWanc = 1.0/(double(tilesize)-1.0);
+   const int stripheight = 128;  // number of rows of source image read at once
    //------------------------------------------------------------------------------
+   // The source image is read in strips of rows (only the columns used by the
+   // layer). Strips are kept in a cache with limited capacity, so the image
+   // doesn't have to fit into memory.
 
-   int process( boost::shared_ptr<Logger> qLogger, boost::shared_ptr<ProcessingSettings> qSettings, std::string sLayer, bool bVerbose, bool bLock, int epsg, std::string sImagefile, bool bFill, int& out_lod, int64& out_x0, int64& out_y0, int64& out_x1, int64& out_y1)
+   class SourceStripCache
+   {
+   public:
+      SourceStripCache(const DataSetInfo& oInfo, int x0, int x1, size_t nCapacity)
+         : _oInfo(oInfo), _x0(x0), _nWidth(x1-x0), _oCache(nCapacity), _nStripsRead(0)
+      {
+      }
+
+      // Copy rows y0 to y1-1 of the window to pDest (3*width*(y1-y0) bytes).
+      bool CopyRows(int y0, int y1, unsigned char* pDest)
+      {
+         size_t nRowSize = 3*size_t(_nWidth);
+         for (int nStrip = y0/stripheight; nStrip <= (y1-1)/stripheight; nStrip++)
+         {
+            boost::shared_array<unsigned char> qStrip = _GetStrip(nStrip);
+            if (!qStrip)
+            {
+               return false;
+            }
+
+            int r0 = math::Max<int>(y0, nStrip*stripheight);
+            int r1 = math::Min<int>(y1, (nStrip+1)*stripheight);
+            memcpy(pDest + size_t(r0-y0)*nRowSize, qStrip.get() + size_t(r0-nStrip*stripheight)*nRowSize, size_t(r1-r0)*nRowSize);
+         }
+         return true;
+      }
+
+      // Read strips containing rows y0 to y1-1 into the cache (read ahead).
+      void Prefetch(int y0, int y1)
+      {
+         for (int nStrip = y0/stripheight; nStrip <= (y1-1)/stripheight; nStrip++)
+         {
+            _GetStrip(nStrip);
+         }
+      }
+
+      // Number of strips read from the source image
+      size_t GetStripsRead() const { return _nStripsRead; }
+
+   protected:
+      // Strips are never read by two threads at the same time: read ahead 
+      // is finished before the next rows are copied.
+      boost::shared_array<unsigned char> _GetStrip(int nStrip)
+      {
+         boost::shared_array<unsigned char> qStrip;
+         if (_oCache.Get(nStrip, qStrip))
+         {
+            return qStrip;
+         }
+
+         int y = nStrip*stripheight;
+         int h = math::Min<int>(stripheight, _oInfo.nSizeY-y);
+         qStrip = boost::shared_array<unsigned char>(new unsigned char[3*size_t(_nWidth)*size_t(h)]);
+         if (!ProcessingUtils::ImageWindowToMemoryRGB(_oInfo, _x0, y, _nWidth, h, qStrip.get()))
+         {
+            return boost::shared_array<unsigned char>();
+         }
+
+         _nStripsRead++;
+         _oCache.Put(nStrip, qStrip);
+         return qStrip;
+      }
+
+      const DataSetInfo& _oInfo;
+      int _x0;
+      int _nWidth;
+      LRUCache<int, boost::shared_array<unsigned char> > _oCache;
+      size_t _nStripsRead;
+
+   private:
+      SourceStripCache(const SourceStripCache&);
+      SourceStripCache& operator=(const SourceStripCache&);
+   };
+
+   //------------------------------------------------------------------------------
+
+   int process( boost::shared_ptr<Logger> qLogger, boost::shared_ptr<ProcessingSettings> qSettings, std::string sLayer, bool bVerbose, bool bLock, int epsg, std::string sImagefile, bool bFill, int nCacheSize, EWarpFilter eFilter, int& out_lod, int64& out_x0, int64& out_y0, int64& out_x1, int64& out_y1)
    {
       DataSetInfo oInfo;
 
@@ -152,20 +235,17 @@ namespace ImageData
       out_x1 = imageTileX1;
       out_y1 = imageTileY1;
 
-      // Load image 
-      boost::shared_array<unsigned char> vImage = ProcessingUtils::ImageToMemoryRGB(oInfo);
-      unsigned char* pImage = vImage.get();
-
-      if (!vImage)
+      // currently only datasets with 3 bands (RGB) are supported
+      if (!oInfo.bGood || oInfo.nBands != 3)
       {
          qLogger->Error("Can't load image into memory!\n");
+         ProcessingUtils::exit_gdal();
          return ERROR_NOMEMORY;
       }
 
       //########################################################################
-      // Beacuse proj4 is not thread safe at this time, 
-      // the target extents are precalculate.
-      // unfortunately this can't be fixed by using OpenMP locks / critical sections
+      // The target extents (anchors) of all tiles are precalculated, every
+      // thread uses its own coordinate transformation.
 
       int64 numTiles = (imageTileX1-imageTileX0+1)*(imageTileY1-imageTileY0+1);
       boost::shared_array<Anchor> vAnchor = boost::shared_array<Anchor>(new Anchor[numTiles]);
@@ -185,9 +265,11 @@ namespace ImageData
          oss.str("");
       }
 
-      
+      #pragma omp parallel for
       for (int64 xx = imageTileX0; xx <= imageTileX1; ++xx)
       {
+         CoordinateTransformation* pCT = CoordinateTransformation::GetThreadInstance(epsg, 3785);
+
          for (int64 yy = imageTileY0; yy <= imageTileY1; ++yy)
          {
             int64 cnt = (xx-imageTileX0)*(imageTileY1-imageTileY0+1)+yy-imageTileY0;
@@ -201,34 +283,79 @@ namespace ImageData
             double lrx = px1m;
             double lry = py0m;
 
-            double anchor_Ax = ulx; 
-            double anchor_Ay = lry;
-            double anchor_Bx = lrx; 
-            double anchor_By = lry;
-            double anchor_Cx = lrx; 
-            double anchor_Cy = uly;
-            double anchor_Dx = ulx; 
-            double anchor_Dy = uly;
+            // anchors A, B, C, D
+            double ax[4] = {ulx, lrx, lrx, ulx};
+            double ay[4] = {lry, lry, uly, uly};
 
-            qCT->TransformBackwards(&anchor_Ax, &anchor_Ay);
-            qCT->TransformBackwards(&anchor_Bx, &anchor_By);
-            qCT->TransformBackwards(&anchor_Cx, &anchor_Cy);
-            qCT->TransformBackwards(&anchor_Dx, &anchor_Dy);
+            pCT->TransformBackwards(4, ax, ay);
 
-            pAnchor[cnt].anchor_Ax = anchor_Ax;
-            pAnchor[cnt].anchor_Ay = anchor_Ay;
-            pAnchor[cnt].anchor_Bx = anchor_Bx;
-            pAnchor[cnt].anchor_By = anchor_By;
-            pAnchor[cnt].anchor_Cx = anchor_Cx;
-            pAnchor[cnt].anchor_Cy = anchor_Cy;
-            pAnchor[cnt].anchor_Dx = anchor_Dx;
-            pAnchor[cnt].anchor_Dy = anchor_Dy;
-
-            cnt++;
+            pAnchor[cnt].anchor_Ax = ax[0];
+            pAnchor[cnt].anchor_Ay = ay[0];
+            pAnchor[cnt].anchor_Bx = ax[1];
+            pAnchor[cnt].anchor_By = ay[1];
+            pAnchor[cnt].anchor_Cx = ax[2];
+            pAnchor[cnt].anchor_Cy = ay[2];
+            pAnchor[cnt].anchor_Dx = ax[3];
+            pAnchor[cnt].anchor_Dy = ay[3];
          }
       }
       //########################################################################
 
+      //########################################################################
+      // Source rows needed by each row of tiles. Tile pixels are bilinear 
+      // combinations of the anchors, so they are inside the bounding box of the 
+      // anchors (in pixel coordinates). A border of 2 pixels is added for 
+      // bilinear and bicubic interpolation.
+
+      int64 numRows = imageTileY1-imageTileY0+1;
+      std::vector<std::pair<int, int> > vRows((size_t)numRows);  // rows y0 to y1-1 of source image
+      int nWindowX0 = oInfo.nSizeX;  // columns used by all tiles
+      int nWindowX1 = 0;
+      int nMaxStrips = 1;
+
+      for (int64 yy = imageTileY0; yy <= imageTileY1; ++yy)
+      {
+         double dMinX = 1e20, dMinY = 1e20, dMaxX = -1e20, dMaxY = -1e20;
+         for (int64 xx = imageTileX0; xx <= imageTileX1; ++xx)
+         {
+            const Anchor& a = pAnchor[(xx-imageTileX0)*(imageTileY1-imageTileY0+1)+yy-imageTileY0];
+            double ax[4] = {a.anchor_Ax, a.anchor_Bx, a.anchor_Cx, a.anchor_Dx};
+            double ay[4] = {a.anchor_Ay, a.anchor_By, a.anchor_Cy, a.anchor_Dy};
+            for (int i=0;i<4;i++)
+            {
+               double dPixelX = (oInfo.affineTransformation_inverse[0] + ax[i] * oInfo.affineTransformation_inverse[1] + ay[i] * oInfo.affineTransformation_inverse[2]);
+               double dPixelY = (oInfo.affineTransformation_inverse[3] + ax[i] * oInfo.affineTransformation_inverse[4] + ay[i] * oInfo.affineTransformation_inverse[5]);
+               dMinX = math::Min<double>(dMinX, dPixelX);
+               dMinY = math::Min<double>(dMinY, dPixelY);
+               dMaxX = math::Max<double>(dMaxX, dPixelX);
+               dMaxY = math::Max<double>(dMaxY, dPixelY);
+            }
+         }
+
+         int y0 = (int)math::Clamp<double>(floor(dMinY)-2.0, 0.0, double(oInfo.nSizeY));
+         int y1 = (int)math::Clamp<double>(ceil(dMaxY)+2.0, 0.0, double(oInfo.nSizeY));
+         vRows[(size_t)(yy-imageTileY0)] = std::make_pair(y0, y1);
+
+         if (y0 < y1)
+         {
+            nWindowX0 = math::Min<int>(nWindowX0, (int)math::Clamp<double>(floor(dMinX)-2.0, 0.0, double(oInfo.nSizeX)));
+            nWindowX1 = math::Max<int>(nWindowX1, (int)math::Clamp<double>(ceil(dMaxX)+2.0, 0.0, double(oInfo.nSizeX)));
+            nMaxStrips = math::Max<int>(nMaxStrips, (y1-1)/stripheight - y0/stripheight + 1);
+         }
+      }
+
+      int nWindowWidth = math::Max<int>(nWindowX1-nWindowX0, 0);
+      size_t nStripSize = math::Max<size_t>(3*size_t(nWindowWidth)*size_t(stripheight), 1);
+      size_t nCachedStrips = math::Max<size_t>(size_t(nCacheSize)*1024*1024 / nStripSize, size_t(nMaxStrips));
+      SourceStripCache oSourceCache(oInfo, nWindowX0, nWindowX0+nWindowWidth, nCachedStrips);
+
+      if (bVerbose)
+      {
+         oss << "\nSource window: columns " << nWindowX0 << " to " << nWindowX0+nWindowWidth-1 << ", caching " << nCachedStrips << " strips of " << stripheight << " rows";
+         qLogger->Info(oss.str());
+         oss.str("");
+      }
+
       if (bVerbose)
       {
          oss << "\nCalculating Tiles";
@@ -236,15 +363,64 @@ namespace ImageData
          oss.str("");
       }
 
-      // iterate through all tiles and create them
-      #pragma omp parallel for
-      for (int64 xx = imageTileX0; xx <= imageTileX1; ++xx)
+      // png decoder and tile image for each thread, buffers are reused for every tile
+      int nThreads = 1;
+#ifdef _OPENMP
+      nThreads = omp_get_max_threads();
+#endif
+      boost::shared_array<PNGDecoder> vDecoder = boost::shared_array<PNGDecoder>(new PNGDecoder[nThreads]);
+      boost::shared_array<ImageObject> vTileImage = boost::shared_array<ImageObject>(new ImageObject[nThreads]);
+
+      // source rows of current row of tiles
+      boost::shared_array<unsigned char> vImage;
+      size_t nImageSize = 0;
+
+      // iterate through all tiles row by row and create them
+      for (int64 yy = imageTileY0; yy <= imageTileY1; ++yy)
       {
-         for (int64 yy = imageTileY0; yy <= imageTileY1; ++yy)
+         int nImageY0 = vRows[(size_t)(yy-imageTileY0)].first;
+         int nImageHeight = vRows[(size_t)(yy-imageTileY0)].second - nImageY0;
+         unsigned char* pImage = 0;
+
+         if (nImageHeight > 0 && nWindowWidth > 0)
+         {
+            size_t nSize = 3*size_t(nWindowWidth)*size_t(nImageHeight);
+            if (nSize > nImageSize)
+            {
+               vImage = boost::shared_array<unsigned char>(new unsigned char[nSize]);
+               nImageSize = nSize;
+            }
+            pImage = vImage.get();
+
+            if (!oSourceCache.CopyRows(nImageY0, nImageY0+nImageHeight, pImage))
+            {
+               qLogger->Error("Can't load image into memory!\n");
+               ProcessingUtils::exit_gdal();
+               return ERROR_NOMEMORY;
+            }
+         }
+
+         // read source rows of next row of tiles while this row is created
+         boost::shared_ptr<boost::thread> qReadAhead;
+         if (yy < imageTileY1 && nWindowWidth > 0)
+         {
+            const std::pair<int, int>& oNext = vRows[(size_t)(yy-imageTileY0+1)];
+            if (oNext.first < oNext.second)
+            {
+               qReadAhead = boost::shared_ptr<boost::thread>(new boost::thread(boost::bind(&SourceStripCache::Prefetch, &oSourceCache, oNext.first, oNext.second)));
+            }
+         }
+
+         #pragma omp parallel for
+         for (int64 xx = imageTileX0; xx <= imageTileX1; ++xx)
          {
             int64 cnt = (xx-imageTileX0)*(imageTileY1-imageTileY0+1)+yy-imageTileY0;
 
-            boost::shared_array<unsigned char> vTile;
+            int nThread = 0;
+#ifdef _OPENMP
+            nThread = omp_get_thread_num();
+#endif
+            ImageObject& oTileImage = vTileImage[nThread];
 
             std::string sQuadcode = qQuadtree->TileCoordToQuadkey(xx,yy,lod);
             std::string sTilefile = ProcessingUtils::GetTilePath(sTileDir, ".png" , lod, xx, yy);
@@ -272,11 +448,11 @@ namespace ImageData
 
             //---------------------------------------------------------------------
             // if mode is --fill: (bFill)
-            //      * load possibly existing tile into vTile
-            // ...  * if there is none, clear vTile (memset 0)
+            //      * load possibly existing tile into oTileImage
+            // ...  * if there is none, clear oTileImage (memset 0)
             // if mode is --overwrite (bOverwrite)
-            //      * load possibly existing tile into vTile
-            //      * if there is none, clear vTile (memset 0)
+            //      * load possibly existing tile into oTileImage
+            //      * if there is none, clear oTileImage (memset 0)
             //      * overwrite
             //_--------------------------------------------------------------------
 
@@ -288,12 +464,10 @@ namespace ImageData
             if (FileSystem::FileExists(sTilefile))
             {
                qLogger->Info(sTilefile + " already exists, updating");
-               ImageObject outputimage;
-               if (ImageLoader::LoadFromDisk(Img::Format_PNG, sTilefile, Img::PixelFormat_RGBA, outputimage))
+               if (vDecoder[nThread].LoadFromDisk(sTilefile, Img::PixelFormat_RGBA, oTileImage))
                {
-                  if (outputimage.GetHeight() == tilesize && outputimage.GetWidth() == tilesize)
+                  if (oTileImage.GetHeight() == tilesize && oTileImage.GetWidth() == tilesize)
                   {
-                     vTile = outputimage.GetRawData();
                      bCreateNew = false;
                   }
                }
@@ -302,11 +476,11 @@ namespace ImageData
             if (bCreateNew)
             {
                // create new tile memory and clear to fully transparent
-               vTile = boost::shared_array<unsigned char>(new unsigned char[tilesize*tilesize*4]);
-               memset(vTile.get(),0,tilesize*tilesize*4);
+               oTileImage.ReallocateImage(tilesize, tilesize, Img::PixelFormat_RGBA);
+               memset(oTileImage.GetRawData().get(),0,tilesize*tilesize*4);
             }
 
-            unsigned char* pTile = vTile.get();
+            unsigned char* pTile = oTileImage.GetRawData().get();
 
             // Copy image to tile:
             /*double px0m, py0m, px1m, py1m;
@@ -335,67 +509,24 @@ namespace ImageData
             */
 
 
-            double anchor_Ax = pAnchor[cnt].anchor_Ax;
-            double anchor_Ay = pAnchor[cnt].anchor_Ay;
-            double anchor_Bx = pAnchor[cnt].anchor_Bx;
-            double anchor_By = pAnchor[cnt].anchor_By;
-            double anchor_Cx = pAnchor[cnt].anchor_Cx;
-            double anchor_Cy = pAnchor[cnt].anchor_Cy;
-            double anchor_Dx = pAnchor[cnt].anchor_Dx;
-            double anchor_Dy = pAnchor[cnt].anchor_Dy;
-   
-            // write current tile
-            for (int ty=0;ty<tilesize;++ty)
+            // anchors in pixel coordinates of the source window (order A, B, C, D)
+            const Anchor& a = pAnchor[cnt];
+            double ax[4] = {a.anchor_Ax, a.anchor_Bx, a.anchor_Cx, a.anchor_Dx};
+            double ay[4] = {a.anchor_Ay, a.anchor_By, a.anchor_Cy, a.anchor_Dy};
+            double corner[8];
+            for (int i=0;i<4;i++)
             {
-               for (int tx=0;tx<tilesize;++tx)
-               {
-                  double dx = (double)tx*dWanc;
-                  double dy = (double)ty*dHanc;
-                  double xd = (anchor_Ax*(1.0-dx)*(1.0-dy)+anchor_Bx*dx*(1.0-dy)+anchor_Dx*(1.0-dx)*dy+anchor_Cx*dx*dy);
-                  double yd = (anchor_Ay*(1.0-dx)*(1.0-dy)+anchor_By*dx*(1.0-dy)+anchor_Dy*(1.0-dx)*dy+anchor_Cy*dx*dy);
-
-                  // pixel coordinate in original image
-                  double dPixelX = (oInfo.affineTransformation_inverse[0] + xd * oInfo.affineTransformation_inverse[1] + yd * oInfo.affineTransformation_inverse[2]);
-                  double dPixelY = (oInfo.affineTransformation_inverse[3] + xd * oInfo.affineTransformation_inverse[4] + yd * oInfo.affineTransformation_inverse[5]);
-                  unsigned char r,g,b,a;
-
-                  // out of image -> set transparent
-                  if (dPixelX<0 || dPixelX>oInfo.nSizeX ||
-                     dPixelY<0 || dPixelY>oInfo.nSizeY)
-                  {
-                     r = g = b = a = 0;
-                  }
-                  else
-                  {
-                     // read pixel in image pImage[dPixelX, dPixelY] (biliear, bicubic or nearest neighbour)
-                     // and store as r,g,b
-                     _ReadImageValueBilinear(pImage, oInfo.nSizeX, oInfo.nSizeY, dPixelX, dPixelY, &r, &g, &b, &a);
-                  }
+               corner[2*i+0] = (oInfo.affineTransformation_inverse[0] + ax[i] * oInfo.affineTransformation_inverse[1] + ay[i] * oInfo.affineTransformation_inverse[2]) - nWindowX0;
+               corner[2*i+1] = (oInfo.affineTransformation_inverse[3] + ax[i] * oInfo.affineTransformation_inverse[4] + ay[i] * oInfo.affineTransformation_inverse[5]) - nImageY0;
+            }
 
-                  size_t adr=4*ty*tilesize+4*tx;
+            // out of image -> not written (transparent or existing data)
+            double valid[4] = {double(-nWindowX0), double(-nImageY0), double(oInfo.nSizeX-nWindowX0), double(oInfo.nSizeY-nImageY0)};
 
-                  if (a>0)
-                  {
-                     if (bFill)
-                     {
-                        if (pTile[adr+3] == 0)
-                        {
-                           pTile[adr+0] = r;  
-                           pTile[adr+1] = g;  
-                           pTile[adr+2] = b; 
-                           pTile[adr+3] = a;
-                        }
-                     }
-                     else // if (bOverwrite)
-                     {
-                        // currently RGB for testing purposes!
-                        pTile[adr+0] = r;  
-                        pTile[adr+1] = g;  
-                        pTile[adr+2] = b; 
-                        pTile[adr+3] = a;
-                     }
-                  }
-               }
+            // write current tile
+            if (pImage)
+            {
+               ImageWarp::RGB(pImage, nWindowWidth, nImageHeight, corner, valid, eFilter, bFill, pTile, tilesize);
             }
 
             // save tile (pTile)
@@ -409,6 +540,11 @@ namespace ImageData
             // unlock file. Other computers/processes/threads can access it again.
             FileSystem::Unlock(sTilefile, lockhandle);
          }
+
+         if (qReadAhead)
+         {
+            qReadAhead->join();
+         }
       }
 
 
@@ -420,6 +556,7 @@ namespace ImageData
 
       std::ostringstream out;
       out << "calculated in: " << double(t1-t0)/double(CLOCKS_PER_SEC) << " s \n";
+      out << "source strips read: " << oSourceCache.GetStripsRead() << "\n";
       qLogger->Info(out.str());
 
       ProcessingUtils::exit_gdal();
@@ -70,6 +70,10 @@ int main(int argc, char *argv[])
        ("verbose", "verbose output")
        ("nolock", "disable file locking (also forcing 1 thread)")
        ("force", "force adding data")
+       ("png-level", po::value<int>(), "[optional] png compression level: 0 (fastest) to 9 (smallest). Default is taken from layer settings")
+       ("png-filter", po::value<std::string>(), "[optional] png filter: none, sub, up, average, paeth or adaptive. Default is taken from layer settings")
+       ("cachesize", po::value<int>(), "[optional] memory for caching the source image (image) or spooling points (elevation, point) in MB. Default is 1024")
+       ("filter", po::value<std::string>(), "[optional] filter for resampling images: nearest, bilinear or bicubic. Default is bilinear")
        ;
 
    po::variables_map vm;
@@ -98,6 +102,10 @@ int main(int argc, char *argv[])
    bool bUseProcessStatus = true;
    //int  iMaxLod = 0;
    int  iLod;
+   int nPNGLevel = -1;
+   std::string sPNGFilter;
+   int nCacheSize = 1024;
+   EWarpFilter eFilter = WARPFILTER_BILINEAR;
 
 
    //---------------------------------------------------------------------------
@@ -237,6 +245,55 @@ int main(int argc, char *argv[])
       bError = true; // needs atleast one option (fill or overwrite)
    }
 
+   if (vm.count("png-level"))
+   {
+      nPNGLevel = vm["png-level"].as<int>();
+      if (nPNGLevel < 0 || nPNGLevel > 9)
+      {
+         bError = true;
+      }
+   }
+
+   if (vm.count("png-filter"))
+   {
+      sPNGFilter = vm["png-filter"].as<std::string>();
+      PNGSettings oTest;
+      if (!oTest.SetFilter(sPNGFilter))
+      {
+         bError = true;
+      }
+   }
+
+   if (vm.count("cachesize"))
+   {
+      nCacheSize = vm["cachesize"].as<int>();
+      if (nCacheSize < 1)
+      {
+         bError = true;
+      }
+   }
+
+   if (vm.count("filter"))
+   {
+      std::string sFilter = vm["filter"].as<std::string>();
+      if (sFilter == "nearest")
+      {
+         eFilter = WARPFILTER_NEAREST;
+      }
+      else if (sFilter == "bilinear")
+      {
+         eFilter = WARPFILTER_BILINEAR;
+      }
+      else if (sFilter == "bicubic")
+      {
+         eFilter = WARPFILTER_BICUBIC;
+      }
+      else
+      {
+         bError = true;
+      }
+   }
+
    //---------------------------------------------------------------------------
    if (bError)
    {
@@ -258,6 +315,27 @@ int main(int argc, char *argv[])
 
    int epsg = atoi(sSRS.c_str()+5);
 
+   //---------------------------------------------------------------------------
+   // png settings of layer, command line overrides layer settings
+   if (eLayer == IMAGE_LAYER || eLayer == RAWIMAGE_LAYER)
+   {
+      PNGSettings oPNGSettings;
+      boost::shared_ptr<ImageLayerSettings> qImageLayerSettings = ImageLayerSettings::Load(FilenameUtils::DelimitPath(qSettings->GetPath()) + sLayer);
+      if (qImageLayerSettings && !qImageLayerSettings->GetPNGSettings(oPNGSettings))
+      {
+         qLogger->Warn("Unknown png filter in layer settings, using default filter.");
+      }
+      if (nPNGLevel >= 0)
+      {
+         oPNGSettings.nLevel = nPNGLevel;
+      }
+      if (sPNGFilter.length() > 0)
+      {
+         oPNGSettings.SetFilter(sPNGFilter);
+      }
+      ImageWriter::SetPNGSettings(oPNGSettings);
+   }
+
 
 
    //---------------------------------------------------------------------------
@@ -343,7 +421,7 @@ int main(int argc, char *argv[])
 
    if (eLayer == IMAGE_LAYER) 
    {
-      retval = ImageData::process(qLogger, qSettings, sLayer, bVerbose, bLock, epsg, sFile, bFill, lod, x0, y0, x1, y1);
+      retval = ImageData::process(qLogger, qSettings, sLayer, bVerbose, bLock, epsg, sFile, bFill, nCacheSize, eFilter, lod, x0, y0, x1, y1);
    }
    else if (eLayer == RAWIMAGE_LAYER)
    {
@@ -351,12 +429,12 @@ int main(int argc, char *argv[])
    }
    else if (eLayer == ELEVATION_LAYER)
    {
-      retval = ElevationData::process(qLogger, qSettings, sLayer, bVerbose, bLock, bVirtual, epsg, sFile, bFill, lod, x0, y0, x1, y1);
+      retval = ElevationData::process(qLogger, qSettings, sLayer, bVerbose, bLock, bVirtual, epsg, sFile, bFill, nCacheSize, lod, x0, y0, x1, y1);
    }
 #ifdef _USE_POINTS   
    else if (eLayer == POINT_LAYER)
    {
-      retval = PointData::process(qLogger, qSettings, sLayer, bVerbose, bLock, epsg, sFile, bFill, lod, x0, y0, z0, x1, y1, z1);
+      retval = PointData::process(qLogger, qSettings, sLayer, bVerbose, bLock, epsg, sFile, bFill, nCacheSize, lod, x0, y0, z0, x1, y1, z1);
    }
 #endif
 
@@ -39,13 +39,15 @@
 #include <map>
 #include <list>
 #include <set>
+#include <vector>
 #include <omp.h>
 
 namespace PointData
 {
-   const size_t membuffer = 100000; // number of points to keep in memory
+   const size_t readbuffer = 65536; // number of points read and transformed at once
+   const int transformchunk = 1024; // number of points transformed with one call
 
-   int process( boost::shared_ptr<Logger> qLogger, boost::shared_ptr<ProcessingSettings> qSettings, std::string sLayer, bool bVerbose, bool bLock, int epsg, std::string sPointFile, bool bFill, int& out_lod, int64& out_x0, int64& out_y0, int64& out_z0, int64& out_x1, int64& out_y1, int64& out_z1)
+   int process( boost::shared_ptr<Logger> qLogger, boost::shared_ptr<ProcessingSettings> qSettings, std::string sLayer, bool bVerbose, bool bLock, int epsg, std::string sPointFile, bool bFill, int nCacheSize, int& out_lod, int64& out_x0, int64& out_y0, int64& out_z0, int64& out_x1, int64& out_y1, int64& out_z1)
    {
       clock_t t0,t1;
       t0 = clock();
@@ -56,9 +58,6 @@ namespace PointData
          return ERROR_GDAL;
       }
 
-      boost::shared_ptr<CoordinateTransformation> qCT;
-      qCT = boost::shared_ptr<CoordinateTransformation>(new CoordinateTransformation(epsg, 4326));
-
       //---------------------------------------------------------------------------
       // Retrieve PointLayerSettings:
       std::ostringstream oss;
@@ -153,54 +152,108 @@ namespace PointData
       size_t totalpoints = 0;
 
       CloudPoint pt;
-      CloudPoint pt_octree; // point in octree coords
       PointCloudReader pr;
       PointMap pointmap(lod);
+      pointmap.SetMemoryBudget(size_t(nCacheSize)*1024*1024);
+      pointmap.SetFileLocking(bLock);
 
       if (pr.Open(sPointFile))
       {
-         GeoCoord in_geopt;          
-         vec3<double> in_pt_cart;    // point in geocentric cartesian coordinates (WGS84)
-         vec3<double> out_pt_octree; // point in local octree coordinates
+         std::vector<CloudPoint> vPoints;  // points read from file
+         std::vector<CloudPoint> vOctreePoints(readbuffer);
+         std::vector<int64> vOctreeCoord(3*readbuffer);
+         vPoints.reserve(readbuffer);
+         bool bMorePoints = true;
 
-         while (pr.ReadPoint(pt))
+         while (bMorePoints)
          {
-            qCT->Transform(&pt.x, &pt.y);
-
-            in_geopt.SetLongitude(pt.x);
-            in_geopt.SetLatitude(pt.y);
-            in_geopt.SetEllipsoidHeight(pt.elevation);
-            
-            in_geopt.ToCartesian(&in_pt_cart.x, &in_pt_cart.y, &in_pt_cart.z);
-            out_pt_octree = Linv.vec3mul(in_pt_cart);
-            pt_octree.r = pt.r;
-            pt_octree.g = pt.g;
-            pt_octree.b = pt.b;
-            pt_octree.a = pt.a;
-            pt_octree.intensity = pt.intensity;
-            pt_octree.x = out_pt_octree.x;
-            pt_octree.y = out_pt_octree.y;
-            pt_octree.elevation = out_pt_octree.z;
-
-            int64 octreeX = int64(out_pt_octree.x * lodlen); 
-            int64 octreeY = int64(out_pt_octree.y * lodlen); 
-            int64 octreeZ = int64(out_pt_octree.z * lodlen); 
-
-            // now we have the octree coordinate (octreeX,Y,Z) of the point
-            // -> add the point to pointmap (which is actually a hash map)
-            // -> note: don't calculate the octocode for each point, it would be way too slow.
-            pointmap.AddPoint(octreeX, octreeY, octreeZ, pt_octree);
-
-            if (pointmap.GetNumPoints()>membuffer)
+            vPoints.clear();
+            while (vPoints.size() < readbuffer && (bMorePoints = pr.ReadPoint(pt)))
             {
-               totalpoints+=pointmap.GetNumPoints();
+               vPoints.push_back(pt);
+            }
 
-               pointmap.ExportData(sTempDir);
+            if (numpts == 0)
+            {
+               // store only attributes available in the point cloud (point cloud type is known after the first point)
+               switch (pr.GetPointCloudtype())
+               {
+               case PCT_XYZ:     pointmap.SetAttributes(POINTATTRIB_NONE); break;
+               case PCT_XYZI:    pointmap.SetAttributes(POINTATTRIB_INTENSITY); break;
+               case PCT_XYZRGB:  pointmap.SetAttributes(POINTATTRIB_COLOR); break;
+               default:          pointmap.SetAttributes(POINTATTRIB_ALL); break;
+               }
+            }
 
-               pointmap.Clear();
+            // transform points in parallel, every thread uses its own coordinate transformation
+            int nPoints = (int)vPoints.size();
+            #pragma omp parallel for
+            for (int nChunk = 0; nChunk < nPoints; nChunk += transformchunk)
+            {
+               CoordinateTransformation* pCT = CoordinateTransformation::GetThreadInstance(epsg, 4326);
+               int nCount = math::Min<int>(transformchunk, nPoints-nChunk);
+               double x[transformchunk], y[transformchunk];
+               for (int i=0;i<nCount;i++)
+               {
+                  x[i] = vPoints[nChunk+i].x;
+                  y[i] = vPoints[nChunk+i].y;
+               }
+
+               pCT->Transform(nCount, x, y);
+
+               GeoCoord in_geopt;          
+               vec3<double> in_pt_cart;    // point in geocentric cartesian coordinates (WGS84)
+               vec3<double> out_pt_octree; // point in local octree coordinates
+
+               for (int i=0;i<nCount;i++)
+               {
+                  const CloudPoint& in_pt = vPoints[nChunk+i];
+                  CloudPoint& pt_octree = vOctreePoints[nChunk+i];
+
+                  in_geopt.SetLongitude(x[i]);
+                  in_geopt.SetLatitude(y[i]);
+                  in_geopt.SetEllipsoidHeight(in_pt.elevation);
+            
+                  in_geopt.ToCartesian(&in_pt_cart.x, &in_pt_cart.y, &in_pt_cart.z);
+                  out_pt_octree = Linv.vec3mul(in_pt_cart);
+                  pt_octree.r = in_pt.r;
+                  pt_octree.g = in_pt.g;
+                  pt_octree.b = in_pt.b;
+                  pt_octree.a = in_pt.a;
+                  pt_octree.intensity = in_pt.intensity;
+                  pt_octree.x = out_pt_octree.x;
+                  pt_octree.y = out_pt_octree.y;
+                  pt_octree.elevation = out_pt_octree.z;
+
+                  vOctreeCoord[3*(nChunk+i)+0] = int64(out_pt_octree.x * lodlen); 
+                  vOctreeCoord[3*(nChunk+i)+1] = int64(out_pt_octree.y * lodlen); 
+                  vOctreeCoord[3*(nChunk+i)+2] = int64(out_pt_octree.z * lodlen); 
+               }
             }
 
-            numpts++;
+            for (int i=0;i<nPoints;i++)
+            {
+               // now we have the octree coordinate (octreeX,Y,Z) of the point
+               // -> add the point to pointmap (which is actually a hash map)
+               // -> note: don't calculate the octocode for each point, it would be way too slow.
+               pointmap.AddPoint(vOctreeCoord[3*i+0], vOctreeCoord[3*i+1], vOctreeCoord[3*i+2], vOctreePoints[i]);
+
+               if (pointmap.IsFull())
+               {
+                  totalpoints+=pointmap.GetNumPoints();
+
+                  if (!pointmap.ExportData(sTempDir))
+                  {
+                     qLogger->Error("Failed writing point voxels!");
+                     ProcessingUtils::exit_gdal();
+                     return ERROR_FILE;
+                  }
+
+                  pointmap.Clear();
+               }
+
+               numpts++;
+            }
          }
       }
       else
@@ -208,8 +261,12 @@ namespace PointData
          return -1;
       }
 
-      if (pointmap.GetNumPoints()>0)
-         pointmap.ExportData(sTempDir);
+      if (pointmap.GetNumPoints()>0 && !pointmap.ExportData(sTempDir))
+      {
+         qLogger->Error("Failed writing point voxels!");
+         ProcessingUtils::exit_gdal();
+         return ERROR_FILE;
+      }
 
       totalpoints+=pointmap.GetNumPoints();
     
@@ -232,10 +232,12 @@ namespace RawImageData
             double anchor_Dy = uly;
 
             // avoid calculating transformation per pixel using anchor point method
-            qCT->TransformBackwards(&anchor_Ax, &anchor_Ay);
-            qCT->TransformBackwards(&anchor_Bx, &anchor_By);
-            qCT->TransformBackwards(&anchor_Cx, &anchor_Cy);
-            qCT->TransformBackwards(&anchor_Dx, &anchor_Dy);
+            // (transformations are not thread safe, every thread uses its own instance)
+            CoordinateTransformation* pCT = CoordinateTransformation::GetThreadInstance(epsg, 3785);
+            pCT->TransformBackwards(&anchor_Ax, &anchor_Ay);
+            pCT->TransformBackwards(&anchor_Bx, &anchor_By);
+            pCT->TransformBackwards(&anchor_Cx, &anchor_Cy);
+            pCT->TransformBackwards(&anchor_Dx, &anchor_Dy);
 
             // write current tile
             for (int ty=0;ty<tilesize;++ty)
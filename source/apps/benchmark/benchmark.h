@@ -0,0 +1,63 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+#include "og.h"
+#include <string>
+#include <ctime>
+
+namespace benchmark
+{
+   // Print time between t0 and t1 (clock()) and tiles per second.
+   void PrintTime(const std::string& sName, int nTiles, clock_t t0, clock_t t1);
+
+   // Insert nPoints random points into a delaunay triangulation using the
+   // specified location algorithm (see math::EDelaunayLocationAlgorithms).
+   // If bBulk is true all points are inserted with one call to InsertPoints.
+   // Returns 0 on success.
+   int delaunay(int nPoints, int nAlgorithm, bool bBulk);
+
+   // Load nTiles png and raw32 tiles (256x256) with ImageLoader and with the
+   // previous implementation. Test tiles are written to sTempDir.
+   // Returns 0 on success.
+   int imageloader(int nTiles, const std::string& sTempDir);
+
+   // Encode nTiles png tiles (256x256) in memory with the previous png writer
+   // and with ImageWriter::EncodePNG using different encoders, compression 
+   // levels and filters. Returns 0 on success.
+   int pngencoder(int nTiles);
+
+   // Reduce 4 child tiles (256x256) to one tile nTiles times with ImageDownsample
+   // and with the previous implementation of ogResample and compare the results.
+   // Returns 0 on success.
+   int downsample(int nTiles);
+
+   // Create nTiles JSON and binary terrain tiles, decode the binary tiles and
+   // compare the decoded tile with the JSON tile. Returns 0 on success.
+   int terraintile(int nTiles);
+
+   // Warp nTiles RGB tiles (256x256) from a rotated source image with 
+   // ImageWarp (all filters) and with the previous implementation of ogAddData
+   // and compare the results. Returns 0 on success.
+   int warp(int nTiles);
+}
+
+
+#endif
@@ -0,0 +1,96 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include "benchmark.h"
+#include "math/delaunay/DelaunayTriangulation.h"
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <ctime>
+#include <float.h>
+
+//------------------------------------------------------------------------------
+
+namespace benchmark
+{
+   int delaunay(int nPoints, int nAlgorithm, bool bBulk)
+   {
+      // create random points in a unit rect
+      std::vector<ElevationPoint> vPoints;
+      vPoints.reserve(nPoints);
+      srand(12345);
+      for (int i=0;i<nPoints;i++)
+      {
+         ElevationPoint pt;
+         pt.x = double(rand())/double(RAND_MAX);
+         pt.y = double(rand())/double(RAND_MAX);
+         pt.elevation = 1000.0*pt.x*pt.y;
+         pt.weight = 0;
+         vPoints.push_back(pt);
+      }
+
+      std::cout << "Delaunay triangulation benchmark\n";
+      std::cout << "number of points      : " << nPoints << "\n";
+      std::cout << "location algorithm    : " << nAlgorithm << "\n";
+      std::cout << "insertion             : " << (bBulk ? "bulk (hilbert order)" : "single points") << "\n";
+
+      math::DelaunayTriangulation oTriangulation(0.0, 0.0, 1.0, 1.0, (math::EDelaunayLocationAlgorithms)nAlgorithm);
+      oTriangulation.SetEpsilon(DBL_EPSILON);
+
+      // insert points in steps of 10% to see how insertion time grows
+      int nStep = nPoints / 10;
+      if (nStep < 1) nStep = 1;
+
+      clock_t t0 = clock();
+      clock_t tStep = t0;
+      if (bBulk)
+      {
+         oTriangulation.InsertPoints(vPoints);
+      }
+      else
+      {
+         for (int i=0;i<nPoints;i++)
+         {
+            oTriangulation.InsertPoint(vPoints[i]);
+
+            if ((i+1) % nStep == 0)
+            {
+               clock_t t = clock();
+               std::cout << "   " << (i+1) << " points inserted, last " << nStep << " points took " << double(t-tStep)/double(CLOCKS_PER_SEC) << " s\n";
+               tStep = t;
+            }
+         }
+      }
+      clock_t t1 = clock();
+
+      std::vector<ElevationPoint> vResult;
+      std::vector<int> vIndices;
+      oTriangulation.GetPointVec(vResult);
+      oTriangulation.GetTriangleIndices(vIndices);
+
+      double dTime = double(t1-t0)/double(CLOCKS_PER_SEC);
+      std::cout << "total insertion time  : " << dTime << " s\n";
+      std::cout << "points per second     : " << (dTime > 0 ? double(nPoints)/dTime : 0.0) << "\n";
+      std::cout << "resulting vertices    : " << vResult.size() << "\n";
+      std::cout << "resulting triangles   : " << vIndices.size()/3 << "\n";
+
+      return 0;
+   }
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,181 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include "benchmark.h"
+#include "benchmark_reference.h"
+#include "image/ImageDownsample.h"
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+//------------------------------------------------------------------------------
+
+namespace benchmark
+{
+   //---------------------------------------------------------------------------
+
+   static void _DownsampleRGBA(unsigned char* p[4], int tilesize, unsigned char* tile, bool bScalar)
+   {
+      int half = tilesize/2;
+      size_t offset[4] = {0, size_t(4*half), size_t(4*half*tilesize), size_t(4*(half*tilesize+half))};
+      memset(tile, 0, 4*tilesize*tilesize);
+      for (int q=0;q<4;q++)
+      {
+         if (!p[q]) continue;
+         if (bScalar)
+            ImageDownsample::RGBA_Scalar(p[q], tilesize, tilesize, tile + offset[q], 4*tilesize);
+         else
+            ImageDownsample::RGBA(p[q], tilesize, tilesize, tile + offset[q], 4*tilesize);
+      }
+   }
+
+   //---------------------------------------------------------------------------
+
+   static void _DownsampleRaw(float* p[4], int tilesize, float* tile, bool bScalar)
+   {
+      int half = tilesize/2;
+      size_t offset[4] = {0, size_t(half), size_t(half*tilesize), size_t(half*tilesize+half)};
+      for (int i=0;i<tilesize*tilesize;i++)
+      {
+         tile[i] = -9999.0f;
+      }
+      for (int q=0;q<4;q++)
+      {
+         if (!p[q]) continue;
+         if (bScalar)
+            ImageDownsample::Raw32_Scalar(p[q], tilesize, tilesize, tile + offset[q], tilesize, -9999.0f);
+         else
+            ImageDownsample::Raw32(p[q], tilesize, tilesize, tile + offset[q], tilesize, -9999.0f);
+      }
+   }
+
+   //---------------------------------------------------------------------------
+
+   int downsample(int nTiles)
+   {
+      const int nTileSize = 256;
+      const size_t nPixels = nTileSize*nTileSize;
+
+      std::cout << "Downsample benchmark\n";
+      std::cout << "number of tiles       : " << nTiles << "\n";
+
+      // create 4 child tiles: random colors, some transparent pixels and one missing tile
+      srand(12345);
+      std::vector<unsigned char> vChildren(4*4*nPixels);
+      std::vector<float> vRawChildren(4*nPixels);
+      for (size_t i=0;i<4*nPixels;i++)
+      {
+         vChildren[4*i+0] = (unsigned char)(rand() & 255);
+         vChildren[4*i+1] = (unsigned char)(rand() & 255);
+         vChildren[4*i+2] = (unsigned char)(rand() & 255);
+         vChildren[4*i+3] = (rand() % 4 == 0) ? 0 : (unsigned char)(rand() & 255);
+         vRawChildren[i] = 500.0f + float(rand() % 100000) / 100.0f;
+      }
+
+      unsigned char* p[4];
+      float* pRaw[4];
+      for (int q=0;q<4;q++)
+      {
+         p[q] = &vChildren[4*q*nPixels];
+         pRaw[q] = &vRawChildren[q*nPixels];
+      }
+      p[3] = 0;
+      pRaw[3] = 0;
+
+      std::vector<unsigned char> vPrevious(4*nPixels), vScalar(4*nPixels), vResult(4*nPixels);
+      std::vector<float> vRawPrevious(nPixels), vRawScalar(nPixels), vRawResult(nPixels);
+      clock_t t0, t1;
+
+      // rgba
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         reference::ResampleQuadrants(p, nTileSize, &vPrevious[0]);
+      }
+      t1 = clock();
+      PrintTime("rgba (previous)        : ", nTiles, t0, t1);
+
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         _DownsampleRGBA(p, nTileSize, &vScalar[0], true);
+      }
+      t1 = clock();
+      PrintTime("rgba (scalar)          : ", nTiles, t0, t1);
+
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         _DownsampleRGBA(p, nTileSize, &vResult[0], false);
+      }
+      t1 = clock();
+      PrintTime("rgba (ImageDownsample) : ", nTiles, t0, t1);
+
+      if (memcmp(&vPrevious[0], &vScalar[0], 4*nPixels) != 0 ||
+          memcmp(&vPrevious[0], &vResult[0], 4*nPixels) != 0)
+      {
+         std::cout << "rgba: wrong result\n";
+         return 1;
+      }
+
+      // raw32 (without nodata values, the previous implementation doesn't handle them)
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         reference::ResampleRawQuadrants(pRaw, nTileSize, &vRawPrevious[0]);
+      }
+      t1 = clock();
+      PrintTime("raw32 (previous)       : ", nTiles, t0, t1);
+
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         _DownsampleRaw(pRaw, nTileSize, &vRawResult[0], false);
+      }
+      t1 = clock();
+      PrintTime("raw32 (ImageDownsample): ", nTiles, t0, t1);
+
+      if (memcmp(&vRawPrevious[0], &vRawResult[0], nPixels*sizeof(float)) != 0)
+      {
+         std::cout << "raw32: wrong result\n";
+         return 1;
+      }
+
+      // raw32 with nodata values: compare with scalar reference
+      for (size_t i=0;i<3*nPixels;i++)
+      {
+         if (rand() % 3 == 0) vRawChildren[i] = -9999.0f;
+      }
+      _DownsampleRaw(pRaw, nTileSize, &vRawScalar[0], true);
+      _DownsampleRaw(pRaw, nTileSize, &vRawResult[0], false);
+      if (memcmp(&vRawScalar[0], &vRawResult[0], nPixels*sizeof(float)) != 0)
+      {
+         std::cout << "raw32 (nodata): wrong result\n";
+         return 1;
+      }
+
+      std::cout << "results are identical\n";
+
+      return 0;
+   }
+}
+
+//------------------------------------------------------------------------------
+
@@ -0,0 +1,163 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include "benchmark.h"
+#include "benchmark_reference.h"
+#include "image/ImageLoader.h"
+#include "image/ImageWriter.h"
+#include "io/FileSystem.h"
+#include "string/FilenameUtils.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+//------------------------------------------------------------------------------
+
+namespace benchmark
+{
+   //---------------------------------------------------------------------------
+
+   int imageloader(int nTiles, const std::string& sTempDir)
+   {
+      const int nFiles = 16;  // number of different tiles on disk
+      const int nTileSize = 256;
+
+      if (!FileSystem::DirExists(sTempDir) && !FileSystem::makedir(sTempDir))
+      {
+         std::cout << "can't create directory " << sTempDir << "\n";
+         return 1;
+      }
+
+      std::cout << "Image loader benchmark\n";
+      std::cout << "number of tiles       : " << nTiles << "\n";
+
+      // create test tiles (png and raw)
+      srand(12345);
+      std::vector<std::string> vPNG, vRaw;
+      for (int i=0;i<nFiles;i++)
+      {
+         ImageObject oImage;
+         oImage.AllocateImage(nTileSize, nTileSize, Img::PixelFormat_RGBA);
+         unsigned char* pData = oImage.GetRawData().get();
+         for (int p=0;p<nTileSize*nTileSize;p++)
+         {
+            // smooth gradient with some noise, compresses similar to aerial images
+            int x = p % nTileSize;
+            int y = p / nTileSize;
+            pData[4*p+0] = (unsigned char)((x + rand() % 16) & 255);
+            pData[4*p+1] = (unsigned char)((y + rand() % 16) & 255);
+            pData[4*p+2] = (unsigned char)((x + y + i) & 255);
+            pData[4*p+3] = 255;
+         }
+
+         std::vector<float> vElevation(nTileSize*nTileSize);
+         for (int p=0;p<nTileSize*nTileSize;p++)
+         {
+            vElevation[p] = 500.0f + float(rand() % 10000) / 10.0f;
+         }
+
+         std::ostringstream oss;
+         oss << FilenameUtils::DelimitPath(sTempDir) << "tile" << i;
+         vPNG.push_back(oss.str() + ".png");
+         vRaw.push_back(oss.str() + ".raw");
+
+         ImageWriter::WritePNG(vPNG.back(), oImage);
+         ImageWriter::WriteRaw32(vRaw.back(), nTileSize, nTileSize, &vElevation[0]);
+
+         ImageObject oTest;
+         if (!ImageLoader::LoadFromDisk(Img::Format_PNG, vPNG.back(), Img::PixelFormat_RGBA, oTest))
+         {
+            std::cout << "can't write test tiles to " << sTempDir << "\n";
+            return 1;
+         }
+      }
+
+      // load tiles
+      ImageObject oImage;
+      Raw32ImageObject oRaw;
+      clock_t t0, t1;
+
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         reference::LoadFromDiskBytewise(Img::Format_PNG, vPNG[i % nFiles], Img::PixelFormat_RGBA, oImage);
+      }
+      t1 = clock();
+      PrintTime("png (byte by byte)    : ", nTiles, t0, t1);
+
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         ImageLoader::LoadFromDisk(Img::Format_PNG, vPNG[i % nFiles], Img::PixelFormat_RGBA, oImage);
+      }
+      t1 = clock();
+      PrintTime("png (ImageLoader)     : ", nTiles, t0, t1);
+
+      PNGDecoder oDecoder;
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         oDecoder.LoadFromDisk(vPNG[i % nFiles], Img::PixelFormat_RGBA, oImage);
+      }
+      t1 = clock();
+      PrintTime("png (PNGDecoder)      : ", nTiles, t0, t1);
+
+      // both decoders must return the same image
+      for (int i=0;i<nFiles;i++)
+      {
+         ImageObject oReference;
+         ImageLoader::LoadFromDisk(Img::Format_PNG, vPNG[i], Img::PixelFormat_RGBA, oReference);
+         oDecoder.LoadFromDisk(vPNG[i], Img::PixelFormat_RGBA, oImage);
+         if (memcmp(oReference.GetRawData().get(), oImage.GetRawData().get(), nTileSize*nTileSize*4) != 0)
+         {
+            std::cout << "PNGDecoder: wrong result for " << vPNG[i] << "\n";
+            return 1;
+         }
+      }
+
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         reference::LoadRaw32FromDiskValuewise(vRaw[i % nFiles], nTileSize, nTileSize, oRaw);
+      }
+      t1 = clock();
+      PrintTime("raw32 (value by value): ", nTiles, t0, t1);
+
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         ImageLoader::LoadRaw32FromDisk(vRaw[i % nFiles], nTileSize, nTileSize, oRaw);
+      }
+      t1 = clock();
+      PrintTime("raw32 (ImageLoader)   : ", nTiles, t0, t1);
+
+      for (int i=0;i<nFiles;i++)
+      {
+         FileSystem::rm(vPNG[i]);
+         FileSystem::rm(vRaw[i]);
+      }
+
+      return 0;
+   }
+}
+
+//------------------------------------------------------------------------------
+
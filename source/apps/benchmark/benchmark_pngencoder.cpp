@@ -0,0 +1,175 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include "benchmark.h"
+#include "image/ImageLoader.h"
+#include "image/ImageWriter.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+//------------------------------------------------------------------------------
+// previous png writer, implemented in stb_image_write.h (compiled into ImageWriter.cpp)
+unsigned char *stbi_write_png_to_mem(unsigned char *pixels, int stride_bytes, int x, int y, int n, int *out_len);
+
+//------------------------------------------------------------------------------
+
+namespace benchmark
+{
+   //---------------------------------------------------------------------------
+   // Encode all tiles with stbi_write_png (previous implementation of WritePNG)
+   // or with ImageWriter::EncodePNG (if pSettings is not null).
+
+   static bool _EncodeTiles(const std::string& sName, std::vector<ImageObject>& vTiles, int nTiles, const PNGSettings* pSettings)
+   {
+      std::vector<unsigned char> vPNG;
+      double dBytes = 0;
+      int nTileSize = vTiles[0].GetWidth();
+
+      clock_t t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         ImageObject& oTile = vTiles[i % vTiles.size()];
+         if (pSettings)
+         {
+            if (!ImageWriter::EncodePNG(oTile.GetRawData().get(), nTileSize, nTileSize, *pSettings, vPNG))
+            {
+               std::cout << sName << "failed\n";
+               return false;
+            }
+            dBytes += double(vPNG.size());
+         }
+         else
+         {
+            int nLen = 0;
+            unsigned char* pPNG = stbi_write_png_to_mem(oTile.GetRawData().get(), 4*nTileSize, nTileSize, nTileSize, 4, &nLen);
+            dBytes += double(nLen);
+            free(pPNG);
+         }
+      }
+      clock_t t1 = clock();
+
+      // check result (last tile)
+      if (pSettings)
+      {
+         ImageObject oDecoded;
+         ImageObject& oTile = vTiles[(nTiles-1) % vTiles.size()];
+         if (!ImageLoader::LoadFromMemory(Img::Format_PNG, &vPNG[0], (unsigned int)vPNG.size(), Img::PixelFormat_RGBA, oDecoded) ||
+             memcmp(oDecoded.GetRawData().get(), oTile.GetRawData().get(), nTileSize*nTileSize*4) != 0)
+         {
+            std::cout << sName << "wrong result\n";
+            return false;
+         }
+      }
+
+      double dTime = double(t1-t0)/double(CLOCKS_PER_SEC);
+      std::cout << sName << dTime << " s, " << (dTime > 0 ? double(nTiles)/dTime : 0.0) << " tiles per second, " 
+                << dBytes/double(nTiles) << " bytes per tile\n";
+
+      return true;
+   }
+
+   //---------------------------------------------------------------------------
+
+   int pngencoder(int nTiles)
+   {
+      const int nFiles = 16;  // number of different tiles
+      const int nTileSize = 256;
+
+      std::cout << "PNG encoder benchmark\n";
+      std::cout << "number of tiles       : " << nTiles << "\n";
+
+      // create test tiles: smooth gradient with some noise, the lower right
+      // part is transparent (like tiles at the border of a dataset)
+      srand(12345);
+      std::vector<ImageObject> vTiles(nFiles);
+      for (int i=0;i<nFiles;i++)
+      {
+         vTiles[i].AllocateImage(nTileSize, nTileSize, Img::PixelFormat_RGBA);
+         unsigned char* pData = vTiles[i].GetRawData().get();
+         for (int p=0;p<nTileSize*nTileSize;p++)
+         {
+            int x = p % nTileSize;
+            int y = p / nTileSize;
+            bool bInside = (x+y < nTileSize + 8*i);
+            pData[4*p+0] = bInside ? (unsigned char)((x + rand() % 8) & 255) : 0;
+            pData[4*p+1] = bInside ? (unsigned char)((y + rand() % 8) & 255) : 0;
+            pData[4*p+2] = bInside ? (unsigned char)((x + y + i) & 255) : 0;
+            pData[4*p+3] = bInside ? 255 : 0;
+         }
+      }
+
+      if (!_EncodeTiles("stbi_write_png        : ", vTiles, nTiles, 0))
+      {
+         return 1;
+      }
+
+      const char* encoders[2] = {"stb ", "zlib"};
+      const char* filters[6] = {"none", "sub", "up", "average", "paeth", "adaptive"};
+
+      for (int nEncoder=Img::PNGEncoder_STB;nEncoder<=Img::PNGEncoder_ZLIB;nEncoder++)
+      {
+#ifndef OG_USE_ZLIB
+         if (nEncoder == Img::PNGEncoder_ZLIB)
+         {
+            std::cout << "zlib                  : not available (compiled without OG_USE_ZLIB)\n";
+            break;
+         }
+#endif
+         const int levels[5] = {0, 1, 3, 6, 9};
+         for (int l=0;l<5;l++)
+         {
+            int nLevel = levels[l];
+            PNGSettings settings;
+            settings.eEncoder = (Img::PNGEncoder)nEncoder;
+            settings.nLevel = nLevel;
+
+            std::ostringstream oss;
+            oss << encoders[nEncoder] << " level " << nLevel << "          : ";
+            if (!_EncodeTiles(oss.str(), vTiles, nTiles, &settings))
+            {
+               return 1;
+            }
+         }
+
+         for (int nFilter=Img::PNGFilter_None;nFilter<=Img::PNGFilter_Adaptive;nFilter++)
+         {
+            PNGSettings settings;
+            settings.eEncoder = (Img::PNGEncoder)nEncoder;
+            settings.eFilter = (Img::PNGFilter)nFilter;
+
+            std::ostringstream oss;
+            oss << encoders[nEncoder] << " filter " << filters[nFilter];
+            while (oss.str().size() < 22) oss << " ";
+            oss << ": ";
+            if (!_EncodeTiles(oss.str(), vTiles, nTiles, &settings))
+            {
+               return 1;
+            }
+         }
+      }
+
+      return 0;
+   }
+}
+
+//------------------------------------------------------------------------------
+
@@ -0,0 +1,235 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include "benchmark_reference.h"
+#include <fstream>
+#include <vector>
+#include <cmath>
+
+//------------------------------------------------------------------------------
+
+namespace benchmark
+{
+   namespace reference
+   {
+      //------------------------------------------------------------------------
+
+      bool LoadFromDiskBytewise(Img::FileFormat eFormat, const std::string& sFilename, Img::PixelFormat eDestPixelFormat, ImageObject& outputimage)
+      {
+         std::vector<unsigned char> vecData;
+         std::ifstream ifs;
+         ifs.open(sFilename.c_str(), std::ios::in | std::ios::binary);
+         if (ifs.good())
+         {
+            unsigned char s;
+            while (!ifs.eof())
+            {
+               ifs.read((char*)&s, 1);
+               vecData.push_back(s);
+            }
+         }
+         else
+         {
+            return false;
+         }
+
+         return ImageLoader::LoadFromMemory(eFormat, &vecData[0], vecData.size(), eDestPixelFormat, outputimage);
+      }
+
+      //------------------------------------------------------------------------
+
+      bool LoadRaw32FromDiskValuewise(const std::string& sFilename, int w, int h,  Raw32ImageObject& outputdata)
+      {
+         std::ifstream ifs;
+         ifs.open(sFilename.c_str(), std::ios::binary);
+         outputdata.AllocateImage(w,h);
+         int offset = 0;
+         if (ifs.good())
+         {
+            while (!ifs.eof())
+            {
+               float value;
+               ifs.read((char*)&(value), sizeof(float));
+               if (!ifs.eof())
+               {
+                  outputdata.SetValue(offset, value);
+               }
+               offset++;
+            }
+            ifs.close();
+            return true;
+         }
+         ifs.close();
+         return false;
+      }
+
+      //------------------------------------------------------------------------
+
+      static void _InterpolatedColor(const unsigned char* rgbData, size_t adr0, size_t adr1, size_t adr2, size_t adr3, unsigned char* out)
+      {
+         size_t adr[4] = {adr0, adr1, adr2, adr3};
+         int red = 0, green = 0, blue = 0, alpha = 0;
+         int nCount = 0;
+
+         for (int i=0;i<4;i++)
+         {
+            if (rgbData[adr[i]+3] > 0)
+            {
+               red   = red + rgbData[adr[i]];
+               green = green + rgbData[adr[i]+1];
+               blue  = blue + rgbData[adr[i]+2];
+               alpha = alpha + rgbData[adr[i]+3];
+               nCount++;
+            }
+         }
+
+         if (nCount>0)
+         {
+            red/=nCount;
+            green/=nCount;
+            blue/=nCount;
+            alpha/=nCount;
+         }
+
+         if (red>255) red = 255;
+         if (green>255) green=255;
+         if (blue>255) blue=255;
+         if (alpha>255) alpha=255;
+
+         out[0] = (unsigned char)red;
+         out[1] = (unsigned char)green;
+         out[2] = (unsigned char)blue;
+         out[3] = (unsigned char)alpha;
+      }
+
+      //------------------------------------------------------------------------
+
+      void ResampleQuadrants(unsigned char* p[4], int tilesize, unsigned char* tile)
+      {
+         for (int y=0;y<tilesize;y++)
+         {
+            for (int x=0;x<tilesize;x++)
+            {
+               size_t adr = 4*y*tilesize+4*x;
+               int q = (y<tilesize/2 ? 0 : 2) + (x<tilesize/2 ? 0 : 1);
+            
+               if (p[q])
+               {
+                  int x0 = 2*(x % (tilesize/2));
+                  int y0 = 2*(y % (tilesize/2)); 
+                  int x1 = x0+1;
+                  int y1 = y0+1;
+
+                  _InterpolatedColor(p[q], 4*y0*tilesize+4*x0, 4*y0*tilesize+4*x1, 4*y1*tilesize+4*x0, 4*y1*tilesize+4*x1, tile+adr);
+               }
+               else
+               {
+                  tile[adr+0] = tile[adr+1] = tile[adr+2] = tile[adr+3] = 0;
+               }
+            }
+         }
+      }
+
+      //------------------------------------------------------------------------
+
+      void ResampleRawQuadrants(float* p[4], int tilesize, float* tile)
+      {
+         for (int y=0;y<tilesize;y++)
+         {
+            for (int x=0;x<tilesize;x++)
+            {
+               int q = (y<tilesize/2 ? 0 : 2) + (x<tilesize/2 ? 0 : 1);
+               float cvalue = -9999.0f;
+            
+               if (p[q])
+               {
+                  int x0 = 2*(x % (tilesize/2));
+                  int y0 = 2*(y % (tilesize/2)); 
+
+                  float value = p[q][y0*tilesize+x0] + p[q][y0*tilesize+x0+1] + p[q][(y0+1)*tilesize+x0] + p[q][(y0+1)*tilesize+x0+1];
+                  value/=4;
+                  cvalue = value;
+               }
+               tile[y*tilesize+x] = cvalue;
+            }
+         }
+      }
+
+      //------------------------------------------------------------------------
+
+      static inline void _ReadImageDataMem(const unsigned char* buffer, int bufferwidth, int bufferheight, int x, int y, unsigned char* rgb)
+      {
+         if (x<0) x = 0;
+         if (y<0) y = 0;
+         if (x>bufferwidth-1) x = bufferwidth-1;
+         if (y>bufferheight-1) y = bufferheight-1;
+
+         rgb[0] = buffer[bufferwidth*3*y+3*x];
+         rgb[1] = buffer[bufferwidth*3*y+3*x+1];
+         rgb[2] = buffer[bufferwidth*3*y+3*x+2];
+      }
+
+      //------------------------------------------------------------------------
+
+      void Warp(const unsigned char* pImage, int width, int height, const double anchor[8], const double inverse[6], unsigned char* pTile, int tilesize)
+      {
+         const double dWanc = 1.0/(double(tilesize)-1.0);
+         const double dHanc = 1.0/(double(tilesize)-1.0);
+
+         for (int ty=0;ty<tilesize;++ty)
+         {
+            for (int tx=0;tx<tilesize;++tx)
+            {
+               double dx = (double)tx*dWanc;
+               double dy = (double)ty*dHanc;
+               double xd = (anchor[0]*(1.0-dx)*(1.0-dy)+anchor[2]*dx*(1.0-dy)+anchor[6]*(1.0-dx)*dy+anchor[4]*dx*dy);
+               double yd = (anchor[1]*(1.0-dx)*(1.0-dy)+anchor[3]*dx*(1.0-dy)+anchor[7]*(1.0-dx)*dy+anchor[5]*dx*dy);
+
+               double x = (inverse[0] + xd * inverse[1] + yd * inverse[2]);
+               double y = (inverse[3] + xd * inverse[4] + yd * inverse[5]);
+
+               if (x<0 || x>width || y<0 || y>height)
+               {
+                  continue;
+               }
+
+               double uf = x - floor(x);
+               double vf = y - floor(y);
+               int nPixelX = int(x);
+               int nPixelY = int(y);
+
+               unsigned char p00[3], p10[3], p01[3], p11[3];
+               _ReadImageDataMem(pImage, width, height, nPixelX, nPixelY, p00);
+               _ReadImageDataMem(pImage, width, height, nPixelX+1, nPixelY, p10);
+               _ReadImageDataMem(pImage, width, height, nPixelX, nPixelY+1, p01);
+               _ReadImageDataMem(pImage, width, height, nPixelX+1, nPixelY+1, p11);
+
+               size_t adr=4*ty*tilesize+4*tx;
+               for (int c=0;c<3;c++)
+               {
+                  double v = (double(p00[c])*(1-uf)*(1-vf)+double(p10[c])*uf*(1-vf)+double(p01[c])*(1-uf)*vf+double(p11[c])*uf*vf)+0.5;
+                  pTile[adr+c] = (unsigned char)(v < 0.0 ? 0.0 : (v > 255.0 ? 255.0 : v));
+               }
+               pTile[adr+3] = 255;
+            }
+         }
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,54 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#ifndef _BENCHMARK_REFERENCE_H
+#define _BENCHMARK_REFERENCE_H
+
+#include "og.h"
+#include "image/ImageLoader.h"
+#include <string>
+
+//------------------------------------------------------------------------------
+// Previous implementations of optimized code, the benchmarks measure the
+// speedup and compare results against them. They are copies of the old code
+// and must not be changed.
+
+namespace benchmark
+{
+   namespace reference
+   {
+      // ImageLoader::LoadFromDisk (reads byte by byte)
+      bool LoadFromDiskBytewise(Img::FileFormat eFormat, const std::string& sFilename, Img::PixelFormat eDestPixelFormat, ImageObject& outputimage);
+
+      // ImageLoader::LoadRaw32FromDisk (reads value by value)
+      bool LoadRaw32FromDiskValuewise(const std::string& sFilename, int w, int h, Raw32ImageObject& outputdata);
+
+      // quadrant loop of ogResample: reduce 4 child tiles (rgba) to one tile,
+      // p[q] may be null for missing children.
+      void ResampleQuadrants(unsigned char* p[4], int tilesize, unsigned char* tile);
+
+      // quadrant loop of ogResample for raw tiles (no nodata handling)
+      void ResampleRawQuadrants(float* p[4], int tilesize, float* tile);
+
+      // tile loop of ogAddData (ImageData::process): anchors are interpolated 
+      // and transformed for every pixel, bilinear filter with bounds checks.
+      void Warp(const unsigned char* pImage, int width, int height, const double anchor[8], const double inverse[6], unsigned char* pTile, int tilesize);
+   }
+}
+
+#endif
@@ -0,0 +1,300 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include "benchmark.h"
+#include "geo/ElevationTile.h"
+#include "geo/BinaryTerrainTile.h"
+#include "geo/MercatorQuadtree.h"
+#include "math/delaunay/DelaunayTriangulation.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+#include <algorithm>
+#include <cfloat>
+
+//------------------------------------------------------------------------------
+
+namespace benchmark
+{
+   //---------------------------------------------------------------------------
+   // Read numbers of JSON array with name sName.
+
+   static void _ParseJSONArray(const std::string& sJSON, const std::string& sName, std::vector<double>& vValues)
+   {
+      vValues.clear();
+      size_t pos = sJSON.find("\"" + sName + "\"");
+      if (pos == std::string::npos) return;
+      pos = sJSON.find('[', pos);
+      if (pos == std::string::npos) return;
+
+      const char* p = sJSON.c_str() + pos + 1;
+      while (*p && *p != ']')
+      {
+         char* pEnd;
+         double value = strtod(p, &pEnd);
+         if (pEnd == p)
+         {
+            p++;  // separator
+         }
+         else
+         {
+            vValues.push_back(value);
+            p = pEnd;
+         }
+      }
+   }
+
+   //---------------------------------------------------------------------------
+   // Encode and decode tile, positions and texture coordinates must be within
+   // half a quantization step (plus float precision), indices must be equal.
+
+   static bool _CheckRoundTrip(const std::string& sName, const BinaryTerrainTileData& oIn, bool bIndex32)
+   {
+      std::string sData;
+      BinaryTerrainTileData oOut;
+      BinaryTerrainTile::Encode(oIn, sData);
+
+      if (!BinaryTerrainTile::Decode((const unsigned char*)sData.data(), sData.size(), oOut) ||
+          oOut.vertices.size() != oIn.vertices.size() ||
+          oOut.texcoords.size() != oIn.texcoords.size() ||
+          oOut.indices.size() != oIn.indices.size() ||
+          oOut.curtainindex != oIn.curtainindex)
+      {
+         std::cout << "FAILED: " << sName << ": decoded tile has wrong size\n";
+         return false;
+      }
+
+      unsigned int flags = (unsigned char)sData[20] | ((unsigned char)sData[21] << 8);
+      if (((flags & BINARYTERRAINTILE_INDEX32) != 0) != bIndex32)
+      {
+         std::cout << "FAILED: " << sName << ": wrong index size\n";
+         return false;
+      }
+
+      for (size_t i=0;i<oIn.indices.size();i++)
+      {
+         if (oIn.indices[i] != oOut.indices[i])
+         {
+            std::cout << "FAILED: " << sName << ": index " << i << " doesn't match\n";
+            return false;
+         }
+      }
+
+      // allowed error per component: (max-min)/65535/2 + eps
+      double dMin[5], dMax[5], dTolerance[5];
+      for (int c=0;c<5;c++)
+      {
+         dMin[c] = DBL_MAX;
+         dMax[c] = -DBL_MAX;
+      }
+      for (size_t i=0;i<oIn.vertices.size();i++)
+      {
+         double v[5] = {oIn.vertices[i].x, oIn.vertices[i].y, oIn.vertices[i].z, oIn.texcoords[i].x, oIn.texcoords[i].y};
+         for (int c=0;c<5;c++)
+         {
+            dMin[c] = std::min(dMin[c], v[c]);
+            dMax[c] = std::max(dMax[c], v[c]);
+         }
+      }
+      for (int c=0;c<5;c++)
+      {
+         double eps = 2.0*FLT_EPSILON*std::max(fabs(dMin[c]), fabs(dMax[c]));
+         dTolerance[c] = (dMax[c]-dMin[c])/65535.0/2.0 + eps;
+      }
+
+      for (size_t i=0;i<oIn.vertices.size();i++)
+      {
+         double vIn[5] = {oIn.vertices[i].x, oIn.vertices[i].y, oIn.vertices[i].z, oIn.texcoords[i].x, oIn.texcoords[i].y};
+         double vOut[5] = {oOut.vertices[i].x, oOut.vertices[i].y, oOut.vertices[i].z, oOut.texcoords[i].x, oOut.texcoords[i].y};
+         for (int c=0;c<5;c++)
+         {
+            if (fabs(vIn[c]-vOut[c]) > dTolerance[c])
+            {
+               std::cout << "FAILED: " << sName << ": vertex " << i << " component " << c << " error " << fabs(vIn[c]-vOut[c]) << " > " << dTolerance[c] << "\n";
+               return false;
+            }
+         }
+      }
+
+      std::cout << "round trip " << sName << " : ok (" << oIn.vertices.size() << " vertices, " << (bIndex32 ? 32 : 16) << " bit indices)\n";
+      return true;
+   }
+
+   //---------------------------------------------------------------------------
+   // Tile with nVertices random vertices, indices in random or sequential order.
+
+   static void _CreateTile(int nVertices, bool bRandomIndices, BinaryTerrainTileData& oData)
+   {
+      oData = BinaryTerrainTileData();
+      oData.offset = vec3<double>(4321000.0, 1234000.0, 4567000.0);
+      oData.bbmin = vec3<double>(-5000.0, -5000.0, -3000.0);
+      oData.bbmax = vec3<double>(5000.0, 5000.0, 3000.0);
+
+      for (int i=0;i<nVertices;i++)
+      {
+         double u = double(rand())/double(RAND_MAX);
+         double v = double(rand())/double(RAND_MAX);
+         double w = double(rand())/double(RAND_MAX);
+         oData.vertices.push_back(vec3<float>(float(-5000.0+10000.0*u), float(-5000.0+10000.0*v), float(-3000.0+6000.0*w)));
+         oData.texcoords.push_back(vec2<float>(float(u), float(v)));
+      }
+
+      for (int i=0;i+2<nVertices;i++)
+      {
+         for (int k=0;k<3;k++)
+         {
+            oData.indices.push_back(bRandomIndices ? rand() % nVertices : i+k);
+         }
+      }
+      oData.curtainindex = int(oData.indices.size()/2);
+   }
+
+   //---------------------------------------------------------------------------
+
+   int terraintile(int nTiles)
+   {
+      const int nPoints = 2000;     // points inserted into triangulation
+      const int nMaxPoints = 512;   // default of ogTriangulate
+
+      // tile in the alps
+      double x0, y0, x1, y1;
+      MercatorQuadtree::QuadKeyToMercatorCoord("120210032", x0, y1, x1, y0);
+
+      srand(12345);
+      std::vector<ElevationPoint> vPoints;
+      for (int i=0;i<nPoints;i++)
+      {
+         double u = double(rand())/double(RAND_MAX);
+         double v = double(rand())/double(RAND_MAX);
+         ElevationPoint pt;
+         pt.x = x0 + u*(x1-x0);
+         pt.y = y0 + v*(y1-y0);
+         pt.elevation = 1500.0 + 800.0*sin(6.0*u)*cos(5.0*v) + double(rand() % 100);
+         pt.weight = 0;
+         vPoints.push_back(pt);
+      }
+
+      double len = fabs(x1-x0);
+      math::DelaunayTriangulation oTriangulation(x0-len, y0-len, x1+len, y1+len);
+      oTriangulation.InsertPoints(vPoints);
+
+      ElevationPoint NW, NE, SE, SW;
+      std::vector<ElevationPoint> vNorth, vEast, vSouth, vWest, vMiddle;
+      oTriangulation.IntersectRect(x0,y0,x1,y1, NW, NE, SE, SW, vNorth, vEast, vSouth, vWest, vMiddle);
+
+      ElevationTile oElevationTile(x0,y0,x1,y1);
+      oElevationTile.Setup(NW, NE, SE, SW, vNorth, vEast, vSouth, vWest, vMiddle);
+      oElevationTile.Reduce(nMaxPoints);
+
+      std::cout << "Terrain tile benchmark\n";
+      std::cout << "number of tiles       : " << nTiles << "\n";
+      std::cout << "points per tile       : " << oElevationTile.GetNumPoints() << "\n";
+
+      std::string sJSON, sData;
+      clock_t t0, t1;
+
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         oElevationTile.CreateJSON(sJSON);
+      }
+      t1 = clock();
+      PrintTime("json (create)         : ", nTiles, t0, t1);
+
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         oElevationTile.CreateBinary(sData);
+      }
+      t1 = clock();
+      PrintTime("binary (create)       : ", nTiles, t0, t1);
+
+      BinaryTerrainTileData oData;
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         BinaryTerrainTile::Decode((const unsigned char*)sData.data(), sData.size(), oData);
+      }
+      t1 = clock();
+      PrintTime("binary (decode)       : ", nTiles, t0, t1);
+
+      std::cout << "json size             : " << sJSON.size() << " bytes\n";
+      std::cout << "binary size           : " << sData.size() << " bytes (" << 100.0*double(sData.size())/double(sJSON.size()) << "%)\n";
+
+      // compare decoded tile with JSON tile
+      std::vector<double> vVertices, vIndices, vOffset;
+      _ParseJSONArray(sJSON, "Vertices", vVertices);
+      _ParseJSONArray(sJSON, "Indices", vIndices);
+      _ParseJSONArray(sJSON, "Offset", vOffset);
+
+      if (!BinaryTerrainTile::Decode((const unsigned char*)sData.data(), sData.size(), oData) ||
+          vVertices.size() != 5*oData.vertices.size() ||
+          vIndices.size() != oData.indices.size() ||
+          vOffset.size() != 3)
+      {
+         std::cout << "FAILED: binary tile doesn't match json tile\n";
+         return 1;
+      }
+
+      for (size_t i=0;i<vIndices.size();i++)
+      {
+         if (int(vIndices[i]) != oData.indices[i])
+         {
+            std::cout << "FAILED: index " << i << " doesn't match\n";
+            return 1;
+         }
+      }
+
+      double dMaxPosError = 0, dMaxTexError = 0;
+      for (size_t i=0;i<oData.vertices.size();i++)
+      {
+         dMaxPosError = std::max(dMaxPosError, fabs(vVertices[5*i+0] - oData.vertices[i].x));
+         dMaxPosError = std::max(dMaxPosError, fabs(vVertices[5*i+1] - oData.vertices[i].y));
+         dMaxPosError = std::max(dMaxPosError, fabs(vVertices[5*i+2] - oData.vertices[i].z));
+         dMaxTexError = std::max(dMaxTexError, fabs(vVertices[5*i+3] - oData.texcoords[i].x));
+         dMaxTexError = std::max(dMaxTexError, fabs(vVertices[5*i+4] - oData.texcoords[i].y));
+      }
+
+      std::cout << "max position error    : " << dMaxPosError << " m\n";
+      std::cout << "max texcoord error    : " << dMaxTexError << "\n";
+
+      // round trip of the json tile and of large tiles (more than 65535 vertices)
+      BinaryTerrainTileData oJsonTile = oData;
+      for (size_t i=0;i<oJsonTile.vertices.size();i++)
+      {
+         oJsonTile.vertices[i] = vec3<float>(float(vVertices[5*i+0]), float(vVertices[5*i+1]), float(vVertices[5*i+2]));
+         oJsonTile.texcoords[i] = vec2<float>(float(vVertices[5*i+3]), float(vVertices[5*i+4]));
+      }
+      bool bOk = _CheckRoundTrip("json tile   ", oJsonTile, false);
+
+      BinaryTerrainTileData oLarge;
+      srand(54321);
+      _CreateTile(70000, true, oLarge);
+      bOk = _CheckRoundTrip("large random", oLarge, true) && bOk;
+      _CreateTile(70000, false, oLarge);
+      bOk = _CheckRoundTrip("large strip ", oLarge, false) && bOk;
+
+      return bOk ? 0 : 1;
+   }
+}
+
+//------------------------------------------------------------------------------
+
@@ -0,0 +1,153 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include "benchmark.h"
+#include "benchmark_reference.h"
+#include "image/ImageWarp.h"
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+
+//------------------------------------------------------------------------------
+
+namespace benchmark
+{
+   //---------------------------------------------------------------------------
+
+   int warp(int nTiles)
+   {
+      const int nTileSize = 256;
+      const int nWidth = 2048;
+      const int nHeight = 2048;
+      const int nPositions = 64;    // number of different tile positions
+
+      std::cout << "Image warp benchmark\n";
+      std::cout << "number of tiles       : " << nTiles << "\n";
+
+      // source image: smooth gradient with some noise
+      srand(12345);
+      std::vector<unsigned char> vImage(3*size_t(nWidth)*size_t(nHeight));
+      for (int y=0;y<nHeight;y++)
+      {
+         for (int x=0;x<nWidth;x++)
+         {
+            size_t adr = 3*(size_t(y)*size_t(nWidth)+size_t(x));
+            vImage[adr+0] = (unsigned char)((x/4 + rand() % 16) & 255);
+            vImage[adr+1] = (unsigned char)((y/4 + rand() % 16) & 255);
+            vImage[adr+2] = (unsigned char)((x + y) & 255);
+         }
+      }
+
+      // geo transformation of the image: 1 m pixels, rotated by 2 degrees
+      double a = 2.0*3.14159265358979/180.0;
+      double inverse[6] = {0.0, cos(a), sin(a), 0.0, -sin(a), cos(a)};
+
+      // tile anchors (in meters), tiles are 10% larger than the source pixels,
+      // every 8th tile is partially outside of the image.
+      std::vector<double> vAnchor(8*nPositions);
+      std::vector<double> vCorner(8*nPositions);
+      for (int i=0;i<nPositions;i++)
+      {
+         double x0 = (i % 8 == 0) ? -100.0 : 50.0 + double(rand() % (nWidth - 450));
+         double y0 = 50.0 + double(rand() % (nHeight - 450));
+         double s = 1.1*double(nTileSize-1);
+         double anchor[8] = {x0, y0, x0+s, y0, x0+s, y0+s, x0, y0+s};
+         for (int k=0;k<4;k++)
+         {
+            vAnchor[8*i+2*k+0] = anchor[2*k];
+            vAnchor[8*i+2*k+1] = anchor[2*k+1];
+            vCorner[8*i+2*k+0] = inverse[0] + anchor[2*k]*inverse[1] + anchor[2*k+1]*inverse[2];
+            vCorner[8*i+2*k+1] = inverse[3] + anchor[2*k]*inverse[4] + anchor[2*k+1]*inverse[5];
+         }
+      }
+      double valid[4] = {0.0, 0.0, double(nWidth), double(nHeight)};
+
+      std::vector<unsigned char> vTile(4*nTileSize*nTileSize);
+      std::vector<unsigned char> vReference(4*nTileSize*nTileSize);
+      clock_t t0, t1;
+
+      t0 = clock();
+      for (int i=0;i<nTiles;i++)
+      {
+         reference::Warp(&vImage[0], nWidth, nHeight, &vAnchor[8*(i % nPositions)], inverse, &vTile[0], nTileSize);
+      }
+      t1 = clock();
+      PrintTime("bilinear (previous)   : ", nTiles, t0, t1);
+
+      const char* sFilter[3] = {"nearest ", "bilinear", "bicubic "};
+      for (int f=0;f<3;f++)
+      {
+         EWarpFilter eFilter = (EWarpFilter)f;
+
+         t0 = clock();
+         for (int i=0;i<nTiles;i++)
+         {
+            ImageWarp::RGB_Scalar(&vImage[0], nWidth, nHeight, &vCorner[8*(i % nPositions)], valid, eFilter, false, &vTile[0], nTileSize);
+         }
+         t1 = clock();
+         PrintTime(std::string(sFilter[f]) + " (scalar)     : ", nTiles, t0, t1);
+
+         t0 = clock();
+         for (int i=0;i<nTiles;i++)
+         {
+            ImageWarp::RGB(&vImage[0], nWidth, nHeight, &vCorner[8*(i % nPositions)], valid, eFilter, false, &vTile[0], nTileSize);
+         }
+         t1 = clock();
+         PrintTime(std::string(sFilter[f]) + " (ImageWarp)  : ", nTiles, t0, t1);
+      }
+
+      // compare with previous implementation
+      int nMaxDiff = 0;
+      size_t nDiff = 0;
+      for (int i=0;i<nPositions;i++)
+      {
+         memset(&vReference[0], 0, vReference.size());
+         memset(&vTile[0], 0, vTile.size());
+         reference::Warp(&vImage[0], nWidth, nHeight, &vAnchor[8*i], inverse, &vReference[0], nTileSize);
+         ImageWarp::RGB(&vImage[0], nWidth, nHeight, &vCorner[8*i], valid, WARPFILTER_BILINEAR, false, &vTile[0], nTileSize);
+
+         for (size_t k=0;k<vTile.size();k++)
+         {
+            int d = abs(int(vTile[k]) - int(vReference[k]));
+            if (d > 0)
+            {
+               nDiff++;
+               if (d > nMaxDiff) nMaxDiff = d;
+            }
+         }
+      }
+
+      std::cout << "bilinear differences  : " << nDiff << " of " << size_t(nPositions)*vTile.size() << " values, max. difference " << nMaxDiff << "\n";
+
+      // rounding differences of +-1 are expected (single precision filtering), 
+      // larger differences (or transparent pixels) are errors.
+      if (nMaxDiff > 1)
+      {
+         std::cout << "FAILED: ImageWarp differs from previous implementation\n";
+         return 1;
+      }
+
+      return 0;
+   }
+}
+
+//------------------------------------------------------------------------------
+
@@ -0,0 +1,170 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+/******************************************************************************/
+/* This application measures the performance of core algorithms of the        */
+/* processing library (independent of any layer or dataset).                  */
+/******************************************************************************/
+
+#include "benchmark.h"
+#include "math/delaunay/DelaunayLocationStructure.h"
+#include <iostream>
+#include <string>
+#include <boost/program_options.hpp>
+
+//-----------------------------------------------------------------------------
+
+void benchmark::PrintTime(const std::string& sName, int nTiles, clock_t t0, clock_t t1)
+{
+   double dTime = double(t1-t0)/double(CLOCKS_PER_SEC);
+   std::cout << sName << dTime << " s, " << (dTime > 0 ? double(nTiles)/dTime : 0.0) << " tiles per second\n";
+}
+
+//-----------------------------------------------------------------------------
+
+namespace po = boost::program_options;
+
+int main(int argc, char *argv[])
+{
+   po::options_description desc("Program-Options");
+   desc.add_options()
+       ("delaunay", "benchmark delaunay triangulation (point insertion)")
+       ("numpoints", po::value<int>(), "[optional] number of points to insert. Default is 100000")
+       ("location", po::value<std::string>(), "[optional] point location algorithm: \"linear\" or \"walk\". Default is \"walk\"")
+       ("bulk", "[optional] insert all points at once (InsertPoints)")
+       ("imageloader", "benchmark loading of png and raw tiles")
+       ("pngencoder", "benchmark png encoding (throughput and size)")
+       ("downsample", "benchmark 2x2 reduction of rgba and raw tiles")
+       ("terraintile", "benchmark json and binary terrain tiles (creation, decoding and size)")
+       ("warp", "benchmark warping of source images to tiles (nearest, bilinear and bicubic)")
+       ("numtiles", po::value<int>(), "[optional] number of tiles to load/encode/reduce. Default is 2000")
+       ("tempdir", po::value<std::string>(), "[optional] directory for temporary files. Default is \"benchmark_temp\"")
+       ;
+
+   po::variables_map vm;
+
+   bool bError = false;
+
+   try
+   {
+      po::store(po::parse_command_line(argc, argv, desc), vm);
+      po::notify(vm);
+   }
+   catch (std::exception&)
+   {
+      bError = true;
+   }
+
+   int nPoints = 100000;
+   int nTiles = 2000;
+   std::string sTempDir = "benchmark_temp";
+   int nLocation = math::DELAUNAYLOCATION_JUMPANDWALK;
+
+   if (vm.count("numpoints"))
+   {
+      nPoints = vm["numpoints"].as<int>();
+      if (nPoints < 1)
+      {
+         std::cout << "numpoints must be >=1\n";
+         bError = true;
+      }
+   }
+
+   if (vm.count("numtiles"))
+   {
+      nTiles = vm["numtiles"].as<int>();
+      if (nTiles < 1)
+      {
+         std::cout << "numtiles must be >=1\n";
+         bError = true;
+      }
+   }
+
+   if (vm.count("tempdir"))
+   {
+      sTempDir = vm["tempdir"].as<std::string>();
+   }
+
+   if (vm.count("location"))
+   {
+      std::string sLocation = vm["location"].as<std::string>();
+      if (sLocation == "linear")
+      {
+         nLocation = math::DELAUNAYLOCATION_LINEARLIST;
+      }
+      else if (sLocation == "walk")
+      {
+         nLocation = math::DELAUNAYLOCATION_JUMPANDWALK;
+      }
+      else
+      {
+         std::cout << "unknown location algorithm " << sLocation << "\n";
+         bError = true;
+      }
+   }
+
+   if (!vm.count("delaunay") && !vm.count("imageloader") && !vm.count("pngencoder") && !vm.count("downsample") && !vm.count("terraintile") && !vm.count("warp"))
+   {
+      bError = true;
+   }
+
+   //---------------------------------------------------------------------------
+   if (bError)
+   {
+      std::cout << desc << "\n";
+      return 1;
+   }
+   //---------------------------------------------------------------------------
+
+   int nResult = 0;
+
+   if (vm.count("delaunay"))
+   {
+      nResult = benchmark::delaunay(nPoints, nLocation, vm.count("bulk") > 0);
+   }
+
+   if (vm.count("imageloader") && nResult == 0)
+   {
+      nResult = benchmark::imageloader(nTiles, sTempDir);
+   }
+
+   if (vm.count("pngencoder") && nResult == 0)
+   {
+      nResult = benchmark::pngencoder(nTiles);
+   }
+
+   if (vm.count("downsample") && nResult == 0)
+   {
+      nResult = benchmark::downsample(nTiles);
+   }
+
+   if (vm.count("terraintile") && nResult == 0)
+   {
+      nResult = benchmark::terraintile(nTiles);
+   }
+
+   if (vm.count("warp") && nResult == 0)
+   {
+      nResult = benchmark::warp(nTiles);
+   }
+
+   return nResult;
+}
+
+
+//------------------------------------------------------------------------------
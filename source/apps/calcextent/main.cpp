@@ -30,6 +30,7 @@
 #include <float.h>
 #include <iostream>
 #include <ctime>
+#include <vector>
 #include <boost/program_options.hpp>
 
 
@@ -193,24 +194,38 @@ int _frominput(const std::vector<std::string>& vecFiles, const std::string& srs,
 
       size_t numpts = 0;
 
-      CloudPoint pt;
+      std::vector<CloudPoint> vPoints;
+      std::vector<double> vX, vY;
       for (size_t i = 0; i< vecFiles.size();++i)
       {
          PointCloudReader pr;
 
          if (pr.Open(vecFiles[i]))
          {
-            while (pr.ReadPoint(pt))
+            // points are read and transformed in batches
+            while (pr.ReadPoints(vPoints))
             {
-               qCT->Transform(&pt.x, &pt.y);
-               xmin = math::Min<double>(xmin, pt.x);
-               ymin = math::Min<double>(ymin, pt.y);
-               zmin = math::Min<double>(zmin, pt.elevation);
-               xmax = math::Max<double>(xmax, pt.x);
-               ymax = math::Max<double>(ymax, pt.y);
-               zmax = math::Max<double>(zmax, pt.elevation);
-
-               numpts++;
+               vX.resize(vPoints.size());
+               vY.resize(vPoints.size());
+               for (size_t j=0;j<vPoints.size();j++)
+               {
+                  vX[j] = vPoints[j].x;
+                  vY[j] = vPoints[j].y;
+               }
+
+               qCT->Transform((int)vPoints.size(), &vX[0], &vY[0]);
+
+               for (size_t j=0;j<vPoints.size();j++)
+               {
+                  xmin = math::Min<double>(xmin, vX[j]);
+                  ymin = math::Min<double>(ymin, vY[j]);
+                  zmin = math::Min<double>(zmin, vPoints[j].elevation);
+                  xmax = math::Max<double>(xmax, vX[j]);
+                  ymax = math::Max<double>(ymax, vY[j]);
+                  zmax = math::Max<double>(zmax, vPoints[j].elevation);
+               }
+
+               numpts += vPoints.size();
             }
          }
       }
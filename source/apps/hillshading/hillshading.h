@@ -33,6 +33,10 @@
 #include <image/ImageWriter.h>
 #include "geo/MercatorQuadtree.h"
 #include <io/FileSystem.h>
+#include "ogprocess.h"
+#include "data/LRUCache.h"
+#include <fstream>
+#include <utility>
 #include <gdal.h>
 #include <gdalgrid.h>
 #include <gdal_priv.h>
@@ -224,6 +228,64 @@ struct HSProcessChunk
    double dfXMin, dfXMax, dfYMin, dfYMax;
    int layerLod;
 };
+
+// ------------------------------ Raw tile cache
+
+// Decoded .raw tiles (256x256 floats) are shared by all threads. Every tile is
+// used by the 3x3 neighbourhood of 9 output tiles.
+#define HS_RAWTILE_SIZE    256
+#define HS_RAWTILE_BYTES   (HS_RAWTILE_SIZE*HS_RAWTILE_SIZE*sizeof(float))
+
+// Tiles are processed in vertical strips of HS_STRIP_WIDTH columns, row by row.
+// Like this neighbour tiles are still cached when they are reused.
+#define HS_STRIP_WIDTH     32
+
+typedef boost::shared_ptr< std::vector<float> > RawTilePtr;    // empty if tile doesn't exist
+typedef LRUCache< std::pair<int64, int64>, RawTilePtr > RawTileCache;
+
+//---------------------------------------------------------------------------
+inline RawTilePtr LoadRawTile(const std::string& sTilefile)
+{
+   RawTilePtr qTile = RawTilePtr(new std::vector<float>());
+
+   std::ifstream fin;
+   fin.open(sTilefile.c_str(), std::ios::binary);
+   if (fin.good())
+   {
+      qTile->resize(HS_RAWTILE_SIZE*HS_RAWTILE_SIZE);
+      fin.read((char*)&(*qTile)[0], HS_RAWTILE_BYTES);
+      qTile->resize((size_t)fin.gcount() / sizeof(float));
+   }
+   fin.close();
+
+   return qTile;
+}
+
+//---------------------------------------------------------------------------
+inline RawTilePtr GetRawTile(RawTileCache& oCache, const std::string& sTempTileDir, int lod, int64 x, int64 y)
+{
+   RawTilePtr qTile;
+   std::pair<int64, int64> key(x, y);
+
+   if (!oCache.Get(key, qTile))
+   {
+      // two threads may load the same tile at the same time, this is not a problem.
+      qTile = LoadRawTile(ProcessingUtils::GetTilePath(sTempTileDir, ".raw" , lod, x, y));
+      oCache.Put(key, qTile);
+   }
+
+   return qTile;
+}
+
+//---------------------------------------------------------------------------
+// copy raw tile to position (posX, posY) of image
+inline void CopyRawTile(const RawTilePtr& qTile, Raw32ImageObject& oImage, int posX, int posY)
+{
+   for (size_t i=0;i<qTile->size();i++)
+   {
+      oImage.SetValue(posX + int(i % HS_RAWTILE_SIZE), posY + int(i / HS_RAWTILE_SIZE), (*qTile)[i]);
+   }
+}
 //---------------------------------------------------------------------------
 inline void _ReadRawImageDataMem(float* buffer, int bufferwidth, int bufferheight, int x, int y, float* value)
 {
@@ -185,74 +185,61 @@ int main(int argc, char *argv[])
       return 1;
    }   
 
-#ifndef _DEBUG
-#     pragma omp parallel for
-#endif
-   for (int64 xx = layerTileX0+1; xx < layerTileX1; ++xx)
+   // Tiles are processed in vertical strips of HS_STRIP_WIDTH columns, row by row.
+   std::vector< std::pair<int64, int64> > vecTiles;
+   for (int64 sx = layerTileX0+1; sx < layerTileX1; sx += HS_STRIP_WIDTH)
    {
       for (int64 yy = layerTileY0+1; yy < layerTileY1; ++yy)
       {
-         std::string sCurrentQuadcode = qQuadtree->TileCoordToQuadkey(xx,yy,lod);
-
-         //std::cout << sCurrentQuadcode << "\n";
-         HSProcessChunk pData;
-         pData.dfXMax = -1e20;
-         pData.dfYMax = -1e20;
-         pData.dfXMin = 1e20;
-         pData.dfYMin = 1e20;
-         pData.data.AllocateImage(inputX, inputY);
-         for (int ty=-1;ty<=1;ty++)
+         for (int64 xx = sx; xx < layerTileX1 && xx < sx + HS_STRIP_WIDTH; ++xx)
          {
-            for (int tx=-1;tx<=1;tx++)
-            {
-               std::string sQuadcode = qQuadtree->TileCoordToQuadkey(xx+tx,yy+ty,lod);
-               std::string sTilefile = ProcessingUtils::GetTilePath(sTempTileDir, ".raw" , lod, xx+tx, yy+ty);
-                  
-               double sx0, sy1, sx1, sy0;
-               qQuadtree->QuadKeyToMercatorCoord(sQuadcode, sx0, sy1, sx1, sy0);
-               
-               pData.dfXMax = math::Max<double>(pData.dfXMax, sx1);
-               pData.dfYMax = math::Max<double>(pData.dfXMax, sy1);
-               pData.dfXMin = math::Min<double>(pData.dfXMin, sx0);
-               pData.dfYMin = math::Min<double>(pData.dfXMin, sy0);
-
-               assert(sx0 < sx1);
-               assert(sy0 < sy1);
-
-               //std::cout << "   " << sTilefile << "\n";
+            vecTiles.push_back(std::pair<int64, int64>(xx, yy));
+         }
+      }
+   }
 
-               std::ifstream fin;
-               fin.open(sTilefile.c_str(), std::ios::binary);
-               int posX = (tx+1)*(inputX/3);
-               int posY = (ty+1)*(inputY/3);
-               int offX = 0;
-               int offY = 0;
-               if (fin.good())
-               {
-                  while (!fin.eof())
-                  {
-                     
-                     float value;
-                     fin.read((char*)&(value), sizeof(float));
-                     if (!fin.eof())
-                     {
-                        pData.data.SetValue(posX+offX, posY+offY, value);
-                     }
-                     offX++;
-                     if(offX % 256 == 0)
-                     {
-                        offX = 0;
-                        offY++;
-                     }
+   // cache must hold 3 rows of a strip (+ tiles used by threads running ahead)
+   RawTileCache oRawTileCache(4*(HS_STRIP_WIDTH+2) + 9*omp_get_max_threads());
 
-                  }
-               }
-               fin.close();
-            }
+#ifndef _DEBUG
+#     pragma omp parallel for schedule(dynamic)
+#endif
+   for (int nTile = 0; nTile < (int)vecTiles.size(); ++nTile)
+   {
+      int64 xx = vecTiles[nTile].first;
+      int64 yy = vecTiles[nTile].second;
+      std::string sCurrentQuadcode = qQuadtree->TileCoordToQuadkey(xx,yy,lod);
+
+      //std::cout << sCurrentQuadcode << "\n";
+      HSProcessChunk pData;
+      pData.dfXMax = -1e20;
+      pData.dfYMax = -1e20;
+      pData.dfXMin = 1e20;
+      pData.dfYMin = 1e20;
+      pData.data.AllocateImage(inputX, inputY);
+      for (int ty=-1;ty<=1;ty++)
+      {
+         for (int tx=-1;tx<=1;tx++)
+         {
+            std::string sQuadcode = qQuadtree->TileCoordToQuadkey(xx+tx,yy+ty,lod);
+               
+            double sx0, sy1, sx1, sy0;
+            qQuadtree->QuadKeyToMercatorCoord(sQuadcode, sx0, sy1, sx1, sy0);
+            
+            pData.dfXMax = math::Max<double>(pData.dfXMax, sx1);
+            pData.dfYMax = math::Max<double>(pData.dfXMax, sy1);
+            pData.dfXMin = math::Min<double>(pData.dfXMin, sx0);
+            pData.dfYMin = math::Min<double>(pData.dfXMin, sy0);
+
+            assert(sx0 < sx1);
+            assert(sy0 < sy1);
+
+            RawTilePtr qTile = GetRawTile(oRawTileCache, sTempTileDir, lod, xx+tx, yy+ty);
+            CopyRawTile(qTile, pData.data, (tx+1)*(inputX/3), (ty+1)*(inputY/3));
          }
-         // Generate tile
-         process_hillshading(sTileDir, pData, xx, yy, lod, z_depth, azimut, altitude, sscale,1,false, false, outputX, outputY);
       }
+      // Generate tile
+      process_hillshading(sTileDir, pData, xx, yy, lod, z_depth, azimut, altitude, sscale,1,false, false, outputX, outputY);
    }
    GDALDestroyDriverManager();
    return 0;
@@ -93,6 +93,7 @@ struct SJob
    int64 layerTileX0, layerTileY0, layerTileX1, layerTileY1;
    QueueManager _QueueManager = QueueManager();
    boost::shared_array<ImageObject> pTextures;
+   boost::shared_ptr<RawTileCache> qRawTileCache;
 // -------------------------------------------------------------------
 
 //  Job function (called every thread/compute node)
@@ -117,7 +118,6 @@ void ProcessJob(const SJob& job, int layerLod)
       {
          //std::string sQuadcode = qQuadtree->TileCoordToQuadkey(job.xx+tx,job.yy+ty,job.lod);
          std::string sQuadcode = qQuadtree->TileCoordToQuadkey(parentX+tx, parentY+ty,parentLod);
-         std::string sTilefile = ProcessingUtils::GetTilePath(sTempTileDir, ".raw" , parentLod, parentX+tx, parentY+ty);
                   
          double sx0, sy1, sx1, sy0;
          qQuadtree->QuadKeyToMercatorCoord(sQuadcode, sx0, sy1, sx1, sy0);
@@ -130,34 +130,8 @@ void ProcessJob(const SJob& job, int layerLod)
          assert(sx0 < sx1);
          assert(sy0 < sy1);
 
-         //std::cout << "   " << sTilefile << "\n";
-
-         std::ifstream fin;
-         fin.open(sTilefile.c_str(), std::ios::binary);
-         int posX = (tx+1)*(inputX/3);
-         int posY = (ty+1)*(inputY/3);
-         int offX = 0;
-         int offY = 0;
-         if (fin.good())
-         {
-            while (!fin.eof())
-            {    
-               float value;
-               fin.read((char*)&(value), sizeof(float));
-               if (!fin.eof())
-               {
-                  pData.data.SetValue(posX+offX, posY+offY, value);
-               }
-               offX++;
-               if(offX % 256 == 0)
-               {
-                  offX = 0;
-                  offY++;
-               }
-
-            }
-         }
-         fin.close();
+         RawTilePtr qTile = GetRawTile(*qRawTileCache, sTempTileDir, parentLod, parentX+tx, parentY+ty);
+         CopyRawTile(qTile, pData.data, (tx+1)*(inputX/3), (ty+1)*(inputY/3));
       }
    }
    // Generate tile
@@ -205,6 +179,7 @@ int main(int argc, char *argv[])
       ("slopescale", po::value<double>(),"[optional] define slope scale default 1")
       ("numthreads", po::value<int>(), "[optional] force number of threads")
       ("amount", po::value<int>(), "[opional] define amount of jobs to be read for one process at the time")
+      ("cachesize", po::value<int>(), "[optional] memory for caching elevation tiles in MB. Default is 256")
       ("zdepth", po::value<double>(), "[opional] hillshading z factor")
       ("azimut", po::value<double>(), "[opional] hillshading azimut")
       ("altitude", po::value<double>(), "[opional] hillshading altitude")
@@ -261,6 +236,9 @@ int main(int argc, char *argv[])
    }
    if(vm.count("amount"))
       iAmount = vm["amount"].as<int>();
+   int iCacheSize = 256;
+   if(vm.count("cachesize"))
+      iCacheSize = vm["cachesize"].as<int>();
    if(vm.count("zdepth"))
       z_depth = vm["zdepth"].as<double>();
    if(vm.count("azimut"))
@@ -316,6 +294,8 @@ int main(int argc, char *argv[])
    // -- Beginn process
    sTempTileDir = sLayerPath + "/temp/tiles/";
    sTileDir = sLayerPath + "/tiles/";
+   size_t nCachedTiles = math::Max<size_t>(size_t(iCacheSize)*1024*1024 / HS_RAWTILE_BYTES, 9);
+   qRawTileCache = boost::shared_ptr<RawTileCache>(new RawTileCache(nCachedTiles));
 
    boost::shared_ptr<ImageLayerSettings> qImageLayerSettings = ImageLayerSettings::Load(sLayerPath);
 
@@ -424,22 +404,29 @@ int main(int argc, char *argv[])
       
          int idx = 0;
          std::cout << "[" << sProcessHostName<< "] " << " Generating jobs starting from (z, x, y) " << "(" << lod << ", " << layerTileX0+(bBorders ? 0 : 1) << ", " << layerTileY0+(bBorders ? 0 : 1) << ")\n"<< std::flush;
-         for (int64 xx = layerTileX0+(bBorders ? 0 : 1); xx < layerTileX1+(bBorders ? 1 : 0); ++xx)
+         // jobs are ordered in strips of HS_STRIP_WIDTH columns (row by row), so 
+         // neighbouring jobs use the same elevation tiles.
+         int64 tileX0 = layerTileX0+(bBorders ? 0 : 1);
+         int64 tileX1 = layerTileX1+(bBorders ? 1 : 0);
+         for (int64 sx = tileX0; sx < tileX1; sx += HS_STRIP_WIDTH)
          {
             for (int64 yy = layerTileY0+(bBorders ? 0 : 1); yy < layerTileY1+(bBorders ? 1 : 0); ++yy)
             {
-               QJob job;
-               SJob sJob;
-               sJob.lod = lod;
-               sJob.xx = xx;
-               sJob.yy = yy;
-               job.data = boost::shared_array<char>(new char[sizeof(SJob)]);
-               memcpy(job.data.get(), &sJob, sizeof(SJob));
-               job.size = sizeof(SJob);
-               _QueueManager.AddToJobQueue(sJobQueueFile, job, (bOverrideQueue && idx == 0)? false : true);
-               idx++;
-               iX = xx;
-               iY = yy;
+               for (int64 xx = sx; xx < tileX1 && xx < sx + HS_STRIP_WIDTH; ++xx)
+               {
+                  QJob job;
+                  SJob sJob;
+                  sJob.lod = lod;
+                  sJob.xx = xx;
+                  sJob.yy = yy;
+                  job.data = boost::shared_array<char>(new char[sizeof(SJob)]);
+                  memcpy(job.data.get(), &sJob, sizeof(SJob));
+                  job.size = sizeof(SJob);
+                  _QueueManager.AddToJobQueue(sJobQueueFile, job, (bOverrideQueue && idx == 0)? false : true);
+                  idx++;
+                  iX = xx;
+                  iY = yy;
+               }
             }
          }
          _QueueManager.CommitJobQueue(sJobQueueFile);
@@ -476,7 +463,7 @@ int main(int argc, char *argv[])
          std::cout << "..Processing parallel using " << numThreads << "\n";
                #pragma omp parallel shared(vecConverted, sTempTileDir, sTileDir, inputX, inputY, outputX, outputY)
                {
-                  #pragma omp for 
+                  #pragma omp for schedule(dynamic)
 #endif
                   for(int index = 0; index < vecConverted.size(); index++)
                   {
@@ -32,29 +32,33 @@
 #include <fstream>
 #include <boost/program_options.hpp>
 #include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <sstream>
+#include <vector>
 #include <omp.h>
 
 
+
+
 std::string g_sPath;
-std::string g_sLockFile;
+std::vector<std::string> g_vCounterFiles;
 int g_numthreads;
 int g_iterations;
 
 //-----------------------------------------------------------------------------
 
 // this function is called from another thread
-void threadfunc()
+void threadfunc(int nThread)
 {
-   boost::thread::id  id = boost::this_thread::get_id();
- 
    for (int i=0;i<g_iterations;i++)
    {
-      int handle = FileSystem::Lock(g_sLockFile);
+      const std::string& sCounterFile = g_vCounterFiles[(nThread + i) % g_vCounterFiles.size()];
+      int handle = FileSystem::Lock(sCounterFile);
       int cnt;
 
       std::ifstream ifs;
-      ifs.open(g_sLockFile.c_str());
+      ifs.open(sCounterFile.c_str());
       if (ifs.good())
       {
          ifs >> cnt;
@@ -64,18 +68,86 @@ void threadfunc()
       {
          cnt = 0; // first file or failure!
       }
-      
+
       // increment counter
       cnt++;
 
       // overwrite file with incremented value:
       std::ofstream ofs;
-      ofs.open(g_sLockFile.c_str());
+      ofs.open(sCounterFile.c_str());
       ofs << cnt;
       ofs.close();
 
-      FileSystem::Unlock(g_sLockFile, handle);
+      FileSystem::Unlock(sCounterFile, handle);
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Run test using specified lock mode, returns false if counters are wrong.
+
+bool runtest(ELockMode eMode, int numfiles)
+{
+   std::string sMode = (eMode == LOCKMODE_ADVISORY) ? "advisory" : "file";
+
+   g_vCounterFiles.clear();
+   for (int i=0;i<numfiles;i++)
+   {
+      std::ostringstream oss;
+      oss << FilenameUtils::DelimitPath(g_sPath) << "locktest_" << sMode << "_" << i << ".txt";
+      g_vCounterFiles.push_back(oss.str());
+   }
+
+   if (!FileSystem::SetLockMode(eMode))
+   {
+      return false;
+   }
+   FileSystem::ResetLockStatistics();
+
+   boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+
+   boost::thread_group  threads;
+
+   for (int i=0;i<g_numthreads;++i)
+   {
+      threads.create_thread(boost::bind(threadfunc, i));
+   }
+
+   threads.join_all();
+
+   double dTime = double((boost::posix_time::microsec_clock::universal_time() - t0).total_microseconds()) / 1e6;
+   LockStatistics oStats = FileSystem::GetLockStatistics();
+
+   if (oStats.nTimeouts > 0)
+   {
+      std::cout << "lock mode " << sMode << " is not supported on this file system\n";
+      return false;
+   }
+
+   // sum of all counters
+   int64 nSum = 0;
+   for (size_t i=0;i<g_vCounterFiles.size();i++)
+   {
+      std::ifstream ifs;
+      ifs.open(g_vCounterFiles[i].c_str());
+      int cnt = 0;
+      if (ifs.good())
+      {
+         ifs >> cnt;
+      }
+      nSum += cnt;
    }
+
+   int64 nExpected = int64(g_numthreads) * int64(g_iterations);
+
+   std::cout << "lock mode             : " << sMode << "\n";
+   std::cout << "time                  : " << dTime << " s\n";
+   std::cout << "locks per second      : " << (dTime > 0 ? double(oStats.nLocks)/dTime : 0.0) << "\n";
+   std::cout << "contended locks       : " << oStats.nContended << " of " << oStats.nLocks << "\n";
+   std::cout << "time spent waiting    : " << oStats.dWaitTime << " s (all threads)\n";
+   std::cout << "sum of counters       : " << nSum << " (at least " << nExpected << ")\n";
+
+   // other computers running the test at the same time increment the counters too
+   return nSum >= nExpected;
 }
 
 //-----------------------------------------------------------------------------
@@ -89,11 +161,15 @@ int main(int argc, char *argv[])
        ("path", po::value<std::string>(), "where to run test (this path must exist)")
        ("numthreads", po::value<int>(), "number of threads to use for test")
        ("iterations", po::value<int>(), "number of iterations per thread")
+       ("numfiles", po::value<int>(), "[optional] number of locked files (default 1)")
+       ("lockmode", po::value<std::string>(), "[optional] advisory or file (default: OPENWEBGLOBE_LOCKMODE, like all tools)")
        ;
 
    po::variables_map vm;
 
    bool bError = false;
+   int numfiles = 1;
+   ELockMode eLockMode = FileSystem::GetLockMode();
 
    try
    {
@@ -105,7 +181,7 @@ int main(int argc, char *argv[])
       bError = true;
    }
 
-  
+
    if (!vm.count("path") || !vm.count("numthreads") || !vm.count("iterations"))
    {
       bError = true;
@@ -117,19 +193,45 @@ int main(int argc, char *argv[])
       g_iterations = vm["iterations"].as<int>();
 
       if (g_numthreads<1 || g_iterations < 1)
-      {  
+      {
          std::cout << "numthreads must be >1 and iterations must be >1\n";
          bError = true;
       }
    }
-   
+
+   if (vm.count("numfiles"))
+   {
+      numfiles = vm["numfiles"].as<int>();
+      if (numfiles < 1)
+      {
+         bError = true;
+      }
+   }
+
+   if (vm.count("lockmode"))
+   {
+      std::string sLockMode = vm["lockmode"].as<std::string>();
+      if (sLockMode == "advisory")
+      {
+         eLockMode = LOCKMODE_ADVISORY;
+      }
+      else if (sLockMode == "file")
+      {
+         eLockMode = LOCKMODE_LOCKFILE;
+      }
+      else
+      {
+         bError = true;
+      }
+   }
+
    if (!FileSystem::DirExists(g_sPath))
    {
       std::cout << "path " << g_sPath << " doesn't exist\n";
       bError = true;
    }
 
-  
+
    //---------------------------------------------------------------------------
    if (bError)
    {
@@ -138,22 +240,22 @@ int main(int argc, char *argv[])
    }
    //---------------------------------------------------------------------------
 
-   g_sLockFile = FilenameUtils::DelimitPath(g_sPath) + "locktest.txt";
-
    std::cout << "Running test\n";
    std::cout << "number of threads     : " << g_numthreads << "\n";
    std::cout << "number of iterations  : " << g_iterations << "\n";
+   std::cout << "number of files       : " << numfiles << "\n";
    std::cout << "path                  : " << g_sPath << "\n";
 
-   boost::thread_group  threads;
+   // the lock mode can't be changed once a file was locked, 
+   // run the test once per mode.
+   bool bOk = runtest(eLockMode, numfiles);
 
-   for (int i=0;i<g_numthreads;++i)
+   if (!bOk)
    {
-      threads.create_thread(threadfunc);
+      std::cout << "FAILED. Lock mechanism doesn't work on this file system.\n";
+      return 1;
    }
 
-   threads.join_all();
-   
    std::cout << "OK. All threads finished on this computer.\n";
 
    return 0;
@@ -22,6 +22,7 @@
 
 #include "resample.h"
 #include "resample_elevation.h"
+#include "resample_pointcloud.h"
 #include "geo/ElevationLayerSettings.h"
 #include "geo/PointLayerSettings.h"
 #include "geo/PointMap.h"
@@ -43,9 +44,13 @@ int main(int argc, char *argv[])
        ("layer", po::value<std::string>(), "image layer to resample")
        ("type", po::value<std::string>(), "[optional] image (default) or raw or elevation, or point.")
        ("maxpoints", po::value<int>(), "[optional] for elevation layer: max number of points per tile. Default is 512.")
+       ("format", po::value<std::string>(), "[optional] for elevation layer: terrain tile format json, binary or both. Default is json.")
+       ("pointgrid", po::value<int>(), "[optional] for point layer: number of grid cells per voxel axis used for thinning (even number). Default is 64.")
        ("numthreads", po::value<int>(), "force number of threads")
        ("verbose", "optional info")
        ("pointfile", "generate file with thinned out points")
+       ("png-level", po::value<int>(), "[optional] png compression level: 0 (fastest) to 9 (smallest). Default is taken from layer settings")
+       ("png-filter", po::value<std::string>(), "[optional] png filter: none, sub, up, average, paeth or adaptive. Default is taken from layer settings")
        ;
 
    po::variables_map vm;
@@ -78,8 +83,12 @@ int main(int argc, char *argv[])
    bool bVerbose = false;
    int layertype = 0; // 0: image, 1:elevation, 2: point
    int nMaxpoints = 512;
+   int nPointGrid = 64;
+   ETerrainFormat eTerrainFormat = TERRAINFORMAT_JSON;
    bool bPointfile = false;
    bool bRaw = false;
+   int nPNGLevel = -1;
+   std::string sPNGFilter;
 
 
    try
@@ -152,12 +161,48 @@ int main(int argc, char *argv[])
       }
    }
 
+   if (vm.count("format"))
+   {
+      if (!ElevationTile::GetTerrainFormat(vm["format"].as<std::string>(), eTerrainFormat))
+      {
+         bError = true;
+      }
+   }
+
+   if (vm.count("pointgrid"))
+   {
+      nPointGrid = vm["pointgrid"].as<int>();
+      if (nPointGrid < 2 || nPointGrid > 1024 || nPointGrid % 2 != 0)
+      {
+         bError = true;
+      }
+   }
+
    if (vm.count("pointfile"))
    {
       std::cout << "writing pointfile\n";
       bPointfile = true;
    }
 
+   if (vm.count("png-level"))
+   {
+      nPNGLevel = vm["png-level"].as<int>();
+      if (nPNGLevel < 0 || nPNGLevel > 9)
+      {
+         bError = true;
+      }
+   }
+
+   if (vm.count("png-filter"))
+   {
+      sPNGFilter = vm["png-filter"].as<std::string>();
+      PNGSettings oTest;
+      if (!oTest.SetFilter(sPNGFilter))
+      {
+         bError = true;
+      }
+   }
+
    //---------------------------------------------------------------------------
    if (bError)
    {
@@ -185,6 +230,22 @@ int main(int argc, char *argv[])
          return ERROR_IMAGELAYERSETTINGS;
       }
 
+      // png settings of layer, command line overrides layer settings
+      PNGSettings oPNGSettings;
+      if (!qImageLayerSettings->GetPNGSettings(oPNGSettings))
+      {
+         qLogger->Warn("Unknown png filter in layer settings, using default filter.");
+      }
+      if (nPNGLevel >= 0)
+      {
+         oPNGSettings.nLevel = nPNGLevel;
+      }
+      if (sPNGFilter.length() > 0)
+      {
+         oPNGSettings.SetFilter(sPNGFilter);
+      }
+      ImageWriter::SetPNGSettings(oPNGSettings);
+
       clock_t t0,t1;
       t0 = clock();
 
@@ -279,6 +340,7 @@ int main(int argc, char *argv[])
 
       std::string qc0 = qQuadtree->TileCoordToQuadkey(tx0, ty0, maxlod);
       std::string qc1 = qQuadtree->TileCoordToQuadkey(tx1, ty1, maxlod);
+      int nFailed = 0;  // number of tiles which couldn't be written
 
       for (int nLevelOfDetail = maxlod - 1; nLevelOfDetail>0; nLevelOfDetail--)
       {
@@ -298,9 +360,21 @@ int main(int argc, char *argv[])
          {
             for (int64 x=tx0;x<=tx1;x++)
             {
-               _resampleElevationFromParent(qQuadtree, x, y, nLevelOfDetail, sTileDir, sTempTileDir, nMaxpoints);
+               if (!_resampleElevationFromParent(qQuadtree, x, y, nLevelOfDetail, sTileDir, sTempTileDir, nMaxpoints, eTerrainFormat))
+               {
+#                 pragma omp atomic
+                  nFailed++;
+               }
             }
          }
+
+         if (nFailed > 0)
+         {
+            std::ostringstream oss;
+            oss << "Failed writing " << nFailed << " tiles!";
+            qLogger->Error(oss.str());
+            return 11;
+         }
       }
 
       t1=clock();
@@ -317,8 +391,6 @@ int main(int argc, char *argv[])
       std::string sTileDir = FilenameUtils::DelimitPath(FilenameUtils::DelimitPath(sPointLayerDir) + "tiles");
       std::string sPointFileXYZ = FilenameUtils::DelimitPath(FilenameUtils::DelimitPath(sPointLayerDir)) + "allpoints.xyz";
 
-      bPointfile = true;
-      
       boost::shared_ptr<PointLayerSettings> qPointLayerSettings = PointLayerSettings::Load(sPointLayerDir);
       if (!qPointLayerSettings)
       {
@@ -326,129 +398,131 @@ int main(int argc, char *argv[])
          return 6;
       }
 
-      // ascii pointfile
-      std::ofstream pointfile;
-      
-      if (bPointfile)
+      int maxlod = qPointLayerSettings->GetMaxLod();
+
+      if (bVerbose)
       {
-         pointfile.open(sPointFileXYZ);
-         pointfile.precision(17);
+         std::ostringstream oss;
+         oss << "\nResample Setup (Point Layer):\n";
+         oss << "     name = " << qPointLayerSettings->GetLayerName() << "\n";
+         oss << "   maxlod = " << maxlod << "\n";
+         oss << "     grid = " << nPointGrid << "\n";
+         qLogger->Info(oss.str());
       }
 
-      int lod = qPointLayerSettings->GetMaxLod();
-
-
-      std::set<int64> indices;
+      clock_t t0,t1;
+      t0 = clock();
 
       std::vector<std::string> sIndexFiles = FileSystem::GetFilesInDirectory(sTempIndexDir, "idx");
 
- 
-      int64 dpow;
-      int64 pow;
-
-      pow = int64(1) << lod; 
-      dpow = pow * pow;
-      
-      // A) create voxels @ maxlod
-
-      PointMap pm(lod);
+      // voxels @ maxlod (created by ogAddData)
+      boost::shared_ptr<PointMap> qChildren(new PointMap(maxlod));
+      qChildren->ImportIndex(sIndexFiles);
 
-      pm.ImportIndex(sIndexFiles);
-
-      //std::set<int64>::iterator it = indices.begin();
-      int64 key;
-      while (pm.GetNextIndex(key))
+      if (bPointfile)
       {
-         int64 i,j,k;
+         // ascii pointfile: mean point of every voxel @ maxlod
+         std::ofstream pointfile;
+         pointfile.open(sPointFileXYZ.c_str());
 
-         // convert key -> octree coord (i,j,k)
-         k = key / dpow;
-         j = (key - dpow*k) / pow;
-         i = key - dpow*k - j*pow;
+         std::vector<CloudPoint> vPoints;
+         int64 key;
+         while (qChildren->GetNextIndex(key))
+         {
+            PointVoxelFile::Read(qChildren->GetFilename(sTempTileDir, key), vPoints);
 
-         // Filename:
-         std::ostringstream oss;
-         oss << sTempTileDir << lod << "/" << i << "/" << j << "-" << k << ".dat";
-         std::string sFilename = oss.str();
+            double numPointsd(vPoints.size());
+            double mx = 0, my = 0, mz = 0;
+            double mr = 0, mg = 0, mb = 0;
 
-         std::ifstream ifs(sFilename.c_str(), std::ios::binary);
-         if (ifs.good())
-         {
-            size_t filesize = 0;
-            size_t current_position = ifs.tellg();
-            ifs.seekg(0, std::ios::end);
-            filesize = ifs.tellg();
-            ifs.seekg(current_position);
-
-            int64 numPoints = filesize / sizeof(CloudPoint);
-            double numPointsd(numPoints);
-            CloudPoint pt;
-            CloudPoint median;
-            double mr = 0;
-            double mg = 0;
-            double mb = 0;
-
-            for (int s=0;s<numPoints;s++)
+            for (size_t s=0;s<vPoints.size();s++)
             {
-               ifs.read((char*)&pt.x, sizeof(double));
-               ifs.read((char*)&pt.y, sizeof(double));
-               ifs.read((char*)&pt.elevation, sizeof(double));
-               ifs.read((char*)&pt.r, sizeof(unsigned char));
-               ifs.read((char*)&pt.g, sizeof(unsigned char));
-               ifs.read((char*)&pt.b, sizeof(unsigned char));
-               ifs.read((char*)&pt.intensity, sizeof(int));
-
+               const CloudPoint& pt = vPoints[s];
                mr += pt.r / 255.0 / numPointsd;
                mg += pt.g / 255.0 / numPointsd;
                mb += pt.b / 255.0 / numPointsd;
-               median.intensity += pt.intensity / numPointsd;
-
-               median.x += pt.x / numPointsd;
-               median.y += pt.y / numPointsd;
-               median.elevation += pt.elevation / numPointsd;
+               mx += pt.x / numPointsd;
+               my += pt.y / numPointsd;
+               mz += pt.elevation / numPointsd;
             }
 
-            if (bPointfile && numPoints>0)
+            if (vPoints.size()>0)
             {
                pointfile.precision(17);
-               pointfile << (median.x-0.5)*OCTREE_CUBE_SIZE << "," << (median.y-0.5)*OCTREE_CUBE_SIZE << "," << (median.elevation-0.5)*OCTREE_CUBE_SIZE << ",";
-                pointfile.precision(3);
-               //pointfile          << int(mr*255.0) << "," << int(mg*255.0) << "," << int(mb*255.0) << "\n";
-               pointfile          << mr << "," << mg << "," << mb << ",1," << "\n";
-
+               pointfile << (mx-0.5)*OCTREE_CUBE_SIZE << "," << (my-0.5)*OCTREE_CUBE_SIZE << "," << (mz-0.5)*OCTREE_CUBE_SIZE << ",";
+               pointfile.precision(3);
+               pointfile << mr << "," << mg << "," << mb << ",1," << "\n";
             }
          }
 
+         pointfile.close();
+      }
 
-         ifs.close();
-
+      // voxels @ maxlod are written to temp/tiles by ogAddData, copy them to tiles/maxlod: all levels are read from tiles/lod.
+      {
+         std::ostringstream oss;
+         oss << "Copying Level of Detail " << maxlod;
+         qLogger->Info(oss.str());
 
-         // #todo: create voxel from the data in "sFilename"
+         std::ostringstream ossLevelDir;
+         ossLevelDir << sTileDir << maxlod;
+         if (FileSystem::DirExists(ossLevelDir.str()))
+         {
+            FileSystem::rm_all(ossLevelDir.str());
+         }
 
+         int64 key;
+         while (qChildren->GetNextIndex(key))
+         {
+            std::string sFilename = qChildren->GetFilename(sTileDir, key);
+            FileSystem::makeallsubdirs(sFilename);
+            if (!FileSystem::copy(qChildren->GetFilename(sTempTileDir, key), sFilename))
+            {
+               qLogger->Error("Failed copying point voxel " + sFilename);
+               return 11;
+            }
+         }
       }
 
-      if (bPointfile)
+      // create voxels for remaining lods (bottom-up), every level is created from the level below.
+      for (int nLevelOfDetail = maxlod - 1; nLevelOfDetail>=0; nLevelOfDetail--)
       {
-         pointfile.close();
+         std::ostringstream oss;
+         oss << "Processing Level of Detail " << nLevelOfDetail;
+         qLogger->Info(oss.str());
+
+         // voxels are appended: remove results of a previous run
+         std::ostringstream ossLevelDir;
+         ossLevelDir << sTileDir << nLevelOfDetail;
+         if (FileSystem::DirExists(ossLevelDir.str()))
+         {
+            FileSystem::rm_all(ossLevelDir.str());
+         }
+
+         boost::shared_ptr<PointMap> qParent(new PointMap(nLevelOfDetail));
+         qParent->SetFileLocking(false);  // this process is the only writer of the level
+
+         int64 numpts = _resamplePointCloudFromParent(*qChildren, *qParent, nLevelOfDetail, sTileDir, sTileDir, nPointGrid);
+         if (numpts < 0)
+         {
+            qLogger->Error("Failed writing point voxels!");
+            return 11;
+         }
+
+         if (bVerbose)
+         {
+            std::ostringstream oss;
+            oss << "   voxels = " << qParent->GetIndexSize() << ", points = " << numpts;
+            qLogger->Info(oss.str());
+         }
+
+         qChildren = qParent;
       }
 
-      // B) create voxels for remaining lods
-      // #todo: lod calc
-      /*it = indices.begin();
-      while (it != indices.end())
-      {
-         int64 i,j,k;
-         int64 key = *it;
-         // convert key -> octree coord (i,j,k)
-         k = key / dpow;
-         j = (key - dpow*k) / pow;
-         i = key - dpow*k - j*pow;
-
-         std::string sOctocode = Octocode::IndexToOctocode(i,j,k,lod);
-         std::string sParent = Octocode::GetParent(sOctocode);
-
-         it++;
-      }*/
+      t1=clock();
+      std::ostringstream out;
+      out << "calculated in: " << double(t1-t0)/double(CLOCKS_PER_SEC) << " s \n";
+      qLogger->Info(out.str());
    }
 #endif
 
@@ -1,5 +1,7 @@
 
 #include "resample.h"
+#include "image/ImageDownsample.h"
+#include <algorithm>
 #include <omp.h>
 
 //------------------------------------------------------------------------------
@@ -57,130 +59,28 @@ void _resampleFromParent( TileBlock* pTileBlockArray, boost::shared_ptr<Mercator
       qQuadtree->QuadKeyToTileCoord(qc3, _tx, _ty, tmp_lod);
       std::string sTilefile3 = ProcessingUtils::GetTilePath(sTileDir, ".png" , tmp_lod, _tx, _ty);
 
-      ImageObject IH0, IH1, IH2, IH3;
-
-      bool b0 = ImageLoader::LoadFromDisk(Img::Format_PNG, sTilefile0, Img::PixelFormat_RGBA, IH0);
-      bool b1 = ImageLoader::LoadFromDisk(Img::Format_PNG, sTilefile1, Img::PixelFormat_RGBA, IH1);
-      bool b2 = ImageLoader::LoadFromDisk(Img::Format_PNG, sTilefile2, Img::PixelFormat_RGBA, IH2);
-      bool b3 = ImageLoader::LoadFromDisk(Img::Format_PNG, sTilefile3, Img::PixelFormat_RGBA, IH3);
-
-      unsigned char* p0 = IH0.GetRawData().get();
-      unsigned char* p1 = IH1.GetRawData().get();
-      unsigned char* p2 = IH2.GetRawData().get();
-      unsigned char* p3 = IH3.GetRawData().get();
-
-      unsigned char cr;
-      unsigned char cg;
-      unsigned char cb;
-      unsigned char ca;
-
-      for (int y=0;y<tilesize;y++)
-      {
-         for (int x=0;x<tilesize;x++)
-         {
-            size_t adr = 4*y*tilesize+4*x;
-
-            if (y<tilesize/2)
-            {
-               if (x<tilesize/2)
-               {
-                  // A
-                  if (p0)
-                  {
-                     int x0 = 2*x;
-                     int y0 = 2*y; 
-                     int x1 = x0+1;
-                     int y1 = y0+1;
-
-                     size_t tileadr0 = 4*y0*tilesize+4*x0;
-                     size_t tileadr1 = 4*y0*tilesize+4*x1;
-                     size_t tileadr2 = 4*y1*tilesize+4*x0;
-                     size_t tileadr3 = 4*y1*tilesize+4*x1;
-
-                     _getInterpolatedColor(p0, tileadr0, tileadr1, tileadr2, tileadr3, &cr, &cg, &cb, &ca);
-                  }
-                  else
-                  {
-                     cr = cg = cb = ca = 0;
-                  }
-               }
-               else
-               {
-                  // B 
-                  if (p1)
-                  {
-                     int x0 = 2*(x-tilesize/2);
-                     int y0 = 2*y; 
-                     int x1 = x0+1;
-                     int y1 = y0+1;
-
-                     size_t tileadr0 = 4*y0*tilesize+4*x0;
-                     size_t tileadr1 = 4*y0*tilesize+4*x1;
-                     size_t tileadr2 = 4*y1*tilesize+4*x0;
-                     size_t tileadr3 = 4*y1*tilesize+4*x1;
-
-                     _getInterpolatedColor(p1, tileadr0, tileadr1, tileadr2, tileadr3, &cr, &cg, &cb, &ca);
-                  }
-                  else
-                  {
-                     cr = cg = cb = ca = 0;
-                  }
-               }
-            }
-            else
-            {
-               if (x<tilesize/2)
-               {
-                  // C
-                  if (p2)
-                  {
-                     int x0 = 2*x;
-                     int y0 = 2*(y-tilesize/2); 
-                     int x1 = x0+1;
-                     int y1 = y0+1;
-
-                     size_t tileadr0 = 4*y0*tilesize+4*x0;
-                     size_t tileadr1 = 4*y0*tilesize+4*x1;
-                     size_t tileadr2 = 4*y1*tilesize+4*x0;
-                     size_t tileadr3 = 4*y1*tilesize+4*x1;
-
-                     _getInterpolatedColor(p2, tileadr0, tileadr1, tileadr2, tileadr3, &cr, &cg, &cb, &ca);
-                  }
-                  else
-                  {
-                     cr = cg = cb = ca = 0;
-                  }
-               }
-               else
-               {
-                  // D 
-                  if (p3)
-                  {
-                     int x0 = 2*(x-tilesize/2); 
-                     int y0 = 2*(y-tilesize/2); 
-                     int x1 = x0+1;
-                     int y1 = y0+1;
-
-                     size_t tileadr0 = 4*y0*tilesize+4*x0;
-                     size_t tileadr1 = 4*y0*tilesize+4*x1;
-                     size_t tileadr2 = 4*y1*tilesize+4*x0;
-                     size_t tileadr3 = 4*y1*tilesize+4*x1;
-
-                     _getInterpolatedColor(p3, tileadr0, tileadr1, tileadr2, tileadr3, &cr, &cg, &cb, &ca);
-                  }
-                  else
-                  {
-                     cr = cg = cb = ca = 0;
-                  }
-               }
-            }
-
-            tile.tile[adr+0] = cr;
-            tile.tile[adr+1] = cg;
-            tile.tile[adr+2] = cb;
-            tile.tile[adr+3] = ca;
-         }
-      }
+      ImageObject& IH0 = tile.children[0];
+      ImageObject& IH1 = tile.children[1];
+      ImageObject& IH2 = tile.children[2];
+      ImageObject& IH3 = tile.children[3];
+
+      bool b0 = tile.decoder.LoadFromDisk(sTilefile0, Img::PixelFormat_RGBA, IH0) && IH0.GetWidth() == tilesize && IH0.GetHeight() == tilesize;
+      bool b1 = tile.decoder.LoadFromDisk(sTilefile1, Img::PixelFormat_RGBA, IH1) && IH1.GetWidth() == tilesize && IH1.GetHeight() == tilesize;
+      bool b2 = tile.decoder.LoadFromDisk(sTilefile2, Img::PixelFormat_RGBA, IH2) && IH2.GetWidth() == tilesize && IH2.GetHeight() == tilesize;
+      bool b3 = tile.decoder.LoadFromDisk(sTilefile3, Img::PixelFormat_RGBA, IH3) && IH3.GetWidth() == tilesize && IH3.GetHeight() == tilesize;
+
+      // images are reused, after a failed load they may contain a previous tile
+      unsigned char* p0 = b0 ? IH0.GetRawData().get() : 0;
+      unsigned char* p1 = b1 ? IH1.GetRawData().get() : 0;
+      unsigned char* p2 = b2 ? IH2.GetRawData().get() : 0;
+      unsigned char* p3 = b3 ? IH3.GetRawData().get() : 0;
+
+      // each child tile is reduced to a quarter of the tile (tile was cleared to transparent)
+      const int half = tilesize/2;
+      if (p0) ImageDownsample::RGBA(p0, tilesize, tilesize, tile.tile, 4*tilesize);
+      if (p1) ImageDownsample::RGBA(p1, tilesize, tilesize, tile.tile + 4*half, 4*tilesize);
+      if (p2) ImageDownsample::RGBA(p2, tilesize, tilesize, tile.tile + 4*half*tilesize, 4*tilesize);
+      if (p3) ImageDownsample::RGBA(p3, tilesize, tilesize, tile.tile + 4*(half*tilesize+half), 4*tilesize);
 
       ImageWriter::WritePNG(sCurrentTile, tile.tile, tilesize, tilesize);
       }
@@ -216,120 +116,14 @@ void _resampleFromParent( TileBlock* pTileBlockArray, boost::shared_ptr<Mercator
    void _resampleRawImages(Raw32ImageObject* IH0, Raw32ImageObject* IH1,Raw32ImageObject* IH2,Raw32ImageObject* IH3, std::string sTargetFile, int tilesize,bool b0, bool b1, bool b2, bool b3) 
    {
 
-      float* p0 = IH0->GetRawData().get();
-      float* p1 = IH1->GetRawData().get();
-      float* p2 = IH2->GetRawData().get();
-      float* p3 = IH3->GetRawData().get();
-      
-      
-     
       boost::shared_array<float> sampleTile = boost::shared_array<float>(new float[tilesize*tilesize]);
-      memset(sampleTile.get(),0,tilesize*tilesize*sizeof(float));
-
-       
-      for (int y=0;y<tilesize;y++)
-      {
-         for (int x=0;x<tilesize;x++)
-         {
-            float cvalue = -9999.0f;
-            size_t adr = y*tilesize+x;
-
-            if (y<tilesize/2)
-            {
-               if (x<tilesize/2)
-               {
-                  // A
-                  if (b0)
-                  {
-                     int x0 = 2*x;
-                     int y0 = 2*y; 
-                     int x1 = x0+1;
-                     int y1 = y0+1;
-
-                     size_t tileadr0 = y0*tilesize+x0;
-                     size_t tileadr1 = y0*tilesize+x1;
-                     size_t tileadr2 = y1*tilesize+x0;
-                     size_t tileadr3 = y1*tilesize+x1;
+      std::fill(sampleTile.get(), sampleTile.get()+tilesize*tilesize, -9999.0f);
 
-                     _getInterpolatedRawColor(p0, tileadr0, tileadr1, tileadr2, tileadr3, &cvalue);
-                  }
-                  else
-                  {
-                     cvalue = -9999.0f;
-                  }
-               }
-               else
-               {
-                  // B 
-                  if (b1)
-                  {
-                     int x0 = 2*(x-tilesize/2);
-                     int y0 = 2*y; 
-                     int x1 = x0+1;
-                     int y1 = y0+1;
+      const int half = tilesize/2;
+      if (b0) ImageDownsample::Raw32(IH0->GetRawData().get(), tilesize, tilesize, sampleTile.get(), tilesize, -9999.0f);
+      if (b1) ImageDownsample::Raw32(IH1->GetRawData().get(), tilesize, tilesize, sampleTile.get() + half, tilesize, -9999.0f);
+      if (b2) ImageDownsample::Raw32(IH2->GetRawData().get(), tilesize, tilesize, sampleTile.get() + half*tilesize, tilesize, -9999.0f);
+      if (b3) ImageDownsample::Raw32(IH3->GetRawData().get(), tilesize, tilesize, sampleTile.get() + half*tilesize+half, tilesize, -9999.0f);
 
-                     size_t tileadr0 = y0*tilesize+x0;
-                     size_t tileadr1 = y0*tilesize+x1;
-                     size_t tileadr2 = y1*tilesize+x0;
-                     size_t tileadr3 = y1*tilesize+x1;
-
-                     _getInterpolatedRawColor(p1, tileadr0, tileadr1, tileadr2, tileadr3, &cvalue);
-                  }
-                  else
-                  {
-                     cvalue = -9999.0f;
-                  }
-               }
-            }
-            else
-            {
-               if (x<tilesize/2)
-               {
-                  // C
-                  if (b2)
-                  {
-                     int x0 = 2*x;
-                     int y0 = 2*(y-tilesize/2); 
-                     int x1 = x0+1;
-                     int y1 = y0+1;
-
-                     size_t tileadr0 = y0*tilesize+x0;
-                     size_t tileadr1 = y0*tilesize+x1;
-                     size_t tileadr2 = y1*tilesize+x0;
-                     size_t tileadr3 = y1*tilesize+x1;
-
-                     _getInterpolatedRawColor(p2, tileadr0, tileadr1, tileadr2, tileadr3, &cvalue);
-                  }
-                  else
-                  {
-                     cvalue = -9999.0f;
-                  }
-               }
-               else
-               {
-                  // D 
-                  if (b3)
-                  {
-                     int x0 = 2*(x-tilesize/2); 
-                     int y0 = 2*(y-tilesize/2); 
-                     int x1 = x0+1;
-                     int y1 = y0+1;
-
-                     size_t tileadr0 = y0*tilesize+x0;
-                     size_t tileadr1 = y0*tilesize+x1;
-                     size_t tileadr2 = y1*tilesize+x0;
-                     size_t tileadr3 = y1*tilesize+x1;
-
-                     _getInterpolatedRawColor(p3, tileadr0, tileadr1, tileadr2, tileadr3, &cvalue);
-                  }
-                  else
-                  {
-                     cvalue = -9999.0f;
-                  }
-               }
-            }
-           sampleTile[adr] = cvalue;
-         }
-      }
       ImageWriter::WriteRaw32(sTargetFile,tilesize, tilesize, sampleTile.get());
    }
\ No newline at end of file
@@ -31,8 +31,33 @@
 #include <sstream>
 #include <iostream>
 #include <sstream>
+#include <boost/thread/tss.hpp>
 
-void _resampleElevationFromParent(boost::shared_ptr<MercatorQuadtree> qQuadtree, int64 x, int64 y,int nLevelOfDetail, std::string sTileDir, std::string sTempTileDir, int nMaxpoints)
+namespace
+{
+   boost::thread_specific_ptr<std::string> s_pJSONBuffer;
+   boost::thread_specific_ptr<std::string> s_pBinaryBuffer;
+
+   //---------------------------------------------------------------------------
+   // Write tile. An incomplete file is removed, returns false on error.
+   inline bool WriteTileFile(const std::string& sFilename, const std::string& sData, bool bBinary)
+   {
+      std::ofstream fout(sFilename.c_str(), bBinary ? (std::ios::out | std::ios::binary) : std::ios::out);
+      fout.write(sData.data(), sData.size());
+      fout.close();
+
+      if (fout.fail())
+      {
+         std::cout << "ERROR: can't write " << sFilename << "\n";
+         FileSystem::rm(sFilename);
+         return false;
+      }
+
+      return true;
+   }
+}
+
+bool _resampleElevationFromParent(boost::shared_ptr<MercatorQuadtree> qQuadtree, int64 x, int64 y,int nLevelOfDetail, std::string sTileDir, std::string sTempTileDir, int nMaxpoints, ETerrainFormat eFormat)
 {
    // current tile:
    std::string qcCurrent = qQuadtree->TileCoordToQuadkey(x,y,nLevelOfDetail);
@@ -50,6 +75,7 @@ void _resampleElevationFromParent(boost::shared_ptr<MercatorQuadtree> qQuadtree,
    qQuadtree->QuadKeyToTileCoord(qcCurrent, _tx, _ty, tmp_lod);
    std::string sCurrentTile_binary = ProcessingUtils::GetTilePath(sTempTileDir, ".tri" , tmp_lod, _tx, _ty);
    std::string sCurrentTile_json = ProcessingUtils::GetTilePath(sTileDir, ".json" , tmp_lod, _tx, _ty);
+   std::string sCurrentTile_ogt = ProcessingUtils::GetTilePath(sTileDir, ".ogt" , tmp_lod, _tx, _ty);
 
    qQuadtree->QuadKeyToTileCoord(qc0, _tx, _ty, tmp_lod);
    std::string sTilefile0_binary = ProcessingUtils::GetTilePath(sTempTileDir, ".tri" , tmp_lod, _tx, _ty);
@@ -95,13 +121,36 @@ void _resampleElevationFromParent(boost::shared_ptr<MercatorQuadtree> qQuadtree,
    
    etCurrent.Reduce(nMaxpoints);
    
-   etCurrent.WriteBinary(sCurrentTile_binary);
+   bool bOk = true;
+   if (!etCurrent.WriteBinary(sCurrentTile_binary))
+   {
+      std::cout << "ERROR: can't write " << sCurrentTile_binary << "\n";
+      bOk = false;
+   }
    
-   std::string datastr = etCurrent.CreateJSON();
-
-   std::ofstream fout(sCurrentTile_json.c_str());
-   fout << datastr;
-   fout.close();
-
+   // Tiles are created in buffers of the current thread, which are reused for all tiles
+   if (!s_pJSONBuffer.get())
+   {
+      s_pJSONBuffer.reset(new std::string());
+   }
+   if (!s_pBinaryBuffer.get())
+   {
+      s_pBinaryBuffer.reset(new std::string());
+   }
+   std::string& datastr = *s_pJSONBuffer;
+   std::string& binarydata = *s_pBinaryBuffer;
+   etCurrent.CreateTerrain(eFormat, datastr, binarydata);
+
+   if (eFormat & TERRAINFORMAT_JSON)
+   {
+      bOk = WriteTileFile(sCurrentTile_json, datastr, false) && bOk;
+   }
+
+   if (eFormat & TERRAINFORMAT_BINARY)
+   {
+      bOk = WriteTileFile(sCurrentTile_ogt, binarydata, true) && bOk;
+   }
+
+   return bOk;
 }
 
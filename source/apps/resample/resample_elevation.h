@@ -22,9 +22,12 @@
 #include "og.h"
 #include "app/ProcessingSettings.h"
 #include "geo/MercatorQuadtree.h"
+#include "geo/ElevationTile.h"
 #include <string>
 
-void _resampleElevationFromParent(boost::shared_ptr<MercatorQuadtree> qQuadtree, int64 x, int64 y,int nLevelOfDetail, std::string sTileDir, std::string sTempTileDir, int nMaxpoints);
+// Create elevation tile (x,y) of level nLevelOfDetail from the 4 tiles of the level below.
+// Returns false if a tile couldn't be written.
+bool _resampleElevationFromParent(boost::shared_ptr<MercatorQuadtree> qQuadtree, int64 x, int64 y,int nLevelOfDetail, std::string sTileDir, std::string sTempTileDir, int nMaxpoints, ETerrainFormat eFormat = TERRAINFORMAT_JSON);
 
 
 
@@ -18,14 +18,210 @@
 
 #include "resample_pointcloud.h"
 #include "ogprocess.h"
+#include "math/mathutils.h"
 
 #include <iostream>
 #include <fstream>
 #include <boost/shared_ptr.hpp>
 #include <sstream>
-#include <iostream>
-#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
 
-void _resamplePointCloudFromParent(int64 x, int64 y, int64 z, int nLevelOfDetail, std::string sTileDir, std::string sTempTileDir)
+#ifdef _USE_POINTS
+
+namespace
 {
-}
\ No newline at end of file
+   const int childbatch = 128; // number of child voxels thinned at once (in parallel)
+   const size_t emptycell = size_t(-1);   // marks empty slot of the cell hash table
+
+   //---------------------------------------------------------------------------
+   // Grid thinning of one child voxel. A child covers half^3 cells of the
+   // parent grid, so the children of a parent never share a cell and can be
+   // thinned independently. Only cells containing points are stored (hash
+   // table), memory depends on the number of points and not on the grid.
+
+   class VoxelThinning
+   {
+   public:
+      VoxelThinning(int nGrid)
+         : _half(nGrid/2)
+      {
+      }
+
+      //------------------------------------------------------------------------
+      // res: number of cells along the whole octree axis at parent level
+      void Thin(const std::vector<CloudPoint>& vPoints, int64 ci, int64 cj, int64 ck, double res, std::vector<CloudPoint>& vResult)
+      {
+         vResult.clear();
+         _vCells.clear();
+
+         // open addressing, at least twice as many slots as points. Memory is kept for the next voxel.
+         size_t nSlots = 16;
+         while (nSlots < 2*vPoints.size())
+         {
+            nSlots *= 2;
+         }
+         _vSlotCell.assign(nSlots, emptycell);
+         _vSlotPoint.resize(nSlots);
+         _vSlotDist.resize(nSlots);
+         size_t mask = nSlots-1;
+
+         for (size_t n=0;n<vPoints.size();n++)
+         {
+            const CloudPoint& pt = vPoints[n];
+            double fx = pt.x * res - double(ci*_half);
+            double fy = pt.y * res - double(cj*_half);
+            double fz = pt.elevation * res - double(ck*_half);
+            int cx = math::Clamp<int>(int(floor(fx)), 0, _half-1);
+            int cy = math::Clamp<int>(int(floor(fy)), 0, _half-1);
+            int cz = math::Clamp<int>(int(floor(fz)), 0, _half-1);
+            double dx = fx - (cx + 0.5);
+            double dy = fy - (cy + 0.5);
+            double dz = fz - (cz + 0.5);
+            double dist = dx*dx + dy*dy + dz*dz;
+
+            size_t cell = (size_t(cz)*_half + cy)*_half + cx;
+            size_t s = _Hash(cell) & mask;
+            while (_vSlotCell[s] != emptycell && _vSlotCell[s] != cell)
+            {
+               s = (s+1) & mask;  // linear probing
+            }
+
+            if (_vSlotCell[s] == emptycell)
+            {
+               _vSlotCell[s] = cell;
+               _vSlotPoint[s] = n;
+               _vSlotDist[s] = dist;
+               _vCells.push_back(std::make_pair(cell, s));
+            }
+            else if (dist < _vSlotDist[s])
+            {
+               _vSlotPoint[s] = n;
+               _vSlotDist[s] = dist;
+            }
+         }
+
+         // output in cell order, result doesn't depend on point order in file (except for equal distances)
+         std::sort(_vCells.begin(), _vCells.end());
+         vResult.reserve(_vCells.size());
+         for (size_t c=0;c<_vCells.size();c++)
+         {
+            vResult.push_back(vPoints[_vSlotPoint[_vCells[c].second]]);
+         }
+      }
+
+   protected:
+      static size_t _Hash(size_t cell)
+      {
+         uint64 h = uint64(cell);
+         h ^= h >> 33;
+         h *= 0xff51afd7ed558ccdULL;
+         h ^= h >> 33;
+         return size_t(h);
+      }
+
+      int                  _half;
+      std::vector<size_t>  _vSlotCell;   // hash table: cell of slot, emptycell if slot is empty
+      std::vector<size_t>  _vSlotPoint;  // hash table: index of point closest to cell center
+      std::vector<double>  _vSlotDist;   // hash table: squared distance of point to cell center
+      std::vector<std::pair<size_t, size_t> > _vCells;   // non empty cells (cell, slot)
+   };
+}
+
+//------------------------------------------------------------------------------
+
+int64 _resamplePointCloudFromParent(PointMap& pmChildren, PointMap& pmParent, int nLevelOfDetail, std::string sChildDir, std::string sTileDir, int nGrid)
+{
+   int64 numpts = 0;
+   double res = double(int64(1) << nLevelOfDetail) * double(nGrid);
+
+   std::vector<int64> vKeys;
+   std::vector<std::vector<CloudPoint> > vResult(childbatch);
+   std::vector<unsigned int> vAttributes(childbatch);
+   vKeys.reserve(childbatch);
+
+   // parent voxels store the attributes found in the child voxels
+   pmParent.SetAttributes(POINTATTRIB_NONE);
+
+   // thinning state and point buffer of every thread, reused for all batches
+   int nThreads = omp_get_max_threads();
+   std::vector<VoxelThinning> vThinning(nThreads, VoxelThinning(nGrid));
+   std::vector<std::vector<CloudPoint> > vThreadPoints(nThreads);
+
+   bool bMoreVoxels = true;
+   while (bMoreVoxels)
+   {
+      int64 key;
+      vKeys.clear();
+      while ((int)vKeys.size() < childbatch && (bMoreVoxels = pmChildren.GetNextIndex(key)))
+      {
+         vKeys.push_back(key);
+      }
+
+      // read and thin child voxels in parallel
+      int nVoxels = (int)vKeys.size();
+      #pragma omp parallel for schedule(dynamic)
+      for (int v=0;v<nVoxels;v++)
+      {
+         int t = omp_get_thread_num();
+         int64 ci, cj, ck;
+         pmChildren.GetCoord(vKeys[v], ci, cj, ck);
+         vAttributes[v] = POINTATTRIB_NONE;
+         PointVoxelFile::Read(pmChildren.GetFilename(sChildDir, vKeys[v]), vThreadPoints[t], &vAttributes[v]);
+         vThinning[t].Thin(vThreadPoints[t], ci, cj, ck, res, vResult[v]);
+      }
+
+      unsigned int attributes = pmParent.GetAttributes();
+      for (int v=0;v<nVoxels;v++)
+      {
+         attributes |= vAttributes[v];
+      }
+      if (attributes != pmParent.GetAttributes())
+      {
+         numpts += pmParent.GetNumPoints();
+         if (!pmParent.ExportData(sTileDir))
+         {
+            return -1;
+         }
+         pmParent.Clear();
+         pmParent.SetAttributes(attributes);
+      }
+
+      // add thinned points to parent voxels
+      for (int v=0;v<nVoxels;v++)
+      {
+         int64 ci, cj, ck;
+         pmChildren.GetCoord(vKeys[v], ci, cj, ck);
+
+         for (size_t n=0;n<vResult[v].size();n++)
+         {
+            pmParent.AddPoint(ci >> 1, cj >> 1, ck >> 1, vResult[v][n]);
+
+            if (pmParent.IsFull())
+            {
+               numpts += pmParent.GetNumPoints();
+               if (!pmParent.ExportData(sTileDir))
+               {
+                  return -1;
+               }
+               pmParent.Clear();
+            }
+         }
+      }
+   }
+
+   numpts += pmParent.GetNumPoints();
+   if (!pmParent.ExportData(sTileDir))
+   {
+      return -1;
+   }
+   pmParent.Clear();
+
+   return numpts;
+}
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -21,9 +21,15 @@
 
 #include "og.h"
 #include "app/ProcessingSettings.h"
+#include "geo/PointMap.h"
 #include <string>
 
-void _resamplePointCloudFromParent(int64 x, int64 y, int64 z, int nLevelOfDetail, std::string sTileDir, std::string sTempTileDir);
+// Create the voxels of level nLevelOfDetail from the voxels of level nLevelOfDetail+1.
+// Every child voxel listed in the index of pmChildren is read from sChildDir and thinned
+// with a grid of nGrid^3 cells per parent voxel: the point closest to the cell center is kept.
+// The thinned points are added to pmParent and written to sTileDir, with the attributes
+// stored in the child voxels. Returns number of points written, -1 if writing failed.
+int64 _resamplePointCloudFromParent(PointMap& pmChildren, PointMap& pmParent, int nLevelOfDetail, std::string sChildDir, std::string sTileDir, int nGrid);
 
 
 
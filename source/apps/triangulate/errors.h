@@ -27,6 +27,7 @@
 #define ERROR_IMAGELAYERSETTINGS 5     // can't load imagelayersettings. (image layer probably doesn't exist)
 #define ERROR_ELVLAYERSETTINGS   6     // can't load elevsation layer settings
 #define ERROR_LOADELEVATION      10    // can't load elevation
+#define ERROR_FILE               11    // can't write tile
 #define ERROR_AREA               20    // area is too small to be processed
 
 // General Errors:
@@ -48,6 +48,7 @@ int main(int argc, char *argv[])
       ("layer", po::value<std::string>(), "name of layer to add the data")
       ("triangulate", "triangulate dataset")
       ("maxpoints", po::value<int>(), "[optional] max number of points per tile. Default is 512.")
+      ("format", po::value<std::string>(), "[optional] terrain tile format json, binary or both. Default is json.")
       ("grid", "create grid [currently unsupported, do not use!]")
       ("numthreads", po::value<int>(), "force number of threads")
       ("verbose", "verbose output")
@@ -73,6 +74,7 @@ int main(int argc, char *argv[])
    bool bGrid = false;
    bool bVerbose = false;
    int nMaxpoints = 512; // default: max 512 points per tile (including corners and edges)
+   ETerrainFormat eTerrainFormat = TERRAINFORMAT_JSON;
 
    //---------------------------------------------------------------------------
    // init options:
@@ -124,6 +126,14 @@ int main(int argc, char *argv[])
       }
    }
 
+   if (vm.count("format"))
+   {
+      if (!ElevationTile::GetTerrainFormat(vm["format"].as<std::string>(), eTerrainFormat))
+      {
+         bError = true;
+      }
+   }
+
    if (vm.count("grid"))
    {
       bGrid = true;
@@ -170,9 +180,10 @@ int main(int argc, char *argv[])
    clock_t t0,t1;
    t0 = clock();
 
+   int nResult = 0;
    if (bTriangulate)
    {
-      triangulate::process(qLogger, qSettings, nMaxpoints, sLayer, bVerbose);
+      nResult = triangulate::process(qLogger, qSettings, nMaxpoints, sLayer, bVerbose, eTerrainFormat);
    }
    else if (bGrid)
    {
@@ -186,7 +197,7 @@ int main(int argc, char *argv[])
    qLogger->Info(out.str());
 
 
-   return 0;
+   return nResult;
 }
 
 //------------------------------------------------------------------------------
@@ -26,16 +26,23 @@
 #include "math/ElevationPoint.h"
 #include "math/delaunay/DelaunayTriangulation.h"
 #include "geo/ElevationTile.h"
+#include "geo/ElevationPointFile.h"
+#include "data/LRUCache.h"
 #include "errors.h"
 #include <sstream>
 #include <fstream>
 #include <ctime>
 #include <algorithm>
+#include <utility>
 #include <omp.h>
 
 // uncomment to generate .obj instead of JSON (in temp directory)
 #define GENERATE_JSON
 
+// number of tile columns processed together. Tiles are processed row by row
+// inside a strip, so the tiles of 3 rows of a strip are reused by the 3x3 window.
+#define TRIANGULATE_STRIP_WIDTH 32
+
 namespace triangulate
 {
 
@@ -136,7 +143,55 @@ namespace triangulate
 
    //---------------------------------------------------------------------------
 
-   int process(boost::shared_ptr<Logger> qLogger, boost::shared_ptr<ProcessingSettings> qSettings, int nMaxPoints, std::string sLayer, bool bVerbose)
+   typedef boost::shared_ptr< std::vector<ElevationPoint> > PointTilePtr;
+   typedef LRUCache< std::pair<int64, int64>, PointTilePtr > PointTileCache;
+
+   // Load .pts tile. Returns an empty point list if file doesn't exist.
+   inline PointTilePtr LoadPointTile(const std::string& sTilefile)
+   {
+      PointTilePtr qPoints = PointTilePtr(new std::vector<ElevationPoint>());
+      ElevationPointFile::Read(sTilefile, *qPoints);
+      return qPoints;
+   }
+
+   //---------------------------------------------------------------------------
+
+   inline PointTilePtr GetPointTile(PointTileCache& oCache, const std::string& sTempTileDir, int lod, int64 tx, int64 ty)
+   {
+      PointTilePtr qPoints;
+      std::pair<int64, int64> key(tx, ty);
+
+      if (!oCache.Get(key, qPoints))
+      {
+         // two threads may load the same tile at the same time, this is not a problem.
+         qPoints = LoadPointTile(ProcessingUtils::GetTilePath(sTempTileDir, ".pts" , lod, tx, ty));
+         oCache.Put(key, qPoints);
+      }
+
+      return qPoints;
+   }
+
+   //---------------------------------------------------------------------------
+   // Write tile. An incomplete file is removed, returns false on error.
+   inline bool WriteTileFile(const std::string& sFilename, const std::string& sData, bool bBinary)
+   {
+      std::ofstream fout(sFilename.c_str(), bBinary ? (std::ios::out | std::ios::binary) : std::ios::out);
+      fout.write(sData.data(), sData.size());
+      fout.close();
+
+      if (fout.fail())
+      {
+         std::cout << "ERROR: can't write " << sFilename << "\n";
+         FileSystem::rm(sFilename);
+         return false;
+      }
+
+      return true;
+   }
+
+   //---------------------------------------------------------------------------
+
+   int process(boost::shared_ptr<Logger> qLogger, boost::shared_ptr<ProcessingSettings> qSettings, int nMaxPoints, std::string sLayer, bool bVerbose, ETerrainFormat eFormat)
    {
       // Retrieve ElevationLayerSettings:
       std::ostringstream oss;
@@ -200,117 +255,135 @@ namespace triangulate
          oss.str("");
       }
 
-#ifndef _DEBUG
-#     pragma omp parallel for
-#endif
-      for (int64 xx = layerTileX0+1; xx < layerTileX1; ++xx)
+      // Tiles are processed in vertical strips of TRIANGULATE_STRIP_WIDTH columns,
+      // row by row. Like this neighbour tiles are still in cache when they are reused.
+      std::vector< std::pair<int64, int64> > vecTiles;
+      for (int64 sx = layerTileX0+1; sx < layerTileX1; sx += TRIANGULATE_STRIP_WIDTH)
       {
          for (int64 yy = layerTileY0+1; yy < layerTileY1; ++yy)
          {
-            std::string sCurrentQuadcode = qQuadtree->TileCoordToQuadkey(xx,yy,lod);
+            for (int64 xx = sx; xx < layerTileX1 && xx < sx + TRIANGULATE_STRIP_WIDTH; ++xx)
+            {
+               vecTiles.push_back(std::pair<int64, int64>(xx, yy));
+            }
+         }
+      }
 
-            //std::cout << sCurrentQuadcode << "\n";
-            std::vector<ElevationPoint> vecPts;
+      // cache must hold 3 rows of a strip (+ tiles used by threads running ahead)
+      PointTileCache oTileCache(4*(TRIANGULATE_STRIP_WIDTH+2) + 9*omp_get_max_threads());
+      int nFailed = 0;  // number of tiles which couldn't be written
 
-            for (int ty=-1;ty<=1;ty++)
-            {
-               for (int tx=-1;tx<=1;tx++)
-               {
-                  std::string sQuadcode = qQuadtree->TileCoordToQuadkey(xx+tx,yy+ty,lod);
-                  std::string sTilefile = ProcessingUtils::GetTilePath(sTempTileDir, ".pts" , lod, xx+tx, yy+ty);
-                  
-                  double sx0, sy1, sx1, sy0;
-                  qQuadtree->QuadKeyToMercatorCoord(sQuadcode, sx0, sy1, sx1, sy0);
-
-
-                  //std::cout << "   " << sTilefile << "\n";
-
-                  std::ifstream fin;
-                  fin.open(sTilefile.c_str(), std::ios::binary);
-                  if (fin.good())
-                  {
-                     while (!fin.eof())
-                     {
-                        ElevationPoint pt;
-                        fin.read((char*)&(pt.x), sizeof(double));
-                        fin.read((char*)&(pt.y), sizeof(double));
-                        fin.read((char*)&(pt.elevation), sizeof(double));
-                        fin.read((char*)&(pt.weight), sizeof(double));
-                        if (!fin.eof())
-                        {
-                           vecPts.push_back(pt);
-                        }
-
-
-                     }
-                  }
-                  fin.close();
+#ifndef _DEBUG
+#     pragma omp parallel for schedule(dynamic)
+#endif
+      for (int nTile = 0; nTile < (int)vecTiles.size(); ++nTile)
+      {
+         int64 xx = vecTiles[nTile].first;
+         int64 yy = vecTiles[nTile].second;
+         std::string sCurrentQuadcode = qQuadtree->TileCoordToQuadkey(xx,yy,lod);
 
-               }
-            }
-            
-            // all points are in vecPts now -> triangulate and see if coverage is big enough
-
-            double x0,y0,x1,y1;
-            qQuadtree->QuadKeyToMercatorCoord(sCurrentQuadcode, x0, y1, x1, y0);
-            double len = fabs(y1-y0);
-            double xx0 = x0-len;
-            double xx1 = x1+len;
-            double yy0 = y0-len;
-            double yy1 = y1+len;
-
-            int cnt = 0;
-            math::DelaunayTriangulation oTriangulation(xx0,yy0,xx1,yy1);
-            math::DelaunayTriangulation oFinalTriangulation(xx0,yy0,xx1,yy1);
-            for (size_t i=0;i<vecPts.size();i++)
+         //std::cout << sCurrentQuadcode << "\n";
+         std::vector<ElevationPoint> vecPts;
+
+         for (int ty=-1;ty<=1;ty++)
+         {
+            for (int tx=-1;tx<=1;tx++)
             {
-              if (vecPts[i].x > xx0 && vecPts[i].x < xx1 &&
-                  vecPts[i].y > yy0 && vecPts[i].y < yy1)
-                  {
-                     oTriangulation.InsertPoint(vecPts[i]);
-                     cnt++;
-                  }
+               PointTilePtr qPoints = GetPointTile(oTileCache, sTempTileDir, lod, xx+tx, yy+ty);
+               vecPts.insert(vecPts.end(), qPoints->begin(), qPoints->end());
             }
+         }
+         
+         // all points are in vecPts now -> triangulate and see if coverage is big enough
+
+         double x0,y0,x1,y1;
+         qQuadtree->QuadKeyToMercatorCoord(sCurrentQuadcode, x0, y1, x1, y0);
+         double len = fabs(y1-y0);
+         double xx0 = x0-len;
+         double xx1 = x1+len;
+         double yy0 = y0-len;
+         double yy1 = y1+len;
+
+         int cnt = 0;
+         math::DelaunayTriangulation oTriangulation(xx0,yy0,xx1,yy1);
+         math::DelaunayTriangulation oFinalTriangulation(xx0,yy0,xx1,yy1);
+         std::vector<ElevationPoint> vecInsidePts;
+         vecInsidePts.reserve(vecPts.size());
+         for (size_t i=0;i<vecPts.size();i++)
+         {
+           if (vecPts[i].x > xx0 && vecPts[i].x < xx1 &&
+               vecPts[i].y > yy0 && vecPts[i].y < yy1)
+               {
+                  vecInsidePts.push_back(vecPts[i]);
+                  cnt++;
+               }
+         }
+         oTriangulation.InsertPoints(vecInsidePts);
 
-            ElevationPoint NW, NE, SE, SW;
-            std::vector<ElevationPoint> vNorth;
-            std::vector<ElevationPoint> vEast;
-            std::vector<ElevationPoint> vSouth;
-            std::vector<ElevationPoint> vWest;
-            std::vector<ElevationPoint> vMiddle;
-            oTriangulation.IntersectRect(x0,y0,x1,y1, NW, NE, SE, SW, vNorth, vEast, vSouth, vWest, vMiddle);
+         ElevationPoint NW, NE, SE, SW;
+         std::vector<ElevationPoint> vNorth;
+         std::vector<ElevationPoint> vEast;
+         std::vector<ElevationPoint> vSouth;
+         std::vector<ElevationPoint> vWest;
+         std::vector<ElevationPoint> vMiddle;
+         oTriangulation.IntersectRect(x0,y0,x1,y1, NW, NE, SE, SW, vNorth, vEast, vSouth, vWest, vMiddle);
 
-            ElevationTile oElevationTile(x0,y0,x1,y1); // elevation tile for "sCurrentQuadcode"
-            oElevationTile.Setup(NW, NE, SE, SW, vNorth, vEast, vSouth, vWest, vMiddle);
+         ElevationTile oElevationTile(x0,y0,x1,y1); // elevation tile for "sCurrentQuadcode"
+         oElevationTile.Setup(NW, NE, SE, SW, vNorth, vEast, vSouth, vWest, vMiddle);
 
-            // Thin out tile if there are too many points:
-            oElevationTile.Reduce(nMaxPoints);
+         // Thin out tile if there are too many points:
+         oElevationTile.Reduce(nMaxPoints);
 
-            std::string datastr;
-            std::string sFilename;
-            std::string sTempfilename; // for resampling info
+         std::string datastr;
+         std::string binarydata;
+         std::string sFilename;
+         std::string sTempfilename; // for resampling info
+         bool bOk = true;
 
 #ifdef GENERATE_JSON
-            //if (outputformat == JSON)
-            datastr = oElevationTile.CreateJSON();
-            sFilename = ProcessingUtils::GetTilePath(sTileDir, ".json" , lod, xx, yy);
+         //if (outputformat == JSON and/or binary)
+         oElevationTile.CreateTerrain(eFormat, datastr, binarydata);
+         sFilename = ProcessingUtils::GetTilePath(sTileDir, ".json" , lod, xx, yy);
+
+         if (eFormat & TERRAINFORMAT_BINARY)
+         {
+            std::string sBinaryFilename = ProcessingUtils::GetTilePath(sTileDir, ".ogt" , lod, xx, yy);
+            bOk = WriteTileFile(sBinaryFilename, binarydata, true) && bOk;
+         }
 #else
-            //if (outputformat == OBJ) [internal testing only]
-            datastr = oTriangulation.CreateOBJ(xmin, ymin, xmax, ymax);
-            sFilename = sTempTileDir + sCurrentQuadcode + ".obj";
+         //if (outputformat == OBJ) [internal testing only]
+         datastr = oTriangulation.CreateOBJ(xmin, ymin, xmax, ymax);
+         sFilename = sTempTileDir + sCurrentQuadcode + ".obj";
 #endif
 
-            // for binary data (resampling)
-            sTempfilename = ProcessingUtils::GetTilePath(sTempTileDir, ".tri", lod, xx, yy);
-            oElevationTile.WriteBinary(sTempfilename);
+         // for binary data (resampling)
+         sTempfilename = ProcessingUtils::GetTilePath(sTempTileDir, ".tri", lod, xx, yy);
+         if (!oElevationTile.WriteBinary(sTempfilename))
+         {
+            std::cout << "ERROR: can't write " << sTempfilename << "\n";
+            bOk = false;
+         }
+
+         // write output tile
+         if (!datastr.empty())
+         {
+            bOk = WriteTileFile(sFilename, datastr, false) && bOk;
+         }
 
-            // write output tile
-            std::ofstream fout(sFilename.c_str());
-            fout << datastr;
-            fout.close();
+         if (!bOk)
+         {
+#           pragma omp atomic
+            nFailed++;
          }
       }
 
+      if (nFailed > 0)
+      {
+         oss << "Failed writing " << nFailed << " tiles!";
+         qLogger->Error(oss.str());
+         return ERROR_FILE;
+      }
+
       return 0;
 
 
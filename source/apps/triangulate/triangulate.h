@@ -23,6 +23,7 @@
 #include "math/mathutils.h"
 #include "app/Logger.h"
 #include "app/ProcessingSettings.h"
+#include "geo/ElevationTile.h"
 #include "ogprocess.h"
 #include "errors.h"
 #include <string>
@@ -30,7 +31,7 @@
 
 namespace triangulate
 {
-   int process( boost::shared_ptr<Logger> qLogger, boost::shared_ptr<ProcessingSettings> qSettings, int nMaxPoints, std::string sLayer, bool bVerbose);
+   int process( boost::shared_ptr<Logger> qLogger, boost::shared_ptr<ProcessingSettings> qSettings, int nMaxPoints, std::string sLayer, bool bVerbose, ETerrainFormat eFormat = TERRAINFORMAT_JSON);
 }
 
 
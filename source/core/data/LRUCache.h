@@ -0,0 +1,134 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#ifndef _LRUCACHE_H
+#define _LRUCACHE_H
+
+#include <list>
+#include <map>
+#include <utility>
+#include <cstddef>
+#include <boost/thread/mutex.hpp>
+
+//------------------------------------------------------------------------------
+// Thread safe cache holding at most nCapacity elements. If the cache is full,
+// the least recently used element is removed.
+// Value should be cheap to copy (for example a boost::shared_ptr).
+
+template<typename Key, typename Value>
+class LRUCache
+{
+public:
+   LRUCache(size_t nCapacity)
+      : _nCapacity(nCapacity), _nHits(0), _nMisses(0)
+   {
+   }
+
+   virtual ~LRUCache() {}
+
+   //---------------------------------------------------------------------------
+   // Retrieve element. Returns false if element is not in cache.
+   bool Get(const Key& key, Value& value)
+   {
+      boost::mutex::scoped_lock lock(_mutex);
+
+      typename map_t::iterator it = _mapItems.find(key);
+      if (it == _mapItems.end())
+      {
+         _nMisses++;
+         return false;
+      }
+
+      // move to front (most recently used)
+      _lstItems.splice(_lstItems.begin(), _lstItems, it->second);
+      value = it->second->second;
+      _nHits++;
+      return true;
+   }
+
+   //---------------------------------------------------------------------------
+   // Add element to cache, an existing element with same key is replaced.
+   void Put(const Key& key, const Value& value)
+   {
+      boost::mutex::scoped_lock lock(_mutex);
+
+      typename map_t::iterator it = _mapItems.find(key);
+      if (it != _mapItems.end())
+      {
+         it->second->second = value;
+         _lstItems.splice(_lstItems.begin(), _lstItems, it->second);
+         return;
+      }
+
+      _lstItems.push_front(std::make_pair(key, value));
+      _mapItems[key] = _lstItems.begin();
+
+      while (_mapItems.size() > _nCapacity)
+      {
+         _mapItems.erase(_lstItems.back().first);
+         _lstItems.pop_back();
+      }
+   }
+
+   //---------------------------------------------------------------------------
+   // Remove element from cache (if it exists).
+   void Remove(const Key& key)
+   {
+      boost::mutex::scoped_lock lock(_mutex);
+
+      typename map_t::iterator it = _mapItems.find(key);
+      if (it != _mapItems.end())
+      {
+         _lstItems.erase(it->second);
+         _mapItems.erase(it);
+      }
+   }
+
+   //---------------------------------------------------------------------------
+
+   void Clear()
+   {
+      boost::mutex::scoped_lock lock(_mutex);
+      _mapItems.clear();
+      _lstItems.clear();
+   }
+
+   //---------------------------------------------------------------------------
+
+   size_t GetHits() { boost::mutex::scoped_lock lock(_mutex); return _nHits; }
+   size_t GetMisses() { boost::mutex::scoped_lock lock(_mutex); return _nMisses; }
+
+   //---------------------------------------------------------------------------
+
+protected:
+   typedef std::list<std::pair<Key, Value> > list_t;
+   typedef std::map<Key, typename list_t::iterator> map_t;
+
+   list_t         _lstItems;  // most recently used element first
+   map_t          _mapItems;
+   size_t         _nCapacity;
+   size_t         _nHits;
+   size_t         _nMisses;
+   boost::mutex   _mutex;
+
+private:
+   LRUCache(const LRUCache&);
+   LRUCache& operator=(const LRUCache&);
+};
+
+#endif
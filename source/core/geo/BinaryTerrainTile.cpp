@@ -0,0 +1,288 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include "BinaryTerrainTile.h"
+#include <cmath>
+#include <cstring>
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+   const size_t HEADERSIZE = 4 + 5*4 + 9*8 + 10*4;
+
+   //---------------------------------------------------------------------------
+   // little endian writer
+
+   inline void _WriteUInt16(std::string& s, unsigned int v)
+   {
+      s += char(v & 0xFF);
+      s += char((v >> 8) & 0xFF);
+   }
+
+   inline void _WriteUInt32(std::string& s, unsigned int v)
+   {
+      s += char(v & 0xFF);
+      s += char((v >> 8) & 0xFF);
+      s += char((v >> 16) & 0xFF);
+      s += char((v >> 24) & 0xFF);
+   }
+
+   inline void _WriteFloat(std::string& s, float f)
+   {
+      unsigned int v;
+      memcpy(&v, &f, 4);
+      _WriteUInt32(s, v);
+   }
+
+   inline void _WriteDouble(std::string& s, double d)
+   {
+      uint64 v;
+      memcpy(&v, &d, 8);
+      _WriteUInt32(s, (unsigned int)(v & 0xFFFFFFFF));
+      _WriteUInt32(s, (unsigned int)(v >> 32));
+   }
+
+   //---------------------------------------------------------------------------
+   // little endian reader
+
+   inline unsigned int _ReadUInt16(const unsigned char*& p)
+   {
+      unsigned int v = p[0] | (p[1] << 8);
+      p += 2;
+      return v;
+   }
+
+   inline unsigned int _ReadUInt32(const unsigned char*& p)
+   {
+      unsigned int v = p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+      p += 4;
+      return v;
+   }
+
+   inline float _ReadFloat(const unsigned char*& p)
+   {
+      unsigned int v = _ReadUInt32(p);
+      float f;
+      memcpy(&f, &v, 4);
+      return f;
+   }
+
+   inline double _ReadDouble(const unsigned char*& p)
+   {
+      uint64 lo = _ReadUInt32(p);
+      uint64 hi = _ReadUInt32(p);
+      uint64 v = lo | (hi << 32);
+      double d;
+      memcpy(&d, &v, 8);
+      return d;
+   }
+
+   //---------------------------------------------------------------------------
+
+   inline unsigned int _Quantize(float v, float vmin, float scale)
+   {
+      double q = floor((double(v) - double(vmin)) * scale + 0.5);
+      if (q < 0) return 0;
+      if (q > 65535) return 65535;
+      return (unsigned int)q;
+   }
+
+   inline float _Dequantize(unsigned int q, float vmin, float vmax)
+   {
+      return (float)(double(vmin) + (double(vmax) - double(vmin)) * double(q) / 65535.0);
+   }
+
+   //---------------------------------------------------------------------------
+
+   inline unsigned int _ZigZag(int v)
+   {
+      return ((unsigned int)v << 1) ^ (unsigned int)(v >> 31);
+   }
+
+   inline int _UnZigZag(unsigned int v)
+   {
+      return (int)(v >> 1) ^ -(int)(v & 1);
+   }
+}
+
+//------------------------------------------------------------------------------
+
+void BinaryTerrainTile::Encode(const vec3<float>* pVertices, const vec2<float>* pTexCoords, size_t nVertices, 
+                               const int* pIndices, size_t nIndices, 
+                               const vec3<double>& offset, const vec3<double>& bbmin, const vec3<double>& bbmax, 
+                               int curtainindex, std::string& sOut)
+{
+   // [1] quantization range
+   float posmin[3] = {0,0,0};
+   float posmax[3] = {0,0,0};
+   float texmin[2] = {0,0};
+   float texmax[2] = {0,0};
+
+   for (size_t i=0;i<nVertices;i++)
+   {
+      const float p[3] = {pVertices[i].x, pVertices[i].y, pVertices[i].z};
+      const float t[2] = {pTexCoords[i].x, pTexCoords[i].y};
+      for (int c=0;c<3;c++)
+      {
+         posmin[c] = (i==0 || p[c] < posmin[c]) ? p[c] : posmin[c];
+         posmax[c] = (i==0 || p[c] > posmax[c]) ? p[c] : posmax[c];
+      }
+      for (int c=0;c<2;c++)
+      {
+         texmin[c] = (i==0 || t[c] < texmin[c]) ? t[c] : texmin[c];
+         texmax[c] = (i==0 || t[c] > texmax[c]) ? t[c] : texmax[c];
+      }
+   }
+
+   double posscale[3], texscale[2];
+   for (int c=0;c<3;c++)
+   {
+      posscale[c] = posmax[c] > posmin[c] ? 65535.0 / (double(posmax[c]) - double(posmin[c])) : 0.0;
+   }
+   for (int c=0;c<2;c++)
+   {
+      texscale[c] = texmax[c] > texmin[c] ? 65535.0 / (double(texmax[c]) - double(texmin[c])) : 0.0;
+   }
+
+   // [2] index size: 16 bit if all zig-zag encoded differences fit
+   unsigned int flags = 0;
+   int prev = 0;
+   for (size_t i=0;i<nIndices;i++)
+   {
+      if (_ZigZag(pIndices[i] - prev) > 0xFFFF)
+      {
+         flags |= BINARYTERRAINTILE_INDEX32;
+         break;
+      }
+      prev = pIndices[i];
+   }
+
+   // [3] write
+   sOut.reserve(sOut.size() + HEADERSIZE + 10*nVertices + ((flags & BINARYTERRAINTILE_INDEX32) ? 4 : 2)*nIndices);
+
+   sOut.append("OGTB", 4);
+   _WriteUInt32(sOut, BINARYTERRAINTILE_VERSION);
+   _WriteUInt32(sOut, (unsigned int)nVertices);
+   _WriteUInt32(sOut, (unsigned int)nIndices);
+   _WriteUInt32(sOut, (unsigned int)curtainindex);
+   _WriteUInt32(sOut, flags);
+
+   _WriteDouble(sOut, offset.x); _WriteDouble(sOut, offset.y); _WriteDouble(sOut, offset.z);
+   _WriteDouble(sOut, bbmin.x);  _WriteDouble(sOut, bbmin.y);  _WriteDouble(sOut, bbmin.z);
+   _WriteDouble(sOut, bbmax.x);  _WriteDouble(sOut, bbmax.y);  _WriteDouble(sOut, bbmax.z);
+
+   for (int c=0;c<3;c++) _WriteFloat(sOut, posmin[c]);
+   for (int c=0;c<3;c++) _WriteFloat(sOut, posmax[c]);
+   for (int c=0;c<2;c++) _WriteFloat(sOut, texmin[c]);
+   for (int c=0;c<2;c++) _WriteFloat(sOut, texmax[c]);
+
+   for (size_t i=0;i<nVertices;i++)
+   {
+      _WriteUInt16(sOut, _Quantize(pVertices[i].x, posmin[0], posscale[0]));
+      _WriteUInt16(sOut, _Quantize(pVertices[i].y, posmin[1], posscale[1]));
+      _WriteUInt16(sOut, _Quantize(pVertices[i].z, posmin[2], posscale[2]));
+      _WriteUInt16(sOut, _Quantize(pTexCoords[i].x, texmin[0], texscale[0]));
+      _WriteUInt16(sOut, _Quantize(pTexCoords[i].y, texmin[1], texscale[1]));
+   }
+
+   prev = 0;
+   for (size_t i=0;i<nIndices;i++)
+   {
+      unsigned int v = _ZigZag(pIndices[i] - prev);
+      prev = pIndices[i];
+
+      if (flags & BINARYTERRAINTILE_INDEX32)
+      {
+         _WriteUInt32(sOut, v);
+      }
+      else
+      {
+         _WriteUInt16(sOut, v);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+
+void BinaryTerrainTile::Encode(const BinaryTerrainTileData& data, std::string& sOut)
+{
+   size_t nVertices = data.vertices.size();
+
+   Encode(nVertices > 0 ? &data.vertices[0] : 0, nVertices > 0 ? &data.texcoords[0] : 0, nVertices,
+          data.indices.size() > 0 ? &data.indices[0] : 0, data.indices.size(),
+          data.offset, data.bbmin, data.bbmax, data.curtainindex, sOut);
+}
+
+//------------------------------------------------------------------------------
+
+bool BinaryTerrainTile::Decode(const unsigned char* pData, size_t nSize, BinaryTerrainTileData& out)
+{
+   if (nSize < HEADERSIZE || memcmp(pData, "OGTB", 4) != 0)
+   {
+      return false;
+   }
+
+   const unsigned char* p = pData + 4;
+   unsigned int version = _ReadUInt32(p);
+   size_t nVertices = _ReadUInt32(p);
+   size_t nIndices = _ReadUInt32(p);
+   out.curtainindex = (int)_ReadUInt32(p);
+   unsigned int flags = _ReadUInt32(p);
+
+   size_t nIndexSize = (flags & BINARYTERRAINTILE_INDEX32) ? 4 : 2;
+   if (version != BINARYTERRAINTILE_VERSION || 
+       nSize < HEADERSIZE + 10*nVertices + nIndexSize*nIndices)
+   {
+      return false;
+   }
+
+   out.offset.x = _ReadDouble(p); out.offset.y = _ReadDouble(p); out.offset.z = _ReadDouble(p);
+   out.bbmin.x = _ReadDouble(p);  out.bbmin.y = _ReadDouble(p);  out.bbmin.z = _ReadDouble(p);
+   out.bbmax.x = _ReadDouble(p);  out.bbmax.y = _ReadDouble(p);  out.bbmax.z = _ReadDouble(p);
+
+   float posmin[3], posmax[3], texmin[2], texmax[2];
+   for (int c=0;c<3;c++) posmin[c] = _ReadFloat(p);
+   for (int c=0;c<3;c++) posmax[c] = _ReadFloat(p);
+   for (int c=0;c<2;c++) texmin[c] = _ReadFloat(p);
+   for (int c=0;c<2;c++) texmax[c] = _ReadFloat(p);
+
+   out.vertices.resize(nVertices);
+   out.texcoords.resize(nVertices);
+   for (size_t i=0;i<nVertices;i++)
+   {
+      out.vertices[i].x = _Dequantize(_ReadUInt16(p), posmin[0], posmax[0]);
+      out.vertices[i].y = _Dequantize(_ReadUInt16(p), posmin[1], posmax[1]);
+      out.vertices[i].z = _Dequantize(_ReadUInt16(p), posmin[2], posmax[2]);
+      out.texcoords[i].x = _Dequantize(_ReadUInt16(p), texmin[0], texmax[0]);
+      out.texcoords[i].y = _Dequantize(_ReadUInt16(p), texmin[1], texmax[1]);
+   }
+
+   out.indices.resize(nIndices);
+   int prev = 0;
+   for (size_t i=0;i<nIndices;i++)
+   {
+      unsigned int v = (nIndexSize == 4) ? _ReadUInt32(p) : _ReadUInt16(p);
+      prev += _UnZigZag(v);
+      out.indices[i] = prev;
+   }
+
+   return true;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,84 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#ifndef _BINARYTERRAINTILE_H
+#define _BINARYTERRAINTILE_H
+
+#include "og.h"
+#include "math/vec2.h"
+#include "math/vec3.h"
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Binary terrain tile (.ogt), contains the same data as the JSON terrain tile.
+// All values are little endian. 
+//
+//   char     magic[4]          "OGTB"
+//   uint32   version           BINARYTERRAINTILE_VERSION
+//   uint32   vertexcount
+//   uint32   indexcount
+//   uint32   curtainindex
+//   uint32   flags             BINARYTERRAINTILE_INDEX32: indices are 32 bit
+//   double   offset[3]         virtual camera offset
+//   double   bbmin[3]          bounding box
+//   double   bbmax[3]
+//   float    posmin[3]         range of vertex positions (relative to offset)
+//   float    posmax[3]
+//   float    texmin[2]         range of texture coordinates
+//   float    texmax[2]
+//   uint16   vertices[5*vertexcount]   x,y,z,u,v quantized to range (0..65535)
+//   uint16 or uint32 indices[indexcount]  zig-zag encoded difference to previous index
+
+#define BINARYTERRAINTILE_VERSION 1
+#define BINARYTERRAINTILE_INDEX32 1
+
+//------------------------------------------------------------------------------
+
+struct OPENGLOBE_API BinaryTerrainTileData
+{
+   BinaryTerrainTileData() : curtainindex(0) {}
+
+   vec3<double>               offset;
+   vec3<double>               bbmin;
+   vec3<double>               bbmax;
+   int                        curtainindex;
+   std::vector< vec3<float> > vertices;     // position relative to offset
+   std::vector< vec2<float> > texcoords;
+   std::vector<int>           indices;
+};
+
+//------------------------------------------------------------------------------
+
+class OPENGLOBE_API BinaryTerrainTile
+{
+public:
+   //! Encode terrain tile. Output is appended to sOut.
+   static void Encode(const vec3<float>* pVertices, const vec2<float>* pTexCoords, size_t nVertices, 
+                      const int* pIndices, size_t nIndices, 
+                      const vec3<double>& offset, const vec3<double>& bbmin, const vec3<double>& bbmax, 
+                      int curtainindex, std::string& sOut);
+
+   //! Encode terrain tile. Output is appended to sOut.
+   static void Encode(const BinaryTerrainTileData& data, std::string& sOut);
+
+   //! Decode terrain tile. Returns false if data is not a valid tile.
+   static bool Decode(const unsigned char* pData, size_t nSize, BinaryTerrainTileData& out);
+};
+
+#endif
@@ -21,7 +21,12 @@
 #include <ogr_spatialref.h>
 #include <cpl_conv.h>
 #include <string>
+#include <map>
+#include <vector>
 #include <cassert>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
 
 #include "CoordinateTransformation.h"
 
@@ -40,6 +45,21 @@
 #define WGS84_RN_POLE      6.399593625758673e+006
 
 
+namespace
+{
+   typedef std::map<std::pair<unsigned int, unsigned int>, boost::shared_ptr<CoordinateTransformation> > TransformationMap;
+
+   boost::mutex& _CreationMutex()
+   {
+      static boost::mutex s_mutex;
+      return s_mutex;
+   }
+
+   boost::thread_specific_ptr<TransformationMap> s_pThreadTransformations;
+}
+
+//-----------------------------------------------------------------------------
+
 CoordinateTransformation::~CoordinateTransformation()
 {
    if (_pCT)
@@ -99,6 +119,9 @@ void CoordinateTransformation::Init(unsigned int nSourceEPSG, unsigned int nDest
 
    if (!_bIdentity)
    {
+      // creating transformations is not thread safe (reads EPSG tables)
+      boost::mutex::scoped_lock lock(_CreationMutex());
+
       OGRSpatialReference srcref;
       OGRSpatialReference dstref;
 
@@ -266,6 +289,120 @@ bool CoordinateTransformation::TransformBackwards(double* dX, double* dY, double
 }
 
 
+//-----------------------------------------------------------------------------
+
+bool CoordinateTransformation::Transform(int n, double* dX, double* dY)
+{
+   if (_bIdentity)   // no transformation required, source is dest
+   {
+      return true;
+   }
+
+   if (!_pCT || n<=0)
+      return n==0;
+
+   std::vector<int> vSuccess(n, 0);
+   std::vector<double> vX(dX, dX+n), vY(dY, dY+n);
+   ((OGRCoordinateTransformation*)_pCT)->TransformEx(n, &vX[0], &vY[0], 0, &vSuccess[0]);
+
+   bool bAll = true;
+   for (int i=0;i<n;i++)
+   {
+      if (!vSuccess[i])
+      {
+         bAll = false;
+         continue;
+      }
+
+      double out_x = vX[i];
+      double out_y = vY[i];
+
+      if (_nDest2 == 3395)
+      {
+         Mercator::Forward(vX[i], vY[i], out_x, out_y);
+         if (out_y > 1.0) out_y = 1.0;
+         if (out_y < -1.0) out_y = -1.0;
+      }
+      else if (_nDest2 == 3785) // Web Mercator
+      {
+         Mercator::ForwardCustom(vX[i], vY[i], out_x, out_y, 0);
+         if (out_y > 1.0) out_y = 1.0;
+         if (out_y < -1.0) out_y = -1.0;
+      }
+
+      dX[i] = out_x;
+      dY[i] = out_y;
+   }
+
+   return bAll;
+}
+
+//-----------------------------------------------------------------------------
+
+bool CoordinateTransformation::TransformBackwards(int n, double* dX, double* dY)
+{
+   if (_bIdentity)   // no transformation required, source is dest
+   {
+      return true;
+   }
+
+   if (!_pCTBack || n<=0)
+      return n==0;
+
+   std::vector<int> vSuccess(n, 0);
+   std::vector<double> vX(dX, dX+n), vY(dY, dY+n);
+
+   for (int i=0;i<n;i++)
+   {
+      if (_nDest2 == 3395)
+      {
+         Mercator::Reverse(dX[i], dY[i], vX[i], vY[i]);
+      }
+      else if (_nDest2 == 3785) // Web Mercator
+      {
+         Mercator::ReverseCustom(dX[i], dY[i], vX[i], vY[i], 0);
+      }
+   }
+
+   ((OGRCoordinateTransformation*)_pCTBack)->TransformEx(n, &vX[0], &vY[0], 0, &vSuccess[0]);
+
+   bool bAll = true;
+   for (int i=0;i<n;i++)
+   {
+      if (vSuccess[i])
+      {
+         dX[i] = vX[i];
+         dY[i] = vY[i];
+      }
+      else
+      {
+         bAll = false;
+      }
+   }
+
+   return bAll;
+}
+
+//-----------------------------------------------------------------------------
+
+CoordinateTransformation* CoordinateTransformation::GetThreadInstance(unsigned int nSourceEPSG, unsigned int nDestEPSG)
+{
+   TransformationMap* pMap = s_pThreadTransformations.get();
+   if (!pMap)
+   {
+      pMap = new TransformationMap();
+      s_pThreadTransformations.reset(pMap);
+   }
+
+   boost::shared_ptr<CoordinateTransformation>& qCT = (*pMap)[std::make_pair(nSourceEPSG, nDestEPSG)];
+   if (!qCT)
+   {
+      qCT = boost::shared_ptr<CoordinateTransformation>(new CoordinateTransformation(nSourceEPSG, nDestEPSG));
+   }
+
+   return qCT.get();
+}
+
 //-----------------------------------------------------------------------------
 
 Mercator::Mercator()
@@ -52,6 +52,16 @@ public:
    bool Transform(double* dX, double* dY, double* dZ);
    bool TransformBackwards(double* dX, double* dY, double* dZ);
 
+   //! 2D Transformation of n points (arrays are transformed in place).
+   //! Returns false if any point couldn't be transformed, these points remain unchanged.
+   bool Transform(int n, double* dX, double* dY);
+   bool TransformBackwards(int n, double* dX, double* dY);
+
+   //! Returns transformation owned by the calling thread. Each thread has its 
+   //! own instance for every pair of EPSG codes, so transformations can be 
+   //! used in parallel. Instances are destroyed when the thread ends.
+   static CoordinateTransformation* GetThreadInstance(unsigned int nSourceEPSG, unsigned int nDestEPSG);
+
 protected:      
    unsigned int                  _nSourceEPSG;
    unsigned int                  _nDestEPSG;
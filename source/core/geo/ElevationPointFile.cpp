@@ -0,0 +1,227 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include "ElevationPointFile.h"
+#include "math/mathutils.h"
+#include <fstream>
+#include <cstring>
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+   const size_t POINTSIZE = 4*sizeof(double);
+
+   //---------------------------------------------------------------------------
+
+   void _InitHeader(ElevationPointFileHeader& oHeader)
+   {
+      memcpy(oHeader.magic, "OGPT", 4);
+      oHeader.version = ELEVATIONPOINTFILE_VERSION;
+      oHeader.count = 0;
+      oHeader.xmin = oHeader.ymin = 1e20;
+      oHeader.xmax = oHeader.ymax = -1e20;
+   }
+
+   //---------------------------------------------------------------------------
+
+   bool _IsValid(const ElevationPointFileHeader& oHeader)
+   {
+      return memcmp(oHeader.magic, "OGPT", 4) == 0 && oHeader.version == ELEVATIONPOINTFILE_VERSION;
+   }
+
+   //---------------------------------------------------------------------------
+
+   void _UpdateHeader(ElevationPointFileHeader& oHeader, const double* pData, size_t nPoints)
+   {
+      for (size_t i=0;i<nPoints;i++)
+      {
+         oHeader.xmin = math::Min<double>(oHeader.xmin, pData[4*i+0]);
+         oHeader.ymin = math::Min<double>(oHeader.ymin, pData[4*i+1]);
+         oHeader.xmax = math::Max<double>(oHeader.xmax, pData[4*i+0]);
+         oHeader.ymax = math::Max<double>(oHeader.ymax, pData[4*i+1]);
+      }
+      oHeader.count += nPoints;
+   }
+
+   //---------------------------------------------------------------------------
+   // Read whole file to memory
+
+   bool _ReadFile(const std::string& sFilename, std::vector<char>& vData)
+   {
+      std::ifstream fin;
+      fin.open(sFilename.c_str(), std::ios::binary);
+      if (!fin.good())
+      {
+         return false;
+      }
+
+      fin.seekg(0, std::ios::end);
+      size_t nSize = (size_t)fin.tellg();
+      fin.seekg(0, std::ios::beg);
+
+      vData.resize(nSize);
+      if (nSize > 0)
+      {
+         fin.read(&vData[0], nSize);
+         vData.resize((size_t)fin.gcount());
+      }
+      fin.close();
+
+      return true;
+   }
+
+   //---------------------------------------------------------------------------
+   // Create new file with header and points
+
+   bool _WriteFile(const std::string& sFilename, const double* pData0, size_t nPoints0, const double* pData1, size_t nPoints1)
+   {
+      ElevationPointFileHeader oHeader;
+      _InitHeader(oHeader);
+      _UpdateHeader(oHeader, pData0, nPoints0);
+      _UpdateHeader(oHeader, pData1, nPoints1);
+
+      std::ofstream fout;
+      fout.open(sFilename.c_str(), std::ios::binary | std::ios::trunc);
+      if (!fout.good())
+      {
+         return false;
+      }
+
+      fout.write((const char*)&oHeader, sizeof(ElevationPointFileHeader));
+      if (nPoints0 > 0)
+      {
+         fout.write((const char*)pData0, nPoints0*POINTSIZE);
+      }
+      if (nPoints1 > 0)
+      {
+         fout.write((const char*)pData1, nPoints1*POINTSIZE);
+      }
+
+      bool bOk = fout.good();
+      fout.close();
+      return bOk;
+   }
+}
+
+//------------------------------------------------------------------------------
+
+bool ElevationPointFile::Append(const std::string& sFilename, const double* pData, size_t nPoints)
+{
+   std::fstream fs;
+   fs.open(sFilename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+
+   if (!fs.good())
+   {
+      // new file
+      return _WriteFile(sFilename, pData, nPoints, 0, 0);
+   }
+
+   ElevationPointFileHeader oHeader;
+   fs.read((char*)&oHeader, sizeof(ElevationPointFileHeader));
+
+   if (!fs.good() || !_IsValid(oHeader))
+   {
+      // file without header: convert
+      fs.close();
+
+      std::vector<char> vData;
+      _ReadFile(sFilename, vData);
+      size_t nOldPoints = vData.size() / POINTSIZE;
+      return _WriteFile(sFilename, nOldPoints > 0 ? (const double*)&vData[0] : 0, nOldPoints, pData, nPoints);
+   }
+
+   if (nPoints == 0)
+   {
+      return true;
+   }
+
+   // append after last valid point, then update header
+   fs.seekp(std::streamoff(sizeof(ElevationPointFileHeader) + oHeader.count*POINTSIZE), std::ios::beg);
+   fs.write((const char*)pData, nPoints*POINTSIZE);
+
+   _UpdateHeader(oHeader, pData, nPoints);
+   fs.seekp(0, std::ios::beg);
+   fs.write((const char*)&oHeader, sizeof(ElevationPointFileHeader));
+
+   bool bOk = fs.good();
+   fs.close();
+   return bOk;
+}
+
+//------------------------------------------------------------------------------
+
+bool ElevationPointFile::Read(const std::string& sFilename, std::vector<ElevationPoint>& vPoints)
+{
+   vPoints.clear();
+
+   std::vector<char> vData;
+   if (!_ReadFile(sFilename, vData))
+   {
+      return false;
+   }
+
+   size_t nPoints;
+   const double* pData;
+
+   if (vData.size() >= sizeof(ElevationPointFileHeader) && _IsValid(*(const ElevationPointFileHeader*)&vData[0]))
+   {
+      const ElevationPointFileHeader* pHeader = (const ElevationPointFileHeader*)&vData[0];
+      nPoints = (size_t)pHeader->count;
+      if (sizeof(ElevationPointFileHeader) + nPoints*POINTSIZE > vData.size())
+      {
+         return false;
+      }
+      pData = (const double*)&vData[sizeof(ElevationPointFileHeader)];
+   }
+   else
+   {
+      // file without header (older version)
+      nPoints = vData.size() / POINTSIZE;
+      pData = nPoints > 0 ? (const double*)&vData[0] : 0;
+   }
+
+   vPoints.resize(nPoints);
+   for (size_t i=0;i<nPoints;i++)
+   {
+      ElevationPoint& pt = vPoints[i];
+      pt.x = pData[4*i+0];
+      pt.y = pData[4*i+1];
+      pt.elevation = pData[4*i+2];
+      pt.weight = pData[4*i+3];
+   }
+
+   return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool ElevationPointFile::ReadHeader(const std::string& sFilename, ElevationPointFileHeader& oHeader)
+{
+   std::ifstream fin;
+   fin.open(sFilename.c_str(), std::ios::binary);
+   if (!fin.good())
+   {
+      return false;
+   }
+
+   fin.read((char*)&oHeader, sizeof(ElevationPointFileHeader));
+   return fin.good() && _IsValid(oHeader);
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,62 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#ifndef _ELEVATIONPOINTFILE_H
+#define _ELEVATIONPOINTFILE_H
+
+#include "og.h"
+#include "math/ElevationPoint.h"
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Header of temporary point tiles (.pts). The header is followed by "count"
+// points, each stored as x, y, elevation, weight (double). 
+// This is a temporary file, it is not endian safe.
+
+struct ElevationPointFileHeader
+{
+   char           magic[4];      // "OGPT"
+   unsigned int   version;       // ELEVATIONPOINTFILE_VERSION
+   uint64         count;         // number of points
+   double         xmin, ymin;    // bounding box of points
+   double         xmax, ymax;
+};
+
+#define ELEVATIONPOINTFILE_VERSION 1
+
+//------------------------------------------------------------------------------
+
+class OPENGLOBE_API ElevationPointFile
+{
+public:
+   //! Append points (x,y,elevation,weight per point) to point file. The file is
+   //! created if it doesn't exist. The file must be locked by the caller.
+   //! Point files without header (older version) are converted.
+   static bool Append(const std::string& sFilename, const double* pData, size_t nPoints);
+
+   //! Read all points of a point file using a single read.
+   //! Returns false if file doesn't exist or is invalid.
+   //! Point files without header (older version) can be read too.
+   static bool Read(const std::string& sFilename, std::vector<ElevationPoint>& vPoints);
+
+   //! Read header only.
+   static bool ReadHeader(const std::string& sFilename, ElevationPointFileHeader& oHeader);
+};
+
+#endif
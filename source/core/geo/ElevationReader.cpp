@@ -32,10 +32,46 @@
 #include <cassert>
 #include <iostream>
 #include <sstream>
+#include <omp.h>
 
 #define _pGDALDataset ((GDALDataset*)_pDataset)
 #define _pElvBand     ((GDALRasterBand*)_pElv) 
 
+namespace
+{
+   //---------------------------------------------------------------------------
+   // Decode block of type T. Every pixel is written to the output arrays, but 
+   // the output position is only advanced for valid pixels (no branches in
+   // inner loop).
+
+   template<typename T>
+   size_t _DecodeBlockT(const T* pBlock, int nBlockWidth, int BaseX, int BaseY, int valid_width, int valid_height, const double* affine, double dNoData, double dMin, double dMax, double* vX, double* vY, double* vZ)
+   {
+      size_t n = 0;
+
+      for (int y=0;y<valid_height;y++)
+      {
+         const T* pRow = pBlock + y*nBlockWidth;
+         double fy = double(y+BaseY);
+
+         for (int x=0;x<valid_width;x++)
+         {
+            double fx = double(x+BaseX);
+            double fz = (double)pRow[x];
+
+            vX[n] = affine[0] + fx*affine[1] + fy*affine[2];
+            vY[n] = affine[3] + fx*affine[4] + fy*affine[5];
+            vZ[n] = fz;
+
+            // NODATA and range check:
+            n += (fz != dNoData) & !(fz > dMax) & !(fz < dMin);
+         }
+      }
+
+      return n;
+   }
+}
+
 
 
 ElevationReader::ElevationReader()
@@ -217,20 +253,21 @@ bool ElevationReader::Import(std::vector<ElevationPoint>& result, double& inout_
 
 //------------------------------------------------------------------------------
 
-void ElevationReader::_ReadBlock(int bx, int by, int& valid_width, int& valid_height)
+void ElevationReader::_ReadBlock(void* pBand, void* pBlock, int bx, int by, int& valid_width, int& valid_height)
 {
-   _pElvBand->ReadBlock( bx, by, _pBlockElv );
+   GDALRasterBand* pRasterBand = (GDALRasterBand*)pBand;
+   pRasterBand->ReadBlock( bx, by, pBlock );
 
    // Compute the portion of the block that is valid
    // for partial edge blocks.
-   if( (bx+1) * _nBlockWidth > _pElvBand->GetXSize() )
-      valid_width = _pElvBand->GetXSize() - bx * _nBlockWidth;
+   if( (bx+1) * _nBlockWidth > pRasterBand->GetXSize() )
+      valid_width = pRasterBand->GetXSize() - bx * _nBlockWidth;
    else
       valid_width = _nBlockWidth;
 
-   if( (by+1) * _nBlockHeight > _pElvBand->GetYSize() )
+   if( (by+1) * _nBlockHeight > pRasterBand->GetYSize() )
    {
-      valid_height = _pElvBand->GetYSize() - by * _nBlockHeight;
+      valid_height = pRasterBand->GetYSize() - by * _nBlockHeight;
    }
    else
    {
@@ -240,6 +277,31 @@ void ElevationReader::_ReadBlock(int bx, int by, int& valid_width, int& valid_he
 
 //------------------------------------------------------------------------------
 
+size_t ElevationReader::_DecodeBlock(const void* pBlock, int BaseX, int BaseY, int valid_width, int valid_height, double* vX, double* vY, double* vZ)
+{
+   switch(_datatype)
+   {
+   case 1:  // GDT_UInt32
+      return _DecodeBlockT<unsigned int>((const unsigned int*)pBlock, _nBlockWidth, BaseX, BaseY, valid_width, valid_height, _affineTransformation, _dNoDataValue, _minElvValue, _maxElvValue, vX, vY, vZ);
+   case 2:  // GDT_Int32
+      return _DecodeBlockT<int>((const int*)pBlock, _nBlockWidth, BaseX, BaseY, valid_width, valid_height, _affineTransformation, _dNoDataValue, _minElvValue, _maxElvValue, vX, vY, vZ);
+   case 3:  // GDT_Float32
+      return _DecodeBlockT<float>((const float*)pBlock, _nBlockWidth, BaseX, BaseY, valid_width, valid_height, _affineTransformation, _dNoDataValue, _minElvValue, _maxElvValue, vX, vY, vZ);
+   case 4:  // GDT_Float64
+      return _DecodeBlockT<double>((const double*)pBlock, _nBlockWidth, BaseX, BaseY, valid_width, valid_height, _affineTransformation, _dNoDataValue, _minElvValue, _maxElvValue, vX, vY, vZ);
+   case 5:  // GDT_UInt16
+      return _DecodeBlockT<unsigned short>((const unsigned short*)pBlock, _nBlockWidth, BaseX, BaseY, valid_width, valid_height, _affineTransformation, _dNoDataValue, _minElvValue, _maxElvValue, vX, vY, vZ);
+   case 6:  // GDT_Int16
+      return _DecodeBlockT<short>((const short*)pBlock, _nBlockWidth, BaseX, BaseY, valid_width, valid_height, _affineTransformation, _dNoDataValue, _minElvValue, _maxElvValue, vX, vY, vZ);
+   default:
+      assert(false);
+   }
+
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+
 bool ElevationReader::_ImportXYZ(std::vector<ElevationPoint>& result, double& inout_xmin, double& inout_ymin, double& inout_xmax, double& inout_ymax)
 {
    CoordinateTransformation* pCT = 0;
@@ -320,15 +382,7 @@ bool ElevationReader::_ImportXYZ(std::vector<ElevationPoint>& result, double& in
 bool ElevationReader::_ImportRaster(std::vector<ElevationPoint>& result, double& inout_xmin, double& inout_ymin, double& inout_xmax, double& inout_ymax)
 {
    int valid_width; int valid_height;
-   double fx,fy,fz;
-   unsigned int ui_value;
-   int i_value;
-   float f_value;
-   double d_value;
-   unsigned short us_value;
-   short s_value;
-
-   fz = 0;
+
    CoordinateTransformation* pCT = 0;
 
    if (_nSourceEPSG != 0)
@@ -342,117 +396,45 @@ bool ElevationReader::_ImportRaster(std::vector<ElevationPoint>& result, double&
    result.clear();
    result.reserve(_nRasterSizeX*_nRasterSizeY);
 
-
    ElevationPoint pt;
+   pt.weight = 0;
+   size_t nBlockSize = size_t(_nBlockWidth)*size_t(_nBlockHeight);
+   std::vector<double> vX(nBlockSize), vY(nBlockSize), vZ(nBlockSize);  // points of current block
 
    for(int iYBlock = 0; iYBlock < _nYBlocks; iYBlock++ )
    {
       for(int iXBlock = 0; iXBlock < _nXBlocks; iXBlock++ )
       {
-         _ReadBlock(iXBlock, iYBlock, valid_width, valid_height);
+         _ReadBlock(_pElv, _pBlockElv, iXBlock, iYBlock, valid_width, valid_height);
 
-         int BaseX = _nBlockWidth * iXBlock;
-         int BaseY = _nBlockHeight * iYBlock;
+         size_t nCount = _DecodeBlock(_pBlockElv, _nBlockWidth * iXBlock, _nBlockHeight * iYBlock, valid_width, valid_height, &vX[0], &vY[0], &vZ[0]);
 
-         for (int y=0;y<valid_height;y++)
+         // Transform points of this block:
+         if (pCT && nCount>0)
          {
-            for (int x=0;x<valid_width;x++)
-            {
-               bool bNoData = true;
-               GetSourceCoord(double(x+BaseX), double(y+BaseY), &fx, &fy);
-               switch(_datatype)
-               {
-               case 1:  // GDT_UInt32
-                  ui_value = ((unsigned int*)_pBlockElv)[y*_nBlockWidth+x];
-                  if (ui_value!=_dNoDataValue)
-                  {
-                     fz = (double) ui_value;
-                     bNoData = false;
-                  }
-                  break;
-               case 2:  // GDT_Int32
-                  i_value = ((int*)_pBlockElv)[y*_nBlockWidth+x];
-                  if (i_value!=_dNoDataValue)
-                  {
-                     fz = (double) i_value;
-                     bNoData = false;
-                  }
-                  break;
-               case 3:  // GDT_Float32
-                  f_value = ((float*)_pBlockElv)[y*_nBlockWidth+x];
-                  if (f_value!=_dNoDataValue)
-                  {
-                     fz = (double) f_value;
-                     bNoData = false;
-                  }
-                  break;
-               case 4:  // GDT_Float64
-                  d_value = ((double*)_pBlockElv)[y*_nBlockWidth+x];
-                  if (d_value!=_dNoDataValue)
-                  {
-                     fz = d_value;
-                     bNoData = false;
-                  }
-                  break;
-               case 5: 
-                  {
-                     unsigned short* pElvData = ((unsigned short*)_pBlockElv);
-                     us_value = pElvData[y*_nBlockWidth+x];
-                     if (us_value!=_dNoDataValue)
-                     {
-                        fz = (double) us_value;
-                        bNoData = false;
-                     }
-                  }
-                  break;
-               case 6:  
-                  {
-                     short* pElvData = ((short*)_pBlockElv);
-                     s_value = pElvData[y*_nBlockWidth+x];
-                     if (s_value!=_dNoDataValue)
-                     {
-                        fz = (double) s_value;
-                        bNoData = false;
-                     }
-                  }
-                  break;
-
-               default:
-                  assert(false);
-               }
-
-               // further NODATA value check:
-               if (fz > _maxElvValue || fz < _minElvValue)
-               {
-                   bNoData = true;
-               }
-
-               // Transform Point:
-
-               if (!bNoData)
-               {
+            pCT->Transform((int)nCount, &vX[0], &vY[0]);
+         }
 
-                  if (pCT)
-                  {  
-                     pCT->Transform(&fx, &fy);
-                  }
-
-                  pt.x = fx;
-                  pt.y = fy;
-                  pt.elevation = fz;
-                  pt.weight = 0;
-                  result.push_back(pt);
-
-                  inout_xmax = math::Max<double>(inout_xmax, fx);
-                  inout_ymax = math::Max<double>(inout_ymax, fy);
-                  inout_xmin = math::Min<double>(inout_xmin, fx);
-                  inout_ymin = math::Min<double>(inout_ymin, fy);
-               }
-            }
+         for (size_t i=0;i<nCount;i++)
+         {
+            pt.x = vX[i];
+            pt.y = vY[i];
+            pt.elevation = vZ[i];
+            result.push_back(pt);
+
+            inout_xmax = math::Max<double>(inout_xmax, vX[i]);
+            inout_ymax = math::Max<double>(inout_ymax, vY[i]);
+            inout_xmin = math::Min<double>(inout_xmin, vX[i]);
+            inout_ymin = math::Min<double>(inout_ymin, vY[i]);
          }
       }
    }
 
+   if (pCT)
+   {
+      delete pCT;
+   }
+
    return true;
 }
 
@@ -464,15 +446,6 @@ bool ElevationReader::_ImportRaster(std::vector<ElevationPoint>& result, double&
    _numPts = 0;
    _curPts = 0;
 
-   int valid_width; int valid_height;
-   double fx,fy,fz;
-   unsigned int ui_value;
-   int i_value;
-   float f_value;
-   double d_value;
-   unsigned short us_value;
-   short s_value;
-
    std::ofstream ofs(sFilename.c_str(), std::ios::binary);
 
    if (!ofs.good())
@@ -481,134 +454,90 @@ bool ElevationReader::_ImportRaster(std::vector<ElevationPoint>& result, double&
    }
 
    size = 0;
-   fz = 0;
-
-   CoordinateTransformation* pCT = 0;
 
-   if (_nSourceEPSG != 0)
-   {
-      if (_nSourceEPSG != _nDestEPSG)
-         pCT = new CoordinateTransformation(_nSourceEPSG, _nDestEPSG);
-   }
+   bool bTransform = (_nSourceEPSG != 0 && _nSourceEPSG != _nDestEPSG);
 
    //---------------------------------------------------------------------------
 
-   ElevationPoint pt;
+   int nBlocks = _nXBlocks * _nYBlocks;
+   size_t nBlockSize = size_t(_nBlockWidth)*size_t(_nBlockHeight);
 
-   for(int iYBlock = 0; iYBlock < _nYBlocks; iYBlock++ )
+   #pragma omp parallel
    {
-      for(int iXBlock = 0; iXBlock < _nXBlocks; iXBlock++ )
+      // GDAL datasets can't be shared between threads, every thread uses its own dataset.
+      // If that fails the dataset of this reader is used (one thread at a time).
+      GDALDataset* pDataset = 0;
+      GDALRasterBand* pBand = 0;
+      if (omp_get_num_threads() > 1)
       {
-         _ReadBlock(iXBlock, iYBlock, valid_width, valid_height);
-
-         int BaseX = _nBlockWidth * iXBlock;
-         int BaseY = _nBlockHeight * iYBlock;
-
-         for (int y=0;y<valid_height;y++)
+         pDataset = (GDALDataset*)GDALOpen(_sFilename.c_str(), GA_ReadOnly);
+         if (pDataset)
          {
-            for (int x=0;x<valid_width;x++)
-            {
-               bool bNoData = true;
-               GetSourceCoord(double(x+BaseX), double(y+BaseY), &fx, &fy);
-               switch(_datatype)
-               {
-               case 1:  // GDT_UInt32
-                  ui_value = ((unsigned int*)_pBlockElv)[y*_nBlockWidth+x];
-                  if (ui_value!=_dNoDataValue)
-                  {
-                     fz = (double) ui_value;
-                     bNoData = false;
-                  }
-                  break;
-               case 2:  // GDT_Int32
-                  i_value = ((int*)_pBlockElv)[y*_nBlockWidth+x];
-                  if (i_value!=_dNoDataValue)
-                  {
-                     fz = (double) i_value;
-                     bNoData = false;
-                  }
-                  break;
-               case 3:  // GDT_Float32
-                  f_value = ((float*)_pBlockElv)[y*_nBlockWidth+x];
-                  if (f_value!=_dNoDataValue)
-                  {
-                     fz = (double) f_value;
-                     bNoData = false;
-                  }
-                  break;
-               case 4:  // GDT_Float64
-                  d_value = ((double*)_pBlockElv)[y*_nBlockWidth+x];
-                  if (d_value!=_dNoDataValue)
-                  {
-                     fz = d_value;
-                     bNoData = false;
-                  }
-                  break;
-               case 5: 
-                  {
-                     unsigned short* pElvData = ((unsigned short*)_pBlockElv);
-                     us_value = pElvData[y*_nBlockWidth+x];
-                     if (us_value!=_dNoDataValue)
-                     {
-                        fz = (double) us_value;
-                        bNoData = false;
-                     }
-                  }
-                  break;
-               case 6:  
-                  {
-                     short* pElvData = ((short*)_pBlockElv);
-                     s_value = pElvData[y*_nBlockWidth+x];
-                     if (s_value!=_dNoDataValue)
-                     {
-                        fz = (double) s_value;
-                        bNoData = false;
-                     }
-                  }
-                  break;
-
-               default:
-                  assert(false);
-               }
+            pBand = pDataset->GetRasterBand(1);
+         }
+      }
 
-               // further NODATA value check:
-               if (fz > _maxElvValue || fz < _minElvValue)
-               {
-                   bNoData = true;
-               }
+      CoordinateTransformation* pCT = bTransform ? CoordinateTransformation::GetThreadInstance(_nSourceEPSG, _nDestEPSG) : 0;
 
-               // Transform Point:
+      int valid_width; int valid_height;
+      std::vector<unsigned char> vBlock(_datatype_bytes*nBlockSize);
+      std::vector<double> vX(nBlockSize), vY(nBlockSize), vZ(nBlockSize);  // points of current block
+      std::vector<double> vOut(3*nBlockSize);                                // x,y,z of current block as written to disk
 
-               if (!bNoData)
-               {
+      #pragma omp for ordered schedule(dynamic,1)
+      for (int nBlock = 0; nBlock < nBlocks; nBlock++)
+      {
+         int iXBlock = nBlock % _nXBlocks;
+         int iYBlock = nBlock / _nXBlocks;
 
-                  if (pCT)
-                  {  
-                     pCT->Transform(&fx, &fy);
-                  }
+         if (pBand)
+         {
+            _ReadBlock(pBand, &vBlock[0], iXBlock, iYBlock, valid_width, valid_height);
+         }
+         else
+         {
+            #pragma omp critical (ElevationReader_ReadBlock)
+            _ReadBlock(_pElv, &vBlock[0], iXBlock, iYBlock, valid_width, valid_height);
+         }
 
-                  pt.x = fx;
-                  pt.y = fy;
-                  pt.elevation = fz;
-                  pt.weight = 0;
+         size_t nCount = _DecodeBlock(&vBlock[0], _nBlockWidth * iXBlock, _nBlockHeight * iYBlock, valid_width, valid_height, &vX[0], &vY[0], &vZ[0]);
 
-                  ofs.write((const char*)&pt.x, sizeof(double));
-                  ofs.write((const char*)&pt.y, sizeof(double));
-                  ofs.write((const char*)&pt.elevation, sizeof(double));
-                 
+         // Transform points of this block:
+         if (pCT && nCount>0)
+         {
+            pCT->Transform((int)nCount, &vX[0], &vY[0]);
+         }
 
-                  // append pt
+         for (size_t i=0;i<nCount;i++)
+         {
+            vOut[3*i+0] = vX[i];
+            vOut[3*i+1] = vY[i];
+            vOut[3*i+2] = vZ[i];
+         }
 
-                  size++;
+         // write blocks in order, the result doesn't depend on number of threads
+         #pragma omp ordered
+         {
+            if (nCount>0)
+            {
+               ofs.write((const char*)&vOut[0], 3*nCount*sizeof(double));
+               size += nCount;
 
-                  inout_xmax = math::Max<double>(inout_xmax, fx);
-                  inout_ymax = math::Max<double>(inout_ymax, fy);
-                  inout_xmin = math::Min<double>(inout_xmin, fx);
-                  inout_ymin = math::Min<double>(inout_ymin, fy);
+               for (size_t i=0;i<nCount;i++)
+               {
+                  inout_xmax = math::Max<double>(inout_xmax, vX[i]);
+                  inout_ymax = math::Max<double>(inout_ymax, vY[i]);
+                  inout_xmin = math::Min<double>(inout_xmin, vX[i]);
+                  inout_ymin = math::Min<double>(inout_ymin, vY[i]);
                }
             }
          }
       }
+
+      if (pDataset)
+      {
+         GDALClose(pDataset);
+      }
    }
 
    ofs.close();
@@ -48,7 +48,8 @@ public:
    // Transform Elevation points and write points to binary stream. Returns points written and bounding box
    bool Import(std::vector<ElevationPoint>& result, double& inout_xmin, double& inout_ymin, double& inout_xmax, double& inout_ymax);
 
-   // Import elevation points and store on disk
+   // Import elevation points and store on disk. Blocks are read by all OpenMP threads 
+   // (each thread opens its own dataset), points are written in block order.
    bool Import(const std::string& tempfile, size_t& size, double& inout_xmin, double& inout_ymin, double& inout_xmax, double& inout_ymax);
  
    bool GetNextPoint(ElevationPoint& pt);
@@ -59,7 +60,12 @@ protected:
    bool _ImportRaster(std::vector<ElevationPoint>& result, double& inout_xmin, double& inout_ymin, double& inout_xmax, double& inout_ymax);
    
    void _Free();
-   void _ReadBlock(int bx, int by, int& valid_width, int& valid_height);
+   // Read block (bx,by) of specified band (GDALRasterBand*) into pBlock.
+   void _ReadBlock(void* pBand, void* pBlock, int bx, int by, int& valid_width, int& valid_height);
+
+   // Decode valid points of block to source coordinates, returns number of points.
+   // vX, vY, vZ must hold atleast one block.
+   size_t _DecodeBlock(const void* pBlock, int BaseX, int BaseY, int valid_width, int valid_height, double* vX, double* vY, double* vZ);
 
    inline void GetSourcePixel(double x_src, double y_src, double* x, double* y)
    {
@@ -19,9 +19,12 @@
 #include "ElevationTile.h"
 #include "math/GeoCoord.h"
 #include "geo/CoordinateTransformation.h"
+#include "string/NumberFormat.h"
+#include "geo/BinaryTerrainTile.h"
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <cstring>
 
 //------------------------------------------------------------------------------
 
@@ -252,58 +255,139 @@ std::string ElevationTile::CreateOBJ(double xmin, double ymin, double xmax, doub
 //------------------------------------------------------------------------------
 
 std::string ElevationTile::CreateJSON()
+{
+   std::string sJSON;
+   CreateJSON(sJSON);
+   return sJSON;
+}
+
+//------------------------------------------------------------------------------
+
+void ElevationTile::CreateJSON(std::string& sJSON)
 {
    // 1) Create Triangulation (with curtain)
    // 2) Export JSON Tile (according to OpenWebGlobe specification)
 
    _PrecomputeTriangulation(true); // this calculates: _idxcurtain; _lstElevationPointWGS84; _lstTexCoord; _lstIndices; _vOffset; _bbmin; _bbmax;
+   _WriteJSON(sJSON);
+}
+
+//------------------------------------------------------------------------------
+
+void ElevationTile::CreateBinary(std::string& sData)
+{
+   _PrecomputeTriangulation(true);
+   _WriteBinaryTerrain(sData);
+}
 
-   std::ostringstream of;
-   of.precision(FLT_DIG);  // floating point precision is required vertices
+//------------------------------------------------------------------------------
+
+void ElevationTile::CreateTerrain(ETerrainFormat eFormat, std::string& sJSON, std::string& sData)
+{
+   _PrecomputeTriangulation(true);
 
+   if (eFormat & TERRAINFORMAT_JSON)
+   {
+      _WriteJSON(sJSON);
+   }
+   if (eFormat & TERRAINFORMAT_BINARY)
+   {
+      _WriteBinaryTerrain(sData);
+   }
+}
 
-   of << "{\n";
-   of << "   \"VertexSemantic\"  :  \"pt\",\n";
-   of << "   \"Vertices\" : [ ";
+//------------------------------------------------------------------------------
+
+bool ElevationTile::GetTerrainFormat(const std::string& sFormat, ETerrainFormat& eFormat)
+{
+   if (sFormat == "json")
+   {
+      eFormat = TERRAINFORMAT_JSON;
+   }
+   else if (sFormat == "binary")
+   {
+      eFormat = TERRAINFORMAT_BINARY;
+   }
+   else if (sFormat == "both")
+   {
+      eFormat = TERRAINFORMAT_BOTH;
+   }
+   else
+   {
+      return false;
+   }
+
+   return true;
+}
+
+//------------------------------------------------------------------------------
+
+void ElevationTile::_WriteJSON(std::string& of)
+{
+   // numbers are formatted like std::ostream with precision FLT_DIG (vertices) and DBL_DIG (offset, bounding box)
+   of.clear();
+   of.reserve(128 + _lstElevationPointWGS84.size()*5*16 + _lstIndices.size()*8);
+
+   of += "{\n";
+   of += "   \"VertexSemantic\"  :  \"pt\",\n";
+   of += "   \"Vertices\" : [ ";
 
    for (size_t i=0;i<_lstElevationPointWGS84.size();i++)
    {
-      of << _lstElevationPointWGS84[i].x << ", ";
-      of << _lstElevationPointWGS84[i].y << ", ";
-      of << _lstElevationPointWGS84[i].z << ", ";
-      of << _lstTexCoord[i].x << ", ";
-      of << _lstTexCoord[i].y;
+      NumberFormat::AppendFloat(of, _lstElevationPointWGS84[i].x, FLT_DIG); of += ", ";
+      NumberFormat::AppendFloat(of, _lstElevationPointWGS84[i].y, FLT_DIG); of += ", ";
+      NumberFormat::AppendFloat(of, _lstElevationPointWGS84[i].z, FLT_DIG); of += ", ";
+      NumberFormat::AppendFloat(of, _lstTexCoord[i].x, FLT_DIG); of += ", ";
+      NumberFormat::AppendFloat(of, _lstTexCoord[i].y, FLT_DIG);
       if (i!= _lstElevationPointWGS84.size()-1)
       {
-         of << ", ";
+         of += ", ";
       }
    }
-   of << " ],\n";
-   of << "   \"IndexSemantic\"  :  \"TRIANGLES\",\n";
-   of << "   \"Indices\"  : [ ";
+   of += " ],\n";
+   of += "   \"IndexSemantic\"  :  \"TRIANGLES\",\n";
+   of += "   \"Indices\"  : [ ";
 
    for (size_t i=0;i<_lstIndices.size();i++)
    {
-      of << _lstIndices[i];
+      NumberFormat::AppendInt(of, _lstIndices[i]);
       if (i != _lstIndices.size()-1)
       {
-         of << ", ";
+         of += ", ";
       }
    }
 
-   of << "],\n";
+   of += "],\n";
 
    // virtual camera offset and bounding box (must be stored in double precision!!)
-   of.precision(DBL_DIG);
-   of << "   \"Offset\"  :  [ " << _vOffset.x << ", " << _vOffset.y << ", " << _vOffset.z << "],\n";  
-      
-   of << "   \"BoundingBox\" : [[ " << _bbmin.x << ", " << _bbmin.y << ", " << _bbmin.z << " ],[ "
-                                       << _bbmax.x << ", " << _bbmax.y << ", " << _bbmax.z << " ]],\n";
-   of.precision(FLT_DIG);
-   of << "   \"CurtainIndex\" : " << _idxcurtain << "\n";
-   of << "}\n";   
+   of += "   \"Offset\"  :  [ ";
+   NumberFormat::AppendFloat(of, _vOffset.x, DBL_DIG); of += ", ";
+   NumberFormat::AppendFloat(of, _vOffset.y, DBL_DIG); of += ", ";
+   NumberFormat::AppendFloat(of, _vOffset.z, DBL_DIG); of += "],\n";
+
+   of += "   \"BoundingBox\" : [[ ";
+   NumberFormat::AppendFloat(of, _bbmin.x, DBL_DIG); of += ", ";
+   NumberFormat::AppendFloat(of, _bbmin.y, DBL_DIG); of += ", ";
+   NumberFormat::AppendFloat(of, _bbmin.z, DBL_DIG); of += " ],[ ";
+   NumberFormat::AppendFloat(of, _bbmax.x, DBL_DIG); of += ", ";
+   NumberFormat::AppendFloat(of, _bbmax.y, DBL_DIG); of += ", ";
+   NumberFormat::AppendFloat(of, _bbmax.z, DBL_DIG); of += " ]],\n";
+
+   of += "   \"CurtainIndex\" : ";
+   NumberFormat::AppendInt(of, _idxcurtain);
+   of += "\n";
+   of += "}\n";
+}
 
-   return of.str();
+//------------------------------------------------------------------------------
+
+void ElevationTile::_WriteBinaryTerrain(std::string& sData)
+{
+   size_t nVertices = _lstElevationPointWGS84.size();
+   sData.clear();
+   BinaryTerrainTile::Encode(nVertices > 0 ? &_lstElevationPointWGS84[0] : 0, nVertices > 0 ? &_lstTexCoord[0] : 0, nVertices,
+                             _lstIndices.size() > 0 ? &_lstIndices[0] : 0, _lstIndices.size(),
+                             _vOffset, _bbmin, _bbmax, _idxcurtain, sData);
 }
 
 //------------------------------------------------------------------------------
@@ -348,10 +432,8 @@ boost::shared_ptr<math::DelaunayTriangulation> ElevationTile::CreateTriangulatio
       qTriangulation->InsertPoint(_ptsWest[i]);
    }
 
-   for (size_t i=0;i<_ptsMiddle.size();i++)
-   {
-      qTriangulation->InsertPoint(_ptsMiddle[i]);
-   }
+   // (3) Insert Middle Points (along hilbert curve)
+   qTriangulation->InsertPoints(_ptsMiddle);
    
    return qTriangulation;
 }
@@ -773,105 +855,119 @@ void ElevationTile::_CreateCurtain(double curtainelv, ElevationPoint& start, Ele
 */
 //------------------------------------------------------------------------------
 
-inline void _writeElevationPoint(std::ostream& streamout, ElevationPoint& pt)
+// Temporary tile file (.tri): header, corner points (NW, NE, SE, SW), then
+// north, east, south, west and middle points. Every point is stored as 
+// x, y, elevation, weight (double), so the sections can be used in place.
+// note: this is is a temporary file, no need to worry about endian or size of double...
+
+struct ElevationTileFileHeader
 {
-   // note: this is is a temporary file, no need to worry about endian or size of double...
-   streamout.write((char*)&pt.x, sizeof(double));
-   streamout.write((char*)&pt.y, sizeof(double));
-   streamout.write((char*)&pt.elevation, sizeof(double));
-   streamout.write((char*)&pt.weight, sizeof(double));
+   char           magic[4];   // "OGTR"
+   unsigned int   version;    // ELEVATIONTILEFILE_VERSION
+   double         x0, y0;     // 2D boundary
+   double         x1, y1;
+   uint64         count[5];   // number of points: north, east, south, west, middle
+   uint64         offset[5];  // byte offset of sections (from start of file)
+};
+
+#define ELEVATIONTILEFILE_VERSION 1
+
+//------------------------------------------------------------------------------
+
+inline double* _writeElevationPoint(double* pOut, const ElevationPoint& pt)
+{
+   pOut[0] = pt.x;
+   pOut[1] = pt.y;
+   pOut[2] = pt.elevation;
+   pOut[3] = pt.weight;
    // [note: pt.error can be ignored when saving, assume it to be 0 when read]
+   return pOut + 4;
 }
 
 //------------------------------------------------------------------------------
 
-inline void _readElevationPoint(std::istream& streamin, ElevationPoint& pt)
+inline const double* _readElevationPoint(const double* pIn, ElevationPoint& pt)
 {
-   streamin.read((char*)&pt.x, sizeof(double));
-   streamin.read((char*)&pt.y, sizeof(double));
-   streamin.read((char*)&pt.elevation, sizeof(double));
-   streamin.read((char*)&pt.weight, sizeof(double));
+   pt.x = pIn[0];
+   pt.y = pIn[1];
+   pt.elevation = pIn[2];
+   pt.weight = pIn[3];
    pt.error = 0;
+   return pIn + 4;
+}
+
+//------------------------------------------------------------------------------
+
+inline void _readElevationPoints(const double* pIn, size_t n, std::vector<ElevationPoint>& vPoints)
+{
+   vPoints.resize(n);
+   for (size_t i=0;i<n;i++)
+   {
+      pIn = _readElevationPoint(pIn, vPoints[i]);
+   }
 }
 
 //------------------------------------------------------------------------------
-//#todo: add some error checking...
+
 bool ElevationTile::WriteBinary(const std::string& sTempfilename)
 {
    // note: no exclusive lock required for this ("thread safe" during processing)
 
-   std::ofstream elvtile;
+   std::vector<ElevationPoint>* vSections[5] = {&_ptsNorth, &_ptsEast, &_ptsSouth, &_ptsWest, &_ptsMiddle};
+   const size_t nPointSize = 4*sizeof(double);
 
-   elvtile.open(sTempfilename.c_str(), std::ios::binary);
+   ElevationTileFileHeader oHeader;
+   memcpy(oHeader.magic, "OGTR", 4);
+   oHeader.version = ELEVATIONTILEFILE_VERSION;
+   oHeader.x0 = _x0;
+   oHeader.y0 = _y0;
+   oHeader.x1 = _x1;
+   oHeader.y1 = _y1;
 
-   if (elvtile.good())
+   size_t nOffset = sizeof(ElevationTileFileHeader) + 4*nPointSize;
+   for (int i=0;i<5;i++)
    {
-      int n;
-      // [0] write 2D boundary
-      elvtile.write((char*)&_x0, sizeof(double));
-      elvtile.write((char*)&_y0, sizeof(double));
-      elvtile.write((char*)&_x1, sizeof(double));
-      elvtile.write((char*)&_y1, sizeof(double));
-
-      // [1] write CORNER POINTS
-      _writeElevationPoint(elvtile, _NW);
-      _writeElevationPoint(elvtile, _NE);
-      _writeElevationPoint(elvtile, _SE);
-      _writeElevationPoint(elvtile, _SW);
-
-      // [2] write NORTH-EDGE-POINTS
-      n = (int)_ptsNorth.size();
-      elvtile.write((char*)&n, sizeof(int));
-      for (int i=0;i<n;i++)
-      {
-         _writeElevationPoint(elvtile, _ptsNorth[i]);
-      }
-
-      // [3] write EAST-EDGE-POINTS
-      n = (int)_ptsEast.size();
-      elvtile.write((char*)&n, sizeof(int));
-      for (int i=0;i<n;i++)
-      {
-         _writeElevationPoint(elvtile, _ptsEast[i]);
-      }
+      oHeader.count[i] = vSections[i]->size();
+      oHeader.offset[i] = nOffset;
+      nOffset += vSections[i]->size()*nPointSize;
+   }
 
-      // [4] write SOUTH-EDGE-POINTS
-      n = (int)_ptsSouth.size();
-      elvtile.write((char*)&n, sizeof(int));
-      for (int i=0;i<n;i++)
-      {
-         _writeElevationPoint(elvtile, _ptsSouth[i]);
-      }
+   // create file in memory and write it at once
+   std::vector<double> vData((nOffset - sizeof(ElevationTileFileHeader)) / sizeof(double));
+   double* pOut = &vData[0];
 
-      // [5] write WEST-EDGE-POINTS
-      n = (int)_ptsWest.size();
-      elvtile.write((char*)&n, sizeof(int));
-      for (int i=0;i<n;i++)
-      {
-         _writeElevationPoint(elvtile, _ptsWest[i]);
-      }
+   pOut = _writeElevationPoint(pOut, _NW);
+   pOut = _writeElevationPoint(pOut, _NE);
+   pOut = _writeElevationPoint(pOut, _SE);
+   pOut = _writeElevationPoint(pOut, _SW);
 
-      // [6] write MIDDLE-POINTS
-      n = (int)_ptsMiddle.size();
-      elvtile.write((char*)&n, sizeof(int));
-      for (int i=0;i<n;i++)
+   for (int i=0;i<5;i++)
+   {
+      for (size_t j=0;j<vSections[i]->size();j++)
       {
-         _writeElevationPoint(elvtile, _ptsMiddle[i]);
+         pOut = _writeElevationPoint(pOut, (*vSections[i])[j]);
       }
    }
-   else
+
+   std::ofstream elvtile;
+   elvtile.open(sTempfilename.c_str(), std::ios::binary);
+
+   if (!elvtile.good())
    {
       return false;
    }
 
-   elvtile.close();
+   elvtile.write((const char*)&oHeader, sizeof(ElevationTileFileHeader));
+   elvtile.write((const char*)&vData[0], vData.size()*sizeof(double));
 
-   return true;
+   bool bOk = elvtile.good();
+   elvtile.close();
 
+   return bOk;
 }
 
 //------------------------------------------------------------------------------
-//#todo: add some error checking...
+
 bool ElevationTile::ReadBinary(const std::string& sTimefilename)
 {
    std::ifstream elvtile;
@@ -884,65 +980,60 @@ bool ElevationTile::ReadBinary(const std::string& sTimefilename)
 
    elvtile.open(sTimefilename.c_str(), std::ios::binary);
 
-   if (elvtile.good())
+   if (!elvtile.good())
    {
-      int n;
-      ElevationPoint pt;
-      // [0] read 2D boundary
-      elvtile.read((char*)&_x0, sizeof(double));
-      elvtile.read((char*)&_y0, sizeof(double));
-      elvtile.read((char*)&_x1, sizeof(double));
-      elvtile.read((char*)&_y1, sizeof(double));
-
-      // [1] read CORNER POINTS
-      _readElevationPoint(elvtile, _NW);
-      _readElevationPoint(elvtile, _NE);
-      _readElevationPoint(elvtile, _SE);
-      _readElevationPoint(elvtile, _SW);
-
-      // [2] read NORTH-EDGE-POINTS
-      elvtile.read((char*)&n, sizeof(int));
-      for (int i=0;i<n;i++)
-      {
-         _readElevationPoint(elvtile, pt);
-         _ptsNorth.push_back(pt);
-      }
+      return false;
+   }
 
-       // [3] read EAST-EDGE-POINTS
-      elvtile.read((char*)&n, sizeof(int));
-      for (int i=0;i<n;i++)
-      {
-         _readElevationPoint(elvtile, pt);
-         _ptsEast.push_back(pt);
-      }
+   // read whole file at once
+   elvtile.seekg(0, std::ios::end);
+   size_t nSize = (size_t)elvtile.tellg();
+   elvtile.seekg(0, std::ios::beg);
 
-       // [4] read SOUTH-EDGE-POINTS
-      elvtile.read((char*)&n, sizeof(int));
-      for (int i=0;i<n;i++)
-      {
-         _readElevationPoint(elvtile, pt);
-         _ptsSouth.push_back(pt);
-      }
+   const size_t nPointSize = 4*sizeof(double);
+   if (nSize < sizeof(ElevationTileFileHeader) + 4*nPointSize)
+   {
+      return false;
+   }
 
-      // [5] read WEST-EDGE-POINTS
-      elvtile.read((char*)&n, sizeof(int));
-      for (int i=0;i<n;i++)
-      {
-         _readElevationPoint(elvtile, pt);
-         _ptsWest.push_back(pt);
-      }
+   std::vector<double> vData((nSize + sizeof(double) - 1) / sizeof(double));
+   elvtile.read((char*)&vData[0], nSize);
+   elvtile.close();
 
-      // [6] read MIDDLE-POINTS
-      elvtile.read((char*)&n, sizeof(int));
-      for (int i=0;i<n;i++)
+   const char* pFile = (const char*)&vData[0];
+   const ElevationTileFileHeader* pHeader = (const ElevationTileFileHeader*)pFile;
+
+   if (memcmp(pHeader->magic, "OGTR", 4) != 0 || pHeader->version != ELEVATIONTILEFILE_VERSION)
+   {
+      return false;
+   }
+
+   for (int i=0;i<5;i++)
+   {
+      if (pHeader->offset[i] + pHeader->count[i]*nPointSize > nSize)
       {
-         _readElevationPoint(elvtile, pt);
-         _ptsMiddle.push_back(pt);
+         return false;
       }
    }
-   else
+
+   // [0] 2D boundary
+   _x0 = pHeader->x0;
+   _y0 = pHeader->y0;
+   _x1 = pHeader->x1;
+   _y1 = pHeader->y1;
+
+   // [1] CORNER POINTS
+   const double* pIn = (const double*)(pFile + sizeof(ElevationTileFileHeader));
+   pIn = _readElevationPoint(pIn, _NW);
+   pIn = _readElevationPoint(pIn, _NE);
+   pIn = _readElevationPoint(pIn, _SE);
+   pIn = _readElevationPoint(pIn, _SW);
+
+   // [2]-[6] EDGE and MIDDLE POINTS
+   std::vector<ElevationPoint>* vSections[5] = {&_ptsNorth, &_ptsEast, &_ptsSouth, &_ptsWest, &_ptsMiddle};
+   for (int i=0;i<5;i++)
    {
-      return false;
+      _readElevationPoints((const double*)(pFile + pHeader->offset[i]), (size_t)pHeader->count[i], *vSections[i]);
    }
 
    _bCategorized = true;
@@ -29,6 +29,14 @@
 
 #include <boost/shared_ptr.hpp>
 
+// Output format of terrain tiles
+enum ETerrainFormat
+{
+   TERRAINFORMAT_JSON = 1,       // .json
+   TERRAINFORMAT_BINARY = 2,     // .ogt (BinaryTerrainTile)
+   TERRAINFORMAT_BOTH = 3,
+};
+
 class OPENGLOBE_API ElevationTile
 {
 public:
@@ -58,6 +66,18 @@ public:
    // create JSON tile:
    std::string CreateJSON();
 
+   // Create JSON tile into existing string (memory of string is reused).
+   void CreateJSON(std::string& sJSON);
+
+   // create binary terrain tile (see BinaryTerrainTile.h) into existing string.
+   void CreateBinary(std::string& sData);
+
+   // create JSON and/or binary terrain tile, triangulation is only calculated once.
+   void CreateTerrain(ETerrainFormat eFormat, std::string& sJSON, std::string& sData);
+
+   // retrieve terrain format from string ("json", "binary" or "both"), returns false if invalid
+   static bool GetTerrainFormat(const std::string& sFormat, ETerrainFormat& eFormat);
+
    // write tile binary, returns true on success
    bool WriteBinary(const std::string& sTempfilename);
 
@@ -83,6 +103,8 @@ protected:
    void _Classify(std::vector<ElevationPoint>& pts);
    
    void _PrecomputeTriangulation(bool bCurtain);
+   void _WriteJSON(std::string& sJSON);
+   void _WriteBinaryTerrain(std::string& sData);
    void _CreateCurtain(double curtainelv, ElevationPoint& start, ElevationPoint& end, std::vector<ElevationPoint>& between,  int& idxA, int& idxB, int& idxC, int& idxD);
 
    ElevationPoint                _NW, _NE, _SE, _SW;
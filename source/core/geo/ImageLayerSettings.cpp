@@ -29,6 +29,8 @@ BeginPropertyMap(ImageLayerSettings);
   XMLProperty(ImageLayerSettings, "maxlod", _maxlod);
   XMLProperty(ImageLayerSettings, "extent", _tilecoord);
   XMLProperty(ImageLayerSettings, "format", _sFormat);
+  XMLProperty(ImageLayerSettings, "pnglevel", _pnglevel);
+  XMLProperty(ImageLayerSettings, "pngfilter", _sPNGFilter);
 EndPropertyMap(ImageLayerSettings);
 //------------------------------------------------------------------------------
 
@@ -42,6 +44,7 @@ ImageLayerSettings::ImageLayerSettings()
    _sLayertype = "image";
    _sFormat = "png";
    _maxlod = 0;
+   _pnglevel = -1;
    _srs = "EPSG:3857";
    _tilecoord.push_back(0);
    _tilecoord.push_back(0);
@@ -50,6 +53,23 @@ ImageLayerSettings::ImageLayerSettings()
 }
 
 
+//------------------------------------------------------------------------------
+
+bool ImageLayerSettings::GetPNGSettings(PNGSettings& settings)
+{
+   if (_pnglevel >= 0)
+   {
+      settings.nLevel = _pnglevel;
+   }
+
+   if (_sPNGFilter.length() > 0)
+   {
+      return settings.SetFilter(_sPNGFilter);
+   }
+
+   return true;
+}
+
 //------------------------------------------------------------------------------
 // Load ImageLayerSettings from XML:
 boost::shared_ptr<ImageLayerSettings> ImageLayerSettings::Load(const std::string& layerdir)
@@ -20,6 +20,7 @@
 #define _IMAGELAYERSETTINGS_H
 
 #include "og.h"
+#include "image/ImageWriter.h"
 #include <boost/shared_ptr.hpp>
 #include <string>
 #include <vector>
@@ -36,12 +37,22 @@ public:
    void SetTileExtent(int64 x0, int64 y0, int64 x1, int64 y1) { _tilecoord[0] = x0; _tilecoord[1] = y0; _tilecoord[2] = x1; _tilecoord[3] = y1;}
    // set format (short form: "png" or "jpg")
    void SetFormat(const std::string& sFormat){_sFormat = sFormat;}
+   // set png compression level (0-9, -1: default level)
+   void SetPNGLevel(int level) {_pnglevel = level;}
+   // set png filter ("none", "sub", "up", "average", "paeth", "adaptive" or empty for default filter)
+   void SetPNGFilter(const std::string& sFilter) {_sPNGFilter = sFilter;}
 
    std::string GetLayerName(){return _sLayername;}
    std::string GetFormat(){return _sFormat;}
    int GetMaxLod(){return _maxlod;}
+   int GetPNGLevel(){return _pnglevel;}
+   std::string GetPNGFilter(){return _sPNGFilter;}
    void GetTileExtent(int64& x0, int64& y0, int64& x1, int64& y1){x0 = _tilecoord[0]; y0 = _tilecoord[1]; x1 = _tilecoord[2]; y1 = _tilecoord[3];}
 
+   // Apply png level and filter of this layer to settings (values not set in layer remain unchanged).
+   // Returns false if png filter is unknown.
+   bool GetPNGSettings(PNGSettings& settings);
+
    // Load from XML
    static boost::shared_ptr<ImageLayerSettings> Load(const std::string& layerdir);
 
@@ -55,6 +66,8 @@ protected:
    std::string _srs;
    std::vector<int64> _tilecoord;
    std::string  _sFormat;
+   int          _pnglevel;
+   std::string  _sPNGFilter;
    
 
 private:
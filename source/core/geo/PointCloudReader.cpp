@@ -1,22 +1,150 @@
-
-
 #include "PointCloudReader.h"
 #include <cassert>
+#include <cstring>
 #include "math/mathutils.h"
 #include "geo/CoordinateTransformation.h"
 #include "math/CloudPoint.h"
 #include "string/StringUtils.h"
 #include "string/FilenameUtils.h"
+#include "string/NumberFormat.h"
 #include "io/FileSystem.h"
-#include "xml/xml.h"
-#include <boost/tokenizer.hpp>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+   const size_t DEFAULTBLOCKSIZE = 32*1024*1024;
+   const size_t MINPARTSIZE = 256*1024;   // minimal size of a part parsed by one thread
+   const int MAXCOLUMNS = 7;
+
+   //--------------------------------------------------------------------------
+   // LAS file (little endian)
+
+   const size_t LAS_HEADERSIZE_10 = 227;  // LAS 1.0 - 1.2
+   const size_t LAS_HEADERSIZE_14 = 375;  // LAS 1.4
+
+   template<typename T>
+   inline T _GetLE(const char* p)
+   {
+      T value;
+      memcpy(&value, p, sizeof(T));
+      return value;
+   }
+
+   // size of point data record formats 0 to 10 (records can contain extra bytes)
+   const size_t s_LASRecordSize[] = {20, 28, 26, 34, 57, 63, 30, 36, 38, 59, 67};
+
+   // offset of RGB in point data record, 0: no color
+   const size_t s_LASColorOffset[] = {0, 0, 20, 28, 0, 28, 0, 30, 30, 0, 30};
+
+   //--------------------------------------------------------------------------
+
+   // tokens for value separation in ASCII point cloud
+   inline bool _IsSeparator(char c)
+   {
+      return c == ' ' || c == ',' || c == '\t' || c == ';';
+   }
+
+   //--------------------------------------------------------------------------
+   // Parse values of line [pBegin, pEnd) into vValues (up to MAXCOLUMNS values), 
+   // returns number of columns.
+
+   inline int _ParseLine(const char* pBegin, const char* pEnd, double* vValues)
+   {
+      // windows line ending
+      if (pEnd > pBegin && *(pEnd-1) == '\r')
+      {
+         pEnd--;
+      }
+
+      int nColumns = 0;
+      const char* p = pBegin;
+      while (p < pEnd)
+      {
+         while (p < pEnd && _IsSeparator(*p)) p++;
+         if (p == pEnd) break;
+
+         const char* pToken = p;
+         while (p < pEnd && !_IsSeparator(*p)) p++;
+
+         if (nColumns < MAXCOLUMNS)
+         {
+            vValues[nColumns] = NumberFormat::ParseFloat(pToken, p);
+         }
+         nColumns++;
+      }
+
+      return nColumns;
+   }
+
+   //--------------------------------------------------------------------------
+   // Parse all lines of [pBegin, pEnd) and append points to vPoints.
+
+   void _ParseLines(const char* pBegin, const char* pEnd, PointCloudType pct, std::vector<CloudPoint>& vPoints)
+   {
+      double v[MAXCOLUMNS];
+      CloudPoint point;
+
+      const char* p = pBegin;
+      while (p < pEnd)
+      {
+         const char* pLineEnd = (const char*)memchr(p, '\n', pEnd-p);
+         if (!pLineEnd) pLineEnd = pEnd;
+
+         for (int i=0;i<MAXCOLUMNS;i++) v[i] = 0;  // missing columns are 0
+         int nColumns = _ParseLine(p, pLineEnd, v);
+         p = pLineEnd + 1;
+
+         if (nColumns >= 3)
+         {
+            point.x = v[0];
+            point.y = v[1];
+            point.elevation = v[2];
+
+            if (pct == PCT_XYZI)
+            {
+               point.intensity = (int)v[3];
+            }
+            else if (pct == PCT_XYZRGB)
+            {
+               point.r = (unsigned char)v[3];
+               point.g = (unsigned char)v[4];
+               point.b = (unsigned char)v[5];
+            }
+            else if (pct == PCT_XYZIRGB)
+            {
+               point.intensity = (int)v[3];
+               point.r = (unsigned char)v[4];
+               point.g = (unsigned char)v[5];
+               point.b = (unsigned char)v[6];
+            }
+
+            vPoints.push_back(point);
+         }
+      }
+   }
+}
 
 //-----------------------------------------------------------------------------
 
 PointCloudReader::PointCloudReader()
 {
-   _line.resize(4096);
-   _separators = " ,\t;"; // tokens for value separation in ASCII point cloud
+   _nSourceEPSG = 0;
+   _pct = PCT_INVALID;
+   _ptsread = 0;
+   _nBlockSize = DEFAULTBLOCKSIZE;
+   _nSize = 0;
+   _nBlockEnd = 0;
+   _bEOF = true;
+   _nCurrent = 0;
+   _bLAS = false;
+   _nLASFormat = 0;
+   _nLASRecordLength = 0;
+   _nLASPoints = 0;
+   _nLASColorShift = -1;
 }
 
 //-----------------------------------------------------------------------------
@@ -34,46 +162,275 @@ bool PointCloudReader::Open(const std::string& sFilename, int nSourceEPSG)
    {
       _ifstream.close();
    }
+   _ifstream.clear();
 
    _nSourceEPSG = nSourceEPSG;
    _sFilenameA = sFilename;
    _ptsread = 0;
+   _pct = PCT_INVALID;
+   _nSize = 0;
+   _nBlockEnd = 0;
+   _vPoints.clear();
+   _nCurrent = 0;
+
+   // binary mode: windows line endings are handled by the parser
+   _ifstream.open(sFilename.c_str(), std::ios::in | std::ios::binary);
+   _bEOF = !_ifstream.good();
+   _bLAS = false;
+
+   if (!_ifstream.good())
+   {
+      return false;
+   }
+
+   // LAS files start with "LASF"
+   char signature[4] = {0, 0, 0, 0};
+   _ifstream.read(signature, 4);
+   _bLAS = (_ifstream.gcount() == 4 && memcmp(signature, "LASF", 4) == 0);
+   _ifstream.clear();
+   _ifstream.seekg(0, std::ios::beg);
+
+   if (_bLAS)
+   {
+      return _OpenLAS();
+   }
+
+   return _ifstream.good();
+}
+
+//-----------------------------------------------------------------------------
+
+bool PointCloudReader::_OpenLAS()
+{
+   char header[LAS_HEADERSIZE_14];
+   memset(header, 0, sizeof(header));
+   _ifstream.read(header, LAS_HEADERSIZE_14);
+   size_t nRead = (size_t)_ifstream.gcount();
+   _ifstream.clear();
+
+   int nVersionMajor = (unsigned char)header[24];
+   int nVersionMinor = (unsigned char)header[25];
+   size_t nHeaderSize = _GetLE<unsigned short>(header + 94);
+   uint64 nOffsetToPoints = _GetLE<unsigned int>(header + 96);
+   int nFormat = (unsigned char)header[104];
+   _nLASRecordLength = _GetLE<unsigned short>(header + 105);
+   _nLASPoints = _GetLE<unsigned int>(header + 107);
+
+   for (int i=0;i<3;i++)
+   {
+      _vLASScale[i] = _GetLE<double>(header + 131 + 8*i);
+      _vLASOffset[i] = _GetLE<double>(header + 155 + 8*i);
+   }
 
-   _ifstream.open(sFilename.c_str());
+   if (nRead < LAS_HEADERSIZE_10 || nHeaderSize < LAS_HEADERSIZE_10 || nVersionMajor != 1 || nVersionMinor > 4)
+   {
+      Close();
+      return false;  // invalid header or unsupported version
+   }
 
+   // LAS 1.4: 64 bit number of point records (legacy number is 0 for more than 2^32 points)
+   if (nVersionMinor >= 4 && nHeaderSize >= LAS_HEADERSIZE_14 && nRead >= LAS_HEADERSIZE_14 && _nLASPoints == 0)
+   {
+      _nLASPoints = _GetLE<uint64>(header + 247);
+   }
+
+   // bits 7 and 6 of the format are set for compressed data (LAZ)
+   if (nFormat > 10 || _nLASRecordLength < s_LASRecordSize[nFormat])
+   {
+      Close();
+      return false;
+   }
+
+   _nLASFormat = nFormat;
+   _nLASColorShift = -1;
+   _pct = s_LASColorOffset[nFormat] ? PCT_XYZIRGB : PCT_XYZI;
+
+   _ifstream.seekg((std::streamoff)nOffsetToPoints, std::ios::beg);
+   _bEOF = !_ifstream.good();
 
    return _ifstream.good();
 }
 
 //-----------------------------------------------------------------------------
 
+bool PointCloudReader::_ReadPointsLAS(std::vector<CloudPoint>& vPoints)
+{
+   if (_bEOF || _ptsread >= _nLASPoints)
+   {
+      return false;
+   }
+
+   // read block of records
+   uint64 nRecords = math::Max<size_t>(_nBlockSize / _nLASRecordLength, 1);
+   nRecords = math::Min<uint64>(nRecords, _nLASPoints - _ptsread);
+
+   size_t nBytes = size_t(nRecords) * _nLASRecordLength;
+   if (_vBuffer.size() < nBytes)
+   {
+      _vBuffer.resize(nBytes);
+   }
+
+   _ifstream.read(&_vBuffer[0], nBytes);
+   nRecords = (size_t)_ifstream.gcount() / _nLASRecordLength;  // file may be truncated
+   if (!_ifstream.good())
+   {
+      _bEOF = true;
+   }
+
+   if (nRecords == 0)
+   {
+      return false;
+   }
+
+   const char* pData = &_vBuffer[0];
+   const size_t nRecordLength = _nLASRecordLength;
+   const size_t nColorOffset = s_LASColorOffset[_nLASFormat];
+
+   // 8 or 16 bit colors
+   if (nColorOffset && _nLASColorShift < 0)
+   {
+      _nLASColorShift = 0;
+      for (size_t i=0;i<size_t(nRecords) && _nLASColorShift == 0;i++)
+      {
+         const char* pColor = pData + i*nRecordLength + nColorOffset;
+         if (_GetLE<unsigned short>(pColor) > 255 || _GetLE<unsigned short>(pColor+2) > 255 || _GetLE<unsigned short>(pColor+4) > 255)
+         {
+            _nLASColorShift = 8;
+         }
+      }
+   }
+   const int nShift = _nLASColorShift;
+
+   vPoints.resize(size_t(nRecords));
+   CloudPoint* pPoints = &vPoints[0];
+   int nCount = (int)nRecords;
+
+   #pragma omp parallel for
+   for (int i=0;i<nCount;i++)
+   {
+      const char* pRecord = pData + size_t(i)*nRecordLength;
+      CloudPoint& point = pPoints[i];
+
+      point.x = double(_GetLE<int>(pRecord)) * _vLASScale[0] + _vLASOffset[0];
+      point.y = double(_GetLE<int>(pRecord+4)) * _vLASScale[1] + _vLASOffset[1];
+      point.elevation = double(_GetLE<int>(pRecord+8)) * _vLASScale[2] + _vLASOffset[2];
+      point.intensity = _GetLE<unsigned short>(pRecord+12);
+
+      if (nColorOffset)
+      {
+         const char* pColor = pRecord + nColorOffset;
+         point.r = (unsigned char)math::Min<int>(_GetLE<unsigned short>(pColor) >> nShift, 255);
+         point.g = (unsigned char)math::Min<int>(_GetLE<unsigned short>(pColor+2) >> nShift, 255);
+         point.b = (unsigned char)math::Min<int>(_GetLE<unsigned short>(pColor+4) >> nShift, 255);
+      }
+   }
+
+   _ptsread += size_t(nRecords);
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+
 void PointCloudReader::Close()
 {
    _ifstream.close();
+   _bEOF = true;
+   _nSize = 0;
+   _nBlockEnd = 0;
+   _vPoints.clear();
+   _nCurrent = 0;
 }
 
 //-----------------------------------------------------------------------------
 
-bool PointCloudReader::ReadPoint(CloudPoint& point)
+bool PointCloudReader::_ReadBlock(const char*& pBegin, const char*& pEnd)
+{
+   // move incomplete last line of previous block to the beginning
+   size_t nRemaining = _nSize - _nBlockEnd;
+   if (nRemaining > 0 && _nBlockEnd > 0)
+   {
+      memmove(&_vBuffer[0], &_vBuffer[_nBlockEnd], nRemaining);
+   }
+   _nSize = nRemaining;
+   _nBlockEnd = 0;
+
+   while (true)
+   {
+      if (_bEOF)
+      {
+         // last line of file (without newline)
+         if (_nSize == 0) return false;
+         _nBlockEnd = _nSize;
+         break;
+      }
+
+      // a line longer than the block enlarges the buffer
+      size_t nCapacity = math::Max<size_t>(_nBlockSize, 2*_nSize);
+      if (_vBuffer.size() < nCapacity)
+      {
+         _vBuffer.resize(nCapacity);
+      }
+
+      _ifstream.read(&_vBuffer[_nSize], _vBuffer.size()-_nSize);
+      _nSize += (size_t)_ifstream.gcount();
+      if (!_ifstream.good())
+      {
+         _bEOF = true;
+      }
+
+      // complete lines only
+      size_t nEnd = _nSize;
+      while (nEnd > 0 && _vBuffer[nEnd-1] != '\n')
+      {
+         nEnd--;
+      }
+
+      if (nEnd > 0)
+      {
+         _nBlockEnd = nEnd;
+         break;
+      }
+   }
+
+   pBegin = &_vBuffer[0];
+   pEnd = pBegin + _nBlockEnd;
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool PointCloudReader::ReadPoints(std::vector<CloudPoint>& vPoints)
 {
-   char* line = &_line[0];
-   std::vector<double> vOut;
+   vPoints.clear();
 
-   while (!_ifstream.eof())
+   if (_bLAS)
    {
-      _ifstream.getline(line, 4095);
-      std::string string_line(line);
-      Tokenize(string_line, _separators, vOut);
-      size_t numColumns = vOut.size();
+      return _ReadPointsLAS(vPoints);
+   }
+
+   const char* pBegin;
+   const char* pEnd;
 
-      if (_ptsread == 0) // first point!
+   while (vPoints.empty())
+   {
+      if (!_ReadBlock(pBegin, pEnd))
       {
+         return false;
+      }
+
+      if (_ptsread == 0)
+      {
+         // first line defines point cloud type
+         const char* pLineEnd = (const char*)memchr(pBegin, '\n', pEnd-pBegin);
+         double v[MAXCOLUMNS];
+         int numColumns = _ParseLine(pBegin, pLineEnd ? pLineEnd : pEnd, v);
+
          if (numColumns == 3)
          {
             // Reading XYZ Point Cloud
             _pct = PCT_XYZ;
          }
-         if (numColumns == 4)
+         else if (numColumns == 4)
          {
             // Reading XYZI Point Cloud
             _pct = PCT_XYZI;
@@ -90,45 +447,76 @@ bool PointCloudReader::ReadPoint(CloudPoint& point)
          }
          else
          {
-             // pc is not valid!
+            // pc is not valid!
             _pct = PCT_INVALID;
+            _bEOF = true;
+            _nSize = _nBlockEnd = 0;
             return false;
          }
       }
 
-      if (vOut.size() >= 3 && vOut.size() == numColumns)
+      // split block into parts on line boundaries, parts are parsed in parallel
+      int nParts = 1;
+#ifdef _OPENMP
+      nParts = 4*omp_get_max_threads();
+#endif
+      nParts = (int)math::Clamp<size_t>(size_t(pEnd-pBegin)/MINPARTSIZE, 1, size_t(nParts));
+
+      std::vector<const char*> vSplit(nParts+1);
+      vSplit[0] = pBegin;
+      for (int i=1;i<nParts;i++)
       {
-         point.x = vOut[0];
-         point.y = vOut[1];
-         point.elevation = vOut[2];
+         const char* p = math::Max<const char*>(pBegin + size_t(pEnd-pBegin)*i/nParts, vSplit[i-1]);
+         const char* pLineEnd = (const char*)memchr(p, '\n', pEnd-p);
+         vSplit[i] = pLineEnd ? pLineEnd+1 : pEnd;
+      }
+      vSplit[nParts] = pEnd;
 
-         if (_pct == PCT_XYZI)
-         {
-            point.intensity = (int)vOut[3];
-         }
-         else if (_pct == PCT_XYZRGB)
-         {
-            point.r = (unsigned char)vOut[3];
-            point.g = (unsigned char)vOut[4];
-            point.b = (unsigned char)vOut[5];
-         }
-         else if (_pct == PCT_XYZIRGB)
-         {
-            point.intensity = (int)vOut[3];
-            point.r = (unsigned char)vOut[4];
-            point.g = (unsigned char)vOut[5];
-            point.b = (unsigned char)vOut[6];
-         }
+      if ((int)_vParts.size() < nParts)
+      {
+         _vParts.resize(nParts);
+      }
 
-         _ptsread++;
-         return true;
+      #pragma omp parallel for schedule(dynamic,1)
+      for (int i=0;i<nParts;i++)
+      {
+         _vParts[i].clear();
+         _ParseLines(vSplit[i], vSplit[i+1], _pct, _vParts[i]);
       }
+
+      size_t nPoints = 0;
+      for (int i=0;i<nParts;i++)
+      {
+         nPoints += _vParts[i].size();
+      }
+
+      vPoints.reserve(nPoints);
+      for (int i=0;i<nParts;i++)
+      {
+         vPoints.insert(vPoints.end(), _vParts[i].begin(), _vParts[i].end());
+      }
+
+      _ptsread += nPoints;
    }
 
-   return false;
+   return true;
 }
 
-//------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
 
+bool PointCloudReader::ReadPoint(CloudPoint& point)
+{
+   if (_nCurrent >= _vPoints.size())
+   {
+      _nCurrent = 0;
+      if (!ReadPoints(_vPoints))
+      {
+         return false;
+      }
+   }
 
+   point = _vPoints[_nCurrent++];
+   return true;
+}
 
+//------------------------------------------------------------------------------
@@ -39,6 +39,13 @@ enum PointCloudType
 
 //! \class PointCloudReader
 //! \author Martin Christen, martin.christen@fhnw.ch
+//! ASCII point clouds are read in large blocks which are split on line 
+//! boundaries and parsed in parallel (OpenMP).
+//! Uncompressed LAS 1.0 - 1.4 files (point data record formats 0 to 10) are
+//! detected by file signature and read natively: coordinates are scaled, 
+//! intensity and RGB are copied. LAS colors are 16 bit, they are converted to
+//! 8 bit unless all colors of the first block are below 256 (8 bit colors, 
+//! which are written by some software).
 class OPENGLOBE_API PointCloudReader
 {
 public:
@@ -53,20 +60,48 @@ public:
 
    // Reads next point (normalized mercator coordinates + orthometric elevation). Returns false when all points are read.
    bool ReadPoint(CloudPoint& point);
+
+   // Reads next batch of points (all points of the next block of the file), vPoints is cleared first.
+   // Returns false when all points are read.
+   bool ReadPoints(std::vector<CloudPoint>& vPoints);
  
-   //! Get Point Cloud type (valid after reading first point)
+   //! Get Point Cloud type (valid after reading first point, LAS: after Open)
    PointCloudType GetPointCloudtype(){return _pct;}
 
+   //! Set size of blocks read from file (in bytes). Default is 32 MB.
+   void SetBlockSize(size_t nBlockSize) {_nBlockSize = nBlockSize;}
+
+   //! Returns true if file is a LAS file.
+   bool IsLAS() {return _bLAS;}
 
 private:
+   bool _ReadBlock(const char*& pBegin, const char*& pEnd);
+   bool _OpenLAS();
+   bool _ReadPointsLAS(std::vector<CloudPoint>& vPoints);
+
    std::ifstream  _ifstream;
    int            _nSourceEPSG;
    std::string    _sFilenameA;
    PointCloudType _pct;
-   std::string    _line;
-   std::string    _separators;
    size_t         _ptsread;
+   size_t         _nBlockSize;
+   std::vector<char>       _vBuffer;      // current block
+   size_t                  _nSize;        // number of bytes in _vBuffer
+   size_t                  _nBlockEnd;    // end of complete lines in _vBuffer
+   bool                    _bEOF;         // end of file reached
+   std::vector<CloudPoint> _vPoints;      // current batch for ReadPoint
+   size_t                  _nCurrent;     // next point in _vPoints
+   std::vector< std::vector<CloudPoint> > _vParts;  // points of parts parsed in parallel
+
+   // LAS
+   bool           _bLAS;
+   int            _nLASFormat;         // point data record format
+   size_t         _nLASRecordLength;   // size of point data record in bytes
+   uint64         _nLASPoints;         // number of point records
+   double         _vLASScale[3];
+   double         _vLASOffset[3];
+   int            _nLASColorShift;     // 8: 16 bit colors, 0: 8 bit colors, -1: unknown
 
 };
 
-#endif
\ No newline at end of file
+#endif
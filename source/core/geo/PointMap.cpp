@@ -19,6 +19,12 @@
 #ifdef _USE_POINTS
 
 #include "PointMap.h"
+#include "data/LRUCache.h"
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
 
 #pragma warning (disable : 4290 )
 #pragma warning (disable : 4250 )
@@ -56,6 +62,19 @@ struct cmp : public std::less<key_type>
 typedef stxxl::map<key_type, data_type, cmp, BLOCK_SIZE, BLOCK_SIZE> map_type;
 typedef map_type::iterator map_iterator;
 
+// open .dat file, closed when removed from cache
+struct VoxelFile
+{
+   VoxelFile(FILE* file, const PointVoxelFileHeader& header) : f(file), oHeader(header) {}
+   ~VoxelFile() { fclose(f); }
+
+   FILE*                   f;
+   PointVoxelFileHeader    oHeader;    // header of file, attributes may differ from PointMap
+};
+
+typedef boost::shared_ptr<VoxelFile> VoxelFilePtr;
+typedef LRUCache<int64, VoxelFilePtr> FileCache;
+
 class PointMap_private
 {
 public:
@@ -64,10 +83,15 @@ public:
    {  
       _index = new map_type(CACHE_SIZE * BLOCK_SIZE / 2, CACHE_SIZE * BLOCK_SIZE / 2);
       _resetiterator = true;
+      _files = new FileCache(256);
    }
    // dtor
    virtual ~PointMap_private()
    {
+      if (_files)
+      {
+         delete _files;
+      }
       if (_index)
       {
          delete _index;
@@ -77,20 +101,141 @@ public:
    map_type* _index;
    bool      _resetiterator;
    map_iterator _it;
+   // open files
+   FileCache* _files;
    
 };
 
+//------------------------------------------------------------------------
+
+static inline size_t _HashKey(int64 key)
+{
+   uint64 h = uint64(key);
+   h ^= h >> 33;
+   h *= 0xff51afd7ed558ccdULL;
+   h ^= h >> 33;
+   return size_t(h);
+}
+
+//------------------------------------------------------------------------
+// Create directories of voxel file, returns false on error.
+
+static bool _MakeSubdirs(const std::string& sFilename)
+{
+   try
+   {
+      return FileSystem::makeallsubdirs(sFilename);
+   }
+   catch (std::exception const&)
+   {
+      return false;
+   }
+}
+
+//------------------------------------------------------------------------
+// Open voxel file for appending. New files get the header oHeader. Files
+// without header or with less attributes than oHeader are converted, an
+// incomplete record at the end (failed write) is removed. The file must be
+// locked if other processes write to it.
+
+static VoxelFilePtr _OpenVoxelFile(const std::string& sFilename, const PointVoxelFileHeader& oHeader)
+{
+   FILE* f = fopen(sFilename.c_str(), "a+b");
+   if (!f)
+   {
+      _MakeSubdirs(sFilename);
+      f = fopen(sFilename.c_str(), "a+b");
+   }
+   if (!f)
+   {
+      return VoxelFilePtr();
+   }
+
+   // unbuffered: every bucket is written with one call, data is on disk when ExportData returns.
+   setvbuf(f, 0, _IONBF, 0);
+
+   PointVoxelFileHeader oFileHeader = oHeader;
+   fseek(f, 0, SEEK_END);
+   long size = ftell(f);
+   if (size == 0)
+   {
+      if (fwrite(&oFileHeader, sizeof(PointVoxelFileHeader), 1, f) != 1)
+      {
+         fclose(f);
+         return VoxelFilePtr();
+      }
+   }
+   else if (!PointVoxelFile::ReadHeader(f, oFileHeader) || (oFileHeader.attributes | oHeader.attributes) != oFileHeader.attributes ||
+      (size - sizeof(PointVoxelFileHeader)) % oFileHeader.recordsize != 0)
+   {
+      fclose(f);
+
+      std::vector<CloudPoint> vPoints;
+      unsigned int attributes = 0;
+      PointVoxelFile::Read(sFilename, vPoints, &attributes);
+      PointVoxelFile::InitHeader(oFileHeader, oHeader.lod, oHeader.i, oHeader.j, oHeader.k, attributes | oHeader.attributes);
+      if (!PointVoxelFile::Write(sFilename, oFileHeader, vPoints))
+      {
+         return VoxelFilePtr();
+      }
+
+      f = fopen(sFilename.c_str(), "a+b");
+      if (!f)
+      {
+         return VoxelFilePtr();
+      }
+      setvbuf(f, 0, _IONBF, 0);
+   }
+
+   fseek(f, 0, SEEK_END);
+   return VoxelFilePtr(new VoxelFile(f, oFileHeader));
+}
+
+//------------------------------------------------------------------------
+// Returns true if points with header oHeader can be appended to the open
+// file without losing attributes. With bCheckFile the header and size are
+// read again, another process may have converted the file.
+
+static bool _IsCurrent(VoxelFile& oFile, const PointVoxelFileHeader& oHeader, bool bCheckFile)
+{
+   if ((oFile.oHeader.attributes | oHeader.attributes) != oFile.oHeader.attributes)
+   {
+      return false;
+   }
+
+   if (bCheckFile)
+   {
+      PointVoxelFileHeader oFileHeader;
+      if (!PointVoxelFile::ReadHeader(oFile.f, oFileHeader) || oFileHeader.attributes != oFile.oHeader.attributes)
+      {
+         return false;
+      }
+      fseek(oFile.f, 0, SEEK_END);
+      if ((ftell(oFile.f) - sizeof(PointVoxelFileHeader)) % oFile.oHeader.recordsize != 0)
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
 //------------------------------------------------------------------------
 PointMap::PointMap(int levelofdetail)
 {
    _numpts = 0;
    _numkeys = 0;
+   _numindexed = 0;
+   _memorybudget = 64*1024*1024;
+   _memoryused = 0;
+   _attributes = POINTATTRIB_ALL;
+   _lock = true;
+   _recordsize = PointVoxelFile::GetRecordSize(_attributes);
    _lod = levelofdetail;
    _pow = int64(1) << _lod; 
    _dpow = _pow * _pow;
    _pPriv = new PointMap_private();
-
-   
+   _Rehash(1024);
 }
 //------------------------------------------------------------------------
 PointMap::~PointMap()
@@ -104,9 +249,79 @@ PointMap::~PointMap()
 //------------------------------------------------------------------------
 void PointMap::Clear()
 {
-   _map.clear();
+   // keys of the cleared buckets must remain in the index
+   _UpdateIndex();
+
+   for (size_t b=0;b<_numkeys;b++)
+   {
+      _vBuckets[b].clear();
+   }
+
+   // buckets are reused for the next points (memory stays reserved), unless they use more than half of the budget
+   if (2*_memoryused > _memorybudget)
+   {
+      std::vector<std::vector<unsigned char> >().swap(_vBuckets);
+      std::vector<int64>().swap(_vBucketKey);
+      std::vector<PointVoxelFileHeader>().swap(_vBucketHeader);
+      _memoryused = 0;
+   }
+
+   _vSlotBucket.assign(_vSlotBucket.size(), -1);
    _numpts = 0;
    _numkeys = 0;
+   _numindexed = 0;
+}
+//------------------------------------------------------------------------
+size_t PointMap::_FindSlot(int64 key) const
+{
+   size_t mask = _vSlotKey.size()-1;
+   size_t s = _HashKey(key) & mask;
+   while (_vSlotBucket[s] >= 0 && _vSlotKey[s] != key)
+   {
+      s = (s+1) & mask;  // linear probing
+   }
+   return s;
+}
+//------------------------------------------------------------------------
+void PointMap::_Rehash(size_t nSize)
+{
+   _vSlotKey.assign(nSize, 0);
+   _vSlotBucket.assign(nSize, -1);
+   for (size_t b=0;b<_numkeys;b++)
+   {
+      size_t s = _FindSlot(_vBucketKey[b]);
+      _vSlotKey[s] = _vBucketKey[b];
+      _vSlotBucket[s] = int(b);
+   }
+}
+//------------------------------------------------------------------------
+void PointMap::_UpdateIndex()
+{
+   if (_numindexed == _numkeys)
+   {
+      return;
+   }
+
+   // insert new keys sorted, this keeps the accessed blocks of the index together.
+   // Empty buckets were not written (see ExportData) and are not indexed.
+   std::vector<int64> vNewKeys;
+   vNewKeys.reserve(_numkeys - _numindexed);
+   for (size_t b=_numindexed;b<_numkeys;b++)
+   {
+      if (_vBuckets[b].size() > 0)
+      {
+         vNewKeys.push_back(_vBucketKey[b]);
+      }
+   }
+   std::sort(vNewKeys.begin(), vNewKeys.end());
+
+   for (size_t n=0;n<vNewKeys.size();n++)
+   {
+      _pPriv->_index->insert(std::pair<int64,unsigned int>(vNewKeys[n], 0));
+   }
+
+   _numindexed = _numkeys;
+   _pPriv->_resetiterator = true;
 }
 //------------------------------------------------------------------------
 void PointMap::AddPoint(int64 i, int64 j, int64 k, const CloudPoint& pt)
@@ -114,24 +329,44 @@ void PointMap::AddPoint(int64 i, int64 j, int64 k, const CloudPoint& pt)
    int64 key = _dpow*k + _pow*j + i;
 
    _numpts++;
-   
-   std::map<int64, std::list<CloudPoint> >::iterator it;
-   it = _map.find(key);
-   if (it != _map.end())
-   {
-      // this key already exists, append point
-      it->second.push_back(pt);
-   }
-   else
+
+   size_t s = _FindSlot(key);
+   int bucket = _vSlotBucket[s];
+   if (bucket < 0)
    {
-      // this key doesn't exist yet. create new entry
-      std::list<CloudPoint> newList;
-      newList.push_back(pt);
-      _map.insert(std::pair<int64, std::list<CloudPoint> >(key, newList));
-      _numkeys++;
+      // this key doesn't exist yet. create new bucket
+      if (2*(_numkeys+1) > _vSlotKey.size())
+      {
+         _Rehash(2*_vSlotKey.size());
+         s = _FindSlot(key);
+      }
 
-      _pPriv->_index->insert(std::pair<int64,unsigned int>(key, 0));
+      bucket = int(_numkeys++);
+      if (size_t(bucket) == _vBuckets.size())
+      {
+         _vBuckets.push_back(std::vector<unsigned char>());
+         _vBucketKey.push_back(key);
+         _vBucketHeader.push_back(PointVoxelFileHeader());
+         _memoryused += sizeof(std::vector<unsigned char>) + sizeof(int64) + sizeof(PointVoxelFileHeader);
+      }
+      else
+      {
+         _vBucketKey[bucket] = key;
+      }
+      PointVoxelFile::InitHeader(_vBucketHeader[bucket], _lod, i, j, k, _attributes);
+
+      _vSlotKey[s] = key;
+      _vSlotBucket[s] = bucket;
    }
+
+   // append point record to bucket
+   std::vector<unsigned char>& vBucket = _vBuckets[bucket];
+   size_t offset = vBucket.size();
+   size_t capacity = vBucket.capacity();
+   vBucket.resize(offset + _recordsize);
+   PointVoxelFile::Encode(_vBucketHeader[bucket], pt, &vBucket[offset]);
+
+   _memoryused += vBucket.capacity() - capacity;
 }
 //------------------------------------------------------------------------
 size_t PointMap::GetNumPoints()
@@ -139,69 +374,176 @@ size_t PointMap::GetNumPoints()
    return _numpts;
 }
 //------------------------------------------------------------------------
-
-void PointMap::ExportData(const std::string& path)
+size_t PointMap::GetNumVoxels()
 {
-   std::map<int64, std::list<CloudPoint> >::iterator it = _map.begin();
-
-   while (it != _map.end())
-   {
-      int64 key = it->first;
-      int64 i,j,k;
+   return _numkeys;
+}
+//------------------------------------------------------------------------
+void PointMap::SetMemoryBudget(size_t nBytes)
+{
+   _memorybudget = nBytes;
+}
+//------------------------------------------------------------------------
+void PointMap::SetAttributes(unsigned int attributes)
+{
+   _attributes = attributes & POINTATTRIB_ALL;
+   _recordsize = PointVoxelFile::GetRecordSize(_attributes);
+}
+//------------------------------------------------------------------------
+unsigned int PointMap::GetAttributes()
+{
+   return _attributes;
+}
+//------------------------------------------------------------------------
+bool PointMap::IsFull()
+{
+   return _memoryused + _vSlotKey.size()*(sizeof(int64) + sizeof(int)) >= _memorybudget;
+}
+//------------------------------------------------------------------------
+void PointMap::SetMaxOpenFiles(size_t nFiles)
+{
+   delete _pPriv->_files;
+   _pPriv->_files = new FileCache(nFiles > 0 ? nFiles : 1);
+}
+//------------------------------------------------------------------------
+void PointMap::SetFileLocking(bool bLock)
+{
+   _lock = bLock;
+}
+//------------------------------------------------------------------------
+std::string PointMap::GetFilename(const std::string& path, int64 key)
+{
+   int64 i,j,k;
+   GetCoord(key, i, j, k);
 
-      k = key / _dpow;
-      j = (key - _dpow*k) / _pow;
-      i = key - _dpow*k - j*_pow;
+   std::ostringstream oss;
+   oss << path << _lod << "/" << i << "/" << j << "-" << k << ".dat";
+   return oss.str();
+}
+//------------------------------------------------------------------------
+void PointMap::GetCoord(int64 key, int64& i, int64& j, int64& k)
+{
+   k = key / _dpow;
+   j = (key - _dpow*k) / _pow;
+   i = key - _dpow*k - j*_pow;
+}
+//------------------------------------------------------------------------
 
-      //std::string sOctocode = Octocode::IndexToOctocode(i,j,k,_lod);
-      //create or open existing file: path/lod/x/y-z.json
+bool PointMap::ExportData(const std::string& path)
+{
+   bool bOk = true;
 
-      std::ostringstream oss;
-      oss << path << _lod << "/" << i << "/" << j << "-" << k << ".dat";
-      std::string sFilename = oss.str();
+   // write voxels in order of key, files of the same directory are written together
+   std::vector<std::pair<int64, size_t> > vVoxels;
+   vVoxels.reserve(_numkeys);
+   for (size_t b=0;b<_numkeys;b++)
+   {
+      if (_vBuckets[b].size() > 0)
+      {
+         vVoxels.push_back(std::make_pair(_vBucketKey[b], b));
+      }
+   }
+   std::sort(vVoxels.begin(), vVoxels.end());
 
+   for (size_t n=0;n<vVoxels.size();n++)
+   {
+      int64 key = vVoxels[n].first;
+      std::vector<unsigned char>& vBucket = _vBuckets[vVoxels[n].second];
 
-      std::ofstream of;
+      const PointVoxelFileHeader& oHeader = _vBucketHeader[vVoxels[n].second];
 
+      std::string sFilename = GetFilename(path, key);
 
-      if (FileSystem::FileExists(sFilename))
+      // the file is locked while the header is checked, created or converted and while points are appended
+      VoxelFilePtr qFile;
+      bool bCached = _pPriv->_files->Get(key, qFile);
+      int lockhandle = -1;
+      if (_lock)
       {
-         of.open(sFilename.c_str(), std::ios::app|std::ios::binary);
+         // lock file is created in the directory of the voxel file
+         if (!bCached && !_MakeSubdirs(sFilename))
+         {
+            std::cout << "ERROR: can't create directory of voxel file " << sFilename << "\n";
+            vBucket.clear();
+            bOk = false;
+            continue;
+         }
+         lockhandle = FileSystem::Lock(sFilename);
+         if (lockhandle == -1)
+         {
+            std::cout << "ERROR: can't lock voxel file " << sFilename << "\n";
+            vBucket.clear();
+            bOk = false;
+            continue;
+         }
       }
-      else
+
+      if (bCached && !_IsCurrent(*qFile, oHeader, _lock))
       {
-         FileSystem::makeallsubdirs(sFilename);
-         of.open(sFilename.c_str(), std::ios::binary);
+         // file stores less attributes than the points or was converted by another process
+         _pPriv->_files->Remove(key);
+         qFile.reset();
       }
 
-      of.precision(17);
-
-      std::list<CloudPoint>& lstCloudPoints = it->second;
+      if (!qFile)
+      {
+         //create or open existing file: path/lod/x/y-z.dat
+         qFile = _OpenVoxelFile(sFilename, oHeader);
+         if (!qFile)
+         {
+            std::cout << "ERROR: can't open voxel file " << sFilename << "\n";
+            if (_lock)
+            {
+               FileSystem::Unlock(sFilename, lockhandle);
+            }
+            vBucket.clear();
+            bOk = false;
+            continue;
+         }
+         _pPriv->_files->Put(key, qFile);
+      }
 
-      std::list<CloudPoint>::iterator jt = lstCloudPoints.begin();
-      while (jt != lstCloudPoints.end())
+      std::vector<unsigned char> vRecords;
+      const std::vector<unsigned char>* pRecords = &vBucket;
+      if (qFile->oHeader.attributes != oHeader.attributes)
       {
-         of.write((char*)&jt->x, sizeof(double));
-         of.write((char*)&jt->y, sizeof(double));
-         of.write((char*)&jt->elevation, sizeof(double));
-         of.write((char*)&jt->r, sizeof(unsigned char));
-         of.write((char*)&jt->g, sizeof(unsigned char));
-         of.write((char*)&jt->b, sizeof(unsigned char));
-         of.write((char*)&jt->intensity, sizeof(int));
-
-         jt++;
+         // file stores more attributes: convert records
+         size_t numpts = vBucket.size() / _recordsize;
+         vRecords.resize(numpts * qFile->oHeader.recordsize);
+         CloudPoint pt;
+         for (size_t p=0;p<numpts;p++)
+         {
+            PointVoxelFile::Decode(oHeader, &vBucket[p*_recordsize], pt);
+            PointVoxelFile::Encode(qFile->oHeader, pt, &vRecords[p*qFile->oHeader.recordsize]);
+         }
+         pRecords = &vRecords;
       }
 
-      of.close();
+      if (fwrite(&(*pRecords)[0], 1, pRecords->size(), qFile->f) != pRecords->size())
+      {
+         // close file, the incomplete record is removed when the file is opened again
+         std::cout << "ERROR: can't write voxel file " << sFilename << "\n";
+         _pPriv->_files->Remove(key);
+         vBucket.clear();
+         bOk = false;
+      }
 
-      ++it;
+      if (_lock)
+      {
+         FileSystem::Unlock(sFilename, lockhandle);
+      }
    }
+
+   _UpdateIndex();
+   return bOk;
 }
 
 //------------------------------------------------------------------------
 
 void PointMap::ExportIndex(const std::string& sFilename)
 {
+   _UpdateIndex();
+
    map_iterator it = _pPriv->_index->begin();
 
    std::ofstream of(sFilename.c_str(), std::ios::binary);
@@ -236,9 +578,8 @@ void PointMap::ImportIndex(const std::vector<std::string>& sIndexFiles)
    
       if (ifs.good())
       {
-         while (!ifs.eof())
+         while (ifs.read((char*)&value, sizeof(int64)))
          {
-            ifs.read((char*)&value, sizeof(int64));
             _pPriv->_index->insert(std::pair<int64,unsigned int>(value, 0));
          }
       }
@@ -254,6 +595,7 @@ void PointMap::ImportIndex(const std::vector<std::string>& sIndexFiles)
 
 int64 PointMap::GetIndexSize()
 {
+   _UpdateIndex();
    return _pPriv->_index->size();
 }
 
@@ -261,6 +603,8 @@ int64 PointMap::GetIndexSize()
 
 bool PointMap::GetNextIndex(int64& idx)
 {
+   _UpdateIndex();
+
    if (_pPriv->_resetiterator)
    {
       _pPriv->_it = _pPriv->_index->begin();
@@ -275,6 +619,8 @@ bool PointMap::GetNextIndex(int64& idx)
    }
    else
    {
+      // next call starts again with the first index
+      _pPriv->_resetiterator = true;
       return false;
    }
 }
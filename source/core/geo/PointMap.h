@@ -21,11 +21,13 @@
 
 #include "og.h"
 #include "math/CloudPoint.h"
+#include "geo/PointVoxelFile.h"
 #include "io/FileSystem.h"
 
 #include <map>
 #include <list>
 #include <set>
+#include <vector>
 #include <string>
 #include <sstream>
 #include <fstream>
@@ -45,7 +47,7 @@ public:
    // dtor
    virtual ~PointMap();
    
-   // clear all point data (free mem). Index is not cleared.
+   // clear all point data. Index is not cleared. Memory is kept for the next points unless it exceeds the memory budget.
    void Clear();
 
    // add a point
@@ -54,8 +56,39 @@ public:
    // get number of points
    size_t GetNumPoints();
 
-   // export data
-   void ExportData(const std::string& path);
+   // get number of voxels holding points
+   size_t GetNumVoxels();
+
+   // set memory used for buffering points in bytes (default 64 MB)
+   void SetMemoryBudget(size_t nBytes);
+
+   // returns true if the memory reserved for buffered points exceeds the memory budget (call ExportData and Clear)
+   bool IsFull();
+
+   // set attributes stored with the points (POINTATTRIB_* flags, default POINTATTRIB_ALL).
+   // Only call this if there are no points (after Clear).
+   void SetAttributes(unsigned int attributes);
+
+   // get attributes stored with the points
+   unsigned int GetAttributes();
+
+   // set maximal number of .dat files kept open between exports (default 256)
+   void SetMaxOpenFiles(size_t nFiles);
+
+   // lock .dat files while writing (FileSystem::Lock, default true). Required if several
+   // processes write to the same path, files converted by another process are detected.
+   void SetFileLocking(bool bLock);
+
+   // get filename of voxel: path/lod/i/j-k.dat
+   std::string GetFilename(const std::string& path, int64 key);
+
+   // convert key to voxel coord
+   void GetCoord(int64 key, int64& i, int64& j, int64& k);
+
+   // export data (appends points of every voxel to path/lod/i/j-k.dat, see PointVoxelFile).
+   // Files stay open, use the same path for all calls. Returns false if a voxel couldn't be
+   // written, the points of this voxel are lost and the voxel is not added to the index.
+   bool ExportData(const std::string& path);
 
    // export index list to file
    void ExportIndex(const std::string& sFilename);
@@ -65,15 +98,30 @@ public:
 
    int64 GetIndexSize();
    
+   // iterate index in ascending order, returns false at the end (and restarts with the next call)
    bool GetNextIndex(int64& idx);
 
 
 private:
    PointMap(){}
+   size_t _FindSlot(int64 key) const;
+   void _Rehash(size_t nSize);
+   void _UpdateIndex();
+
    PointMap_private* _pPriv;
-   std::map<int64, std::list<CloudPoint> > _map;
+   std::vector<int64> _vSlotKey;       // hash table (open addressing): key of slot
+   std::vector<int> _vSlotBucket;      // hash table: bucket of slot, -1 if slot is empty
+   std::vector<std::vector<unsigned char> > _vBuckets;   // point records of each voxel, stored contiguous
+   std::vector<int64> _vBucketKey;     // key of each bucket
+   std::vector<PointVoxelFileHeader> _vBucketHeader;   // header of each bucket (voxel origin for quantization)
    size_t _numpts;
-   size_t _numkeys;
+   size_t _numkeys;     // number of buckets in use
+   size_t _numindexed;  // buckets [0, _numindexed) are already in the index
+   size_t _memorybudget;
+   size_t _memoryused;  // capacity of all buckets (including reused buckets)
+   unsigned int _attributes;
+   bool _lock;
+   size_t _recordsize;
    int _lod;
    int64 _pow;
    int64 _dpow;
@@ -0,0 +1,246 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include "PointVoxelFile.h"
+#include "io/FileSystem.h"
+#include <cstring>
+#include <cmath>
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+   const unsigned short QUANTBITS = 30;   // voxel size is 2^30 units, values outside the voxel still fit
+   const size_t LEGACYRECORDSIZE = 3*sizeof(double) + 3*sizeof(unsigned char) + sizeof(int);
+
+   //---------------------------------------------------------------------------
+
+   bool _IsValid(const PointVoxelFileHeader& oHeader)
+   {
+      return memcmp(oHeader.magic, "OGPV", 4) == 0 && oHeader.version == POINTVOXELFILE_VERSION &&
+         oHeader.recordsize == PointVoxelFile::GetRecordSize(oHeader.attributes);
+   }
+
+   //---------------------------------------------------------------------------
+
+   inline int _Quantize(double v, int64 origin, double scale)
+   {
+      double q = floor((v * scale - double(origin << QUANTBITS)) + 0.5);
+      if (q < -2147483648.0) q = -2147483648.0;
+      if (q > 2147483647.0) q = 2147483647.0;
+      return int(q);
+   }
+
+   //---------------------------------------------------------------------------
+
+   inline double _Dequantize(int q, int64 origin, double invscale)
+   {
+      return double((origin << QUANTBITS) + q) * invscale;
+   }
+
+   //---------------------------------------------------------------------------
+   // Decode record of a file without header:
+   // x, y, elevation (double), r, g, b (unsigned char), intensity (int)
+
+   void _DecodeLegacy(const unsigned char* rec, CloudPoint& pt)
+   {
+      memcpy(&pt.x, rec, sizeof(double));             rec += sizeof(double);
+      memcpy(&pt.y, rec, sizeof(double));             rec += sizeof(double);
+      memcpy(&pt.elevation, rec, sizeof(double));     rec += sizeof(double);
+      pt.r = *rec++;
+      pt.g = *rec++;
+      pt.b = *rec++;
+      pt.a = 255;
+      memcpy(&pt.intensity, rec, sizeof(int));
+   }
+}
+
+//------------------------------------------------------------------------------
+
+void PointVoxelFile::InitHeader(PointVoxelFileHeader& oHeader, int lod, int64 i, int64 j, int64 k, unsigned int attributes)
+{
+   memset(&oHeader, 0, sizeof(PointVoxelFileHeader));
+   memcpy(oHeader.magic, "OGPV", 4);
+   oHeader.version = POINTVOXELFILE_VERSION;
+   oHeader.attributes = (unsigned short)(attributes & POINTATTRIB_ALL);
+   oHeader.recordsize = (unsigned int)GetRecordSize(attributes);
+   oHeader.lod = (unsigned short)lod;
+   oHeader.quantbits = QUANTBITS;
+   oHeader.i = i;
+   oHeader.j = j;
+   oHeader.k = k;
+}
+
+//------------------------------------------------------------------------------
+
+size_t PointVoxelFile::GetRecordSize(unsigned int attributes)
+{
+   size_t nSize = 3*sizeof(int);
+   if (attributes & POINTATTRIB_COLOR)
+   {
+      nSize += 4*sizeof(unsigned char);
+   }
+   if (attributes & POINTATTRIB_INTENSITY)
+   {
+      nSize += sizeof(int);
+   }
+   return nSize;
+}
+
+//------------------------------------------------------------------------------
+
+void PointVoxelFile::Encode(const PointVoxelFileHeader& oHeader, const CloudPoint& pt, unsigned char* pRecord)
+{
+   double scale = ldexp(1.0, oHeader.lod + oHeader.quantbits);
+   int q[3];
+   q[0] = _Quantize(pt.x, oHeader.i, scale);
+   q[1] = _Quantize(pt.y, oHeader.j, scale);
+   q[2] = _Quantize(pt.elevation, oHeader.k, scale);
+   memcpy(pRecord, q, 3*sizeof(int));
+   pRecord += 3*sizeof(int);
+
+   if (oHeader.attributes & POINTATTRIB_COLOR)
+   {
+      *pRecord++ = pt.r;
+      *pRecord++ = pt.g;
+      *pRecord++ = pt.b;
+      *pRecord++ = pt.a;
+   }
+   if (oHeader.attributes & POINTATTRIB_INTENSITY)
+   {
+      memcpy(pRecord, &pt.intensity, sizeof(int));
+   }
+}
+
+//------------------------------------------------------------------------------
+
+void PointVoxelFile::Decode(const PointVoxelFileHeader& oHeader, const unsigned char* pRecord, CloudPoint& pt)
+{
+   double invscale = ldexp(1.0, -(oHeader.lod + oHeader.quantbits));
+   int q[3];
+   memcpy(q, pRecord, 3*sizeof(int));
+   pRecord += 3*sizeof(int);
+   pt.x = _Dequantize(q[0], oHeader.i, invscale);
+   pt.y = _Dequantize(q[1], oHeader.j, invscale);
+   pt.elevation = _Dequantize(q[2], oHeader.k, invscale);
+
+   if (oHeader.attributes & POINTATTRIB_COLOR)
+   {
+      pt.r = *pRecord++;
+      pt.g = *pRecord++;
+      pt.b = *pRecord++;
+      pt.a = *pRecord++;
+   }
+   else
+   {
+      pt.r = pt.g = pt.b = 0;
+      pt.a = 255;
+   }
+   if (oHeader.attributes & POINTATTRIB_INTENSITY)
+   {
+      memcpy(&pt.intensity, pRecord, sizeof(int));
+   }
+   else
+   {
+      pt.intensity = 0;
+   }
+}
+
+//------------------------------------------------------------------------------
+
+bool PointVoxelFile::Write(const std::string& sFilename, const PointVoxelFileHeader& oHeader, const std::vector<CloudPoint>& vPoints)
+{
+   std::vector<unsigned char> vData(sizeof(PointVoxelFileHeader) + vPoints.size()*oHeader.recordsize);
+   memcpy(&vData[0], &oHeader, sizeof(PointVoxelFileHeader));
+   for (size_t n=0;n<vPoints.size();n++)
+   {
+      Encode(oHeader, vPoints[n], &vData[sizeof(PointVoxelFileHeader) + n*oHeader.recordsize]);
+   }
+
+   FILE* f = fopen(sFilename.c_str(), "wb");
+   if (!f)
+   {
+      return false;
+   }
+
+   bool bOk = fwrite(&vData[0], 1, vData.size(), f) == vData.size();
+   return (fclose(f) == 0) && bOk;
+}
+
+//------------------------------------------------------------------------------
+
+bool PointVoxelFile::Read(const std::string& sFilename, std::vector<CloudPoint>& vPoints, unsigned int* pAttributes)
+{
+   vPoints.clear();
+
+   std::vector<unsigned char> vData;
+   if (!FileSystem::FileToMemory(sFilename, vData))
+   {
+      return false;
+   }
+
+   if (vData.size() >= sizeof(PointVoxelFileHeader) && _IsValid(*(const PointVoxelFileHeader*)&vData[0]))
+   {
+      PointVoxelFileHeader oHeader;
+      memcpy(&oHeader, &vData[0], sizeof(PointVoxelFileHeader));
+
+      // an incomplete record at the end is ignored
+      size_t nPoints = (vData.size() - sizeof(PointVoxelFileHeader)) / oHeader.recordsize;
+      vPoints.resize(nPoints);
+      for (size_t n=0;n<nPoints;n++)
+      {
+         Decode(oHeader, &vData[sizeof(PointVoxelFileHeader) + n*oHeader.recordsize], vPoints[n]);
+      }
+
+      if (pAttributes)
+      {
+         *pAttributes = oHeader.attributes;
+      }
+   }
+   else
+   {
+      // file without header (older version)
+      size_t nPoints = vData.size() / LEGACYRECORDSIZE;
+      vPoints.resize(nPoints);
+      for (size_t n=0;n<nPoints;n++)
+      {
+         _DecodeLegacy(&vData[n*LEGACYRECORDSIZE], vPoints[n]);
+      }
+
+      if (pAttributes)
+      {
+         *pAttributes = POINTATTRIB_ALL;
+      }
+   }
+
+   return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool PointVoxelFile::ReadHeader(FILE* f, PointVoxelFileHeader& oHeader)
+{
+   if (fseek(f, 0, SEEK_SET) != 0)
+   {
+      return false;
+   }
+
+   return fread(&oHeader, sizeof(PointVoxelFileHeader), 1, f) == 1 && _IsValid(oHeader);
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,90 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#ifndef _POINTVOXELFILE_H
+#define _POINTVOXELFILE_H
+
+#include "og.h"
+#include "math/CloudPoint.h"
+#include <string>
+#include <vector>
+#include <cstdio>
+
+//------------------------------------------------------------------------------
+// Header of temporary point voxel files (.dat). The header is followed by
+// records of "recordsize" bytes until the end of the file:
+//
+//   int x, y, z          coordinates quantized relative to the voxel origin
+//   unsigned char r,g,b,a   color (if POINTATTRIB_COLOR is set)
+//   int intensity        intensity (if POINTATTRIB_INTENSITY is set)
+//
+// Coordinates are dequantized as x = (i + qx / 2^quantbits) / 2^lod in octree
+// space [0,1]. Records are 4 byte aligned, so the file can be mapped directly.
+// This is a temporary file, it is not endian safe.
+
+struct PointVoxelFileHeader
+{
+   char           magic[4];      // "OGPV"
+   unsigned short version;       // POINTVOXELFILE_VERSION
+   unsigned short attributes;    // POINTATTRIB_* flags
+   unsigned int   recordsize;    // bytes per point
+   unsigned short lod;           // level of detail of voxel
+   unsigned short quantbits;     // fractional bits of quantized coordinates
+   int64          i, j, k;       // voxel coord
+};
+
+#define POINTVOXELFILE_VERSION 1
+
+enum EPointAttributes
+{
+   POINTATTRIB_NONE = 0,
+   POINTATTRIB_COLOR = 1,
+   POINTATTRIB_INTENSITY = 2,
+   POINTATTRIB_ALL = 3,
+};
+
+//------------------------------------------------------------------------------
+
+class OPENGLOBE_API PointVoxelFile
+{
+public:
+   //! Initialize header of voxel (i,j,k) at specified level of detail.
+   static void InitHeader(PointVoxelFileHeader& oHeader, int lod, int64 i, int64 j, int64 k, unsigned int attributes);
+
+   //! Returns size of a record with specified attributes.
+   static size_t GetRecordSize(unsigned int attributes);
+
+   //! Encode point to record (GetRecordSize(oHeader.attributes) bytes).
+   static void Encode(const PointVoxelFileHeader& oHeader, const CloudPoint& pt, unsigned char* pRecord);
+
+   //! Decode record. Attributes not stored in the record are set to 0 (alpha to 255).
+   static void Decode(const PointVoxelFileHeader& oHeader, const unsigned char* pRecord, CloudPoint& pt);
+
+   //! Write a new file (header and records), an existing file is overwritten.
+   static bool Write(const std::string& sFilename, const PointVoxelFileHeader& oHeader, const std::vector<CloudPoint>& vPoints);
+
+   //! Read all points of a voxel file using a single read. If pAttributes is
+   //! not 0 the stored attributes are returned. Returns false if file doesn't exist or is invalid.
+   //! Voxel files without header (older version) can be read too.
+   static bool Read(const std::string& sFilename, std::vector<CloudPoint>& vPoints, unsigned int* pAttributes = 0);
+
+   //! Read header from the beginning of an open file. Returns false if file has no valid header.
+   static bool ReadHeader(FILE* f, PointVoxelFileHeader& oHeader);
+};
+
+#endif
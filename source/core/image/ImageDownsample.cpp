@@ -0,0 +1,243 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include "ImageDownsample.h"
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OG_DOWNSAMPLE_SSE2
+#include <emmintrin.h>
+#endif
+
+//------------------------------------------------------------------------------
+
+// Reduce two rows of an RGBA image to nCount pixels
+static inline void _ReduceRowRGBA(const unsigned char* row0, const unsigned char* row1, int nCount, unsigned char* out)
+{
+   for (int x=0;x<nCount;x++)
+   {
+      const unsigned char* px[4] = {row0 + 8*x, row0 + 8*x + 4, row1 + 8*x, row1 + 8*x + 4};
+      int red = 0, green = 0, blue = 0, alpha = 0;
+      int nVisible = 0;
+
+      for (int i=0;i<4;i++)
+      {
+         if (px[i][3] > 0)
+         {
+            red   += px[i][0];
+            green += px[i][1];
+            blue  += px[i][2];
+            alpha += px[i][3];
+            nVisible++;
+         }
+      }
+
+      if (nVisible>0)
+      {
+         red/=nVisible;
+         green/=nVisible;
+         blue/=nVisible;
+         alpha/=nVisible;
+      }
+
+      out[4*x+0] = (unsigned char)red;
+      out[4*x+1] = (unsigned char)green;
+      out[4*x+2] = (unsigned char)blue;
+      out[4*x+3] = (unsigned char)alpha;
+   }
+}
+
+//------------------------------------------------------------------------------
+// Reduce two rows of a float image to nCount values
+
+static inline void _ReduceRowRaw32(const float* row0, const float* row1, int nCount, float* out, float nodata)
+{
+   for (int x=0;x<nCount;x++)
+   {
+      float v[4] = {row0[2*x], row0[2*x+1], row1[2*x], row1[2*x+1]};
+      float value = 0.0f;
+      int nValid = 0;
+
+      for (int i=0;i<4;i++)
+      {
+         if (v[i] != nodata)
+         {
+            value += v[i];
+            nValid++;
+         }
+      }
+
+      out[x] = nValid>0 ? value/float(nValid) : nodata;
+   }
+}
+
+//------------------------------------------------------------------------------
+
+void ImageDownsample::RGBA_Scalar(const unsigned char* src, int width, int height, unsigned char* dst, int dst_stride)
+{
+   for (int y=0;y<height/2;y++)
+   {
+      const unsigned char* row0 = src + size_t(2*y)*size_t(width)*4;
+      _ReduceRowRGBA(row0, row0 + size_t(width)*4, width/2, dst + size_t(y)*size_t(dst_stride));
+   }
+}
+
+//------------------------------------------------------------------------------
+
+void ImageDownsample::Raw32_Scalar(const float* src, int width, int height, float* dst, int dst_stride, float nodata)
+{
+   for (int y=0;y<height/2;y++)
+   {
+      const float* row0 = src + size_t(2*y)*size_t(width);
+      _ReduceRowRaw32(row0, row0 + size_t(width), width/2, dst + size_t(y)*size_t(dst_stride), nodata);
+   }
+}
+
+//------------------------------------------------------------------------------
+
+#ifdef OG_DOWNSAMPLE_SSE2
+
+// Sum 2x2 blocks of 4 pixels of two rows (16 bytes each). Result: 8 x 16 bit, 
+// sum of pixels 0,1 in lanes 0-3 and sum of pixels 2,3 in lanes 4-7.
+static inline __m128i _SumBlocks(__m128i r0, __m128i r1, __m128i zero)
+{
+   __m128i a = _mm_add_epi16(_mm_unpacklo_epi8(r0, zero), _mm_unpacklo_epi8(r1, zero));
+   __m128i b = _mm_add_epi16(_mm_unpackhi_epi8(r0, zero), _mm_unpackhi_epi8(r1, zero));
+   a = _mm_add_epi16(a, _mm_srli_si128(a, 8));
+   b = _mm_add_epi16(b, _mm_srli_si128(b, 8));
+   return _mm_unpacklo_epi64(a, b);
+}
+
+// Integer division of sums (0..1020) by count (0..4), count 0 results in 0.
+// Division by 3 is done using (s*43691)>>17, which is exact for s < 2^16.
+static inline __m128i _DivideByCount(__m128i s, __m128i c)
+{
+   __m128i d1 = _mm_and_si128(_mm_cmpeq_epi16(c, _mm_set1_epi16(1)), s);
+   __m128i d2 = _mm_and_si128(_mm_cmpeq_epi16(c, _mm_set1_epi16(2)), _mm_srli_epi16(s, 1));
+   __m128i d3 = _mm_and_si128(_mm_cmpeq_epi16(c, _mm_set1_epi16(3)), _mm_srli_epi16(_mm_mulhi_epu16(s, _mm_set1_epi16((short)43691)), 1));
+   __m128i d4 = _mm_and_si128(_mm_cmpeq_epi16(c, _mm_set1_epi16(4)), _mm_srli_epi16(s, 2));
+   return _mm_or_si128(_mm_or_si128(d1, d2), _mm_or_si128(d3, d4));
+}
+
+// Reduce 4 pixels of two rows to 2 pixels (8 x 16 bit)
+static inline __m128i _Reduce(__m128i r0, __m128i r1, __m128i zero, __m128i alphamask, __m128i ones)
+{
+   // invisible pixels (alpha 0) are set to 0 and not counted
+   __m128i inv0 = _mm_cmpeq_epi32(_mm_and_si128(r0, alphamask), zero);
+   __m128i inv1 = _mm_cmpeq_epi32(_mm_and_si128(r1, alphamask), zero);
+
+   __m128i sum = _SumBlocks(_mm_andnot_si128(inv0, r0), _mm_andnot_si128(inv1, r1), zero);
+   __m128i cnt = _SumBlocks(_mm_andnot_si128(inv0, ones), _mm_andnot_si128(inv1, ones), zero);
+
+   return _DivideByCount(sum, cnt);
+}
+
+#endif
+
+//------------------------------------------------------------------------------
+
+void ImageDownsample::RGBA(const unsigned char* src, int width, int height, unsigned char* dst, int dst_stride)
+{
+#ifdef OG_DOWNSAMPLE_SSE2
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i alphamask = _mm_set1_epi32((int)0xFF000000);
+   const __m128i ones = _mm_set1_epi8(1);
+   int nVectorWidth = (width/2) & ~3;  // number of destination pixels processed with SSE
+
+   for (int y=0;y<height/2;y++)
+   {
+      const unsigned char* row0 = src + size_t(2*y)*size_t(width)*4;
+      const unsigned char* row1 = row0 + size_t(width)*4;
+      unsigned char* out = dst + size_t(y)*size_t(dst_stride);
+
+      for (int x=0;x<nVectorWidth;x+=4)
+      {
+         __m128i a0 = _mm_loadu_si128((const __m128i*)(row0 + 8*x));
+         __m128i b0 = _mm_loadu_si128((const __m128i*)(row0 + 8*x + 16));
+         __m128i a1 = _mm_loadu_si128((const __m128i*)(row1 + 8*x));
+         __m128i b1 = _mm_loadu_si128((const __m128i*)(row1 + 8*x + 16));
+
+         __m128i ra = _Reduce(a0, a1, zero, alphamask, ones);
+         __m128i rb = _Reduce(b0, b1, zero, alphamask, ones);
+         _mm_storeu_si128((__m128i*)(out + 4*x), _mm_packus_epi16(ra, rb));
+      }
+
+      // remaining pixels
+      _ReduceRowRGBA(row0 + 8*nVectorWidth, row1 + 8*nVectorWidth, width/2 - nVectorWidth, out + 4*nVectorWidth);
+   }
+#else
+   RGBA_Scalar(src, width, height, dst, dst_stride);
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+void ImageDownsample::Raw32(const float* src, int width, int height, float* dst, int dst_stride, float nodata)
+{
+#ifdef OG_DOWNSAMPLE_SSE2
+   const __m128 nd = _mm_set1_ps(nodata);
+   const __m128 one = _mm_set1_ps(1.0f);
+   const __m128 zero = _mm_setzero_ps();
+   int nVectorWidth = (width/2) & ~3;
+
+   for (int y=0;y<height/2;y++)
+   {
+      const float* row0 = src + size_t(2*y)*size_t(width);
+      const float* row1 = row0 + size_t(width);
+      float* out = dst + size_t(y)*size_t(dst_stride);
+
+      for (int x=0;x<nVectorWidth;x+=4)
+      {
+         __m128 a0 = _mm_loadu_ps(row0 + 2*x);
+         __m128 b0 = _mm_loadu_ps(row0 + 2*x + 4);
+         __m128 a1 = _mm_loadu_ps(row1 + 2*x);
+         __m128 b1 = _mm_loadu_ps(row1 + 2*x + 4);
+
+         // same order of summation as the scalar version
+         __m128 v0 = _mm_shuffle_ps(a0, b0, _MM_SHUFFLE(2,0,2,0));
+         __m128 v1 = _mm_shuffle_ps(a0, b0, _MM_SHUFFLE(3,1,3,1));
+         __m128 v2 = _mm_shuffle_ps(a1, b1, _MM_SHUFFLE(2,0,2,0));
+         __m128 v3 = _mm_shuffle_ps(a1, b1, _MM_SHUFFLE(3,1,3,1));
+
+         __m128 m0 = _mm_cmpneq_ps(v0, nd);
+         __m128 m1 = _mm_cmpneq_ps(v1, nd);
+         __m128 m2 = _mm_cmpneq_ps(v2, nd);
+         __m128 m3 = _mm_cmpneq_ps(v3, nd);
+
+         __m128 sum = _mm_add_ps(_mm_and_ps(m0, v0), _mm_and_ps(m1, v1));
+         sum = _mm_add_ps(sum, _mm_and_ps(m2, v2));
+         sum = _mm_add_ps(sum, _mm_and_ps(m3, v3));
+
+         __m128 cnt = _mm_add_ps(_mm_and_ps(m0, one), _mm_and_ps(m1, one));
+         cnt = _mm_add_ps(cnt, _mm_add_ps(_mm_and_ps(m2, one), _mm_and_ps(m3, one)));
+
+         __m128 valid = _mm_cmpgt_ps(cnt, zero);
+         __m128 res = _mm_div_ps(sum, _mm_or_ps(_mm_and_ps(valid, cnt), _mm_andnot_ps(valid, one)));
+         _mm_storeu_ps(out + x, _mm_or_ps(_mm_and_ps(valid, res), _mm_andnot_ps(valid, nd)));
+      }
+
+      // remaining values
+      _ReduceRowRaw32(row0 + 2*nVectorWidth, row1 + 2*nVectorWidth, width/2 - nVectorWidth, out + nVectorWidth, nodata);
+   }
+#else
+   Raw32_Scalar(src, width, height, dst, dst_stride, nodata);
+#endif
+}
+
+//------------------------------------------------------------------------------
+
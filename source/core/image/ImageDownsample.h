@@ -0,0 +1,50 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#ifndef _IMAGEDOWNSAMPLE_H
+#define _IMAGEDOWNSAMPLE_H
+
+#include "og.h"
+
+//------------------------------------------------------------------------------
+// Reduce images to half size by averaging 2x2 blocks (used to create the
+// tiles of the next lower level of detail). SSE2 is used if available.
+
+class OPENGLOBE_API ImageDownsample
+{
+public:
+   // Reduce RGBA image with size (width, height) to (width/2, height/2). 
+   // Pixels with alpha 0 are ignored, a block without any visible pixel results
+   // in a fully transparent pixel (0,0,0,0).
+   // dst_stride is the size of a row of the destination image in bytes.
+   static void RGBA(const unsigned char* src, int width, int height, unsigned char* dst, int dst_stride);
+
+   // Reduce float image with size (width, height) to (width/2, height/2).
+   // Values equal to nodata are ignored, a block containing only nodata 
+   // values results in nodata. 
+   // dst_stride is the size of a row of the destination image in floats.
+   static void Raw32(const float* src, int width, int height, float* dst, int dst_stride, float nodata);
+
+   // Reference implementations without SSE.
+   static void RGBA_Scalar(const unsigned char* src, int width, int height, unsigned char* dst, int dst_stride);
+   static void Raw32_Scalar(const float* src, int width, int height, float* dst, int dst_stride, float nodata);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -75,6 +75,17 @@ void ImageObject::AllocateImage(unsigned int w, unsigned int h, Img::PixelFormat
    _qData = boost::shared_array<unsigned char>(new unsigned char[w*h*bpp]); 
 }
 //------------------------------------------------------------------------------
+
+void ImageObject::ReallocateImage(unsigned int w, unsigned int h, Img::PixelFormat ePixelFormat)
+{
+   if (_qData && _qData.unique() && _width == w && _height == h && _ePixelFormat == ePixelFormat)
+   {
+      return;
+   }
+
+   AllocateImage(w, h, ePixelFormat);
+}
+//------------------------------------------------------------------------------
 void ImageObject::_RGB_RGBA(unsigned char*  input)
 {
    unsigned char* dst = _qData.get();
@@ -47,6 +47,10 @@ public:
    
    //! \brief Allocate Image Data
    void AllocateImage(unsigned int w, unsigned int h, Img::PixelFormat ePixelFormat);   
+
+   //! \brief Allocate Image Data, the current buffer is reused if it has the same size
+   //! and is not shared with anyone else (see GetRawData). Content is undefined.
+   void ReallocateImage(unsigned int w, unsigned int h, Img::PixelFormat ePixelFormat);
    
    //! \brief Retrieve Pixel Format
    Img::PixelFormat GetPixelFormat() { return _ePixelFormat;}
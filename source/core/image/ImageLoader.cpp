@@ -32,9 +32,9 @@
 
 //------------------------------------------------------------------------------
 
-bool ImageLoader::LoadFromDisk(Img::FileFormat eFormat, const std::string& sFilename, Img::PixelFormat eDestPixelFormat, ImageObject& outputimage)
+// read whole file at once
+static bool _ReadFile(const std::string& sFilename, std::vector<unsigned char>& vecData)
 {
-   std::vector<unsigned char> vecData;
    std::ifstream ifs;
    
 #ifdef OS_WINDOWS
@@ -43,21 +43,40 @@ bool ImageLoader::LoadFromDisk(Img::FileFormat eFormat, const std::string& sFile
 #else
    ifs.open(sFilename.c_str(), std::ios::in | std::ios::binary);
 #endif
-   if (ifs.good())
+   if (!ifs.good())
    {
-      unsigned char s;
-      while (!ifs.eof())
-      {  
-         ifs.read((char*)&s, 1);
-         vecData.push_back(s);  
-      }
+      return false;
    }
-   else
+
+   ifs.seekg(0, std::ios::end);
+   size_t nSize = size_t(ifs.tellg());
+   ifs.seekg(0, std::ios::beg);
+
+   if (nSize == 0)
+   {
+      return false;
+   }
+
+   vecData.resize(nSize);
+   ifs.read((char*)&vecData[0], nSize);
+   vecData.resize(size_t(ifs.gcount()));
+   ifs.close();
+
+   return vecData.size() > 0;
+}
+
+//------------------------------------------------------------------------------
+
+bool ImageLoader::LoadFromDisk(Img::FileFormat eFormat, const std::string& sFilename, Img::PixelFormat eDestPixelFormat, ImageObject& outputimage)
+{
+   std::vector<unsigned char> vecData;
+
+   if (!_ReadFile(sFilename, vecData))
    {
       return false;
    }
    
-   return ImageLoader::LoadFromMemory(eFormat, &vecData[0], vecData.size(), eDestPixelFormat, outputimage);
+   return ImageLoader::LoadFromMemory(eFormat, &vecData[0], (unsigned int)vecData.size(), eDestPixelFormat, outputimage);
 }
 
 //------------------------------------------------------------------------------
@@ -73,28 +92,19 @@ bool ImageLoader::LoadRaw32FromDisk(const std::string& sFilename, int w, int h,
    ifs.open(sFilename.c_str(), std::ios::binary);
 #endif
    outputdata.AllocateImage(w,h);
-      int offset = 0;
-      if (ifs.good())
-      {
-         while (!ifs.eof())
-         {
-                     
-            float value;
-            ifs.read((char*)&(value), sizeof(float));
-            if (!ifs.eof())
-            {
-               outputdata.SetValue(offset, value);
-            }
-            offset++;
-         }
-         ifs.close();
-         return true;
-      }
-      else
-      {
-         ifs.close();
-         return false;
-      }
+   if (ifs.good())
+   {
+      // read directly into image (values not in file remain undefined, 
+      // data exceeding w*h is ignored)
+      ifs.read((char*)outputdata.GetRawData().get(), size_t(w)*size_t(h)*sizeof(float));
+      ifs.close();
+      return true;
+   }
+   else
+   {
+      ifs.close();
+      return false;
+   }
 }
 
 //------------------------------------------------------------------------------
@@ -160,3 +170,177 @@ bool ImageLoader::LoadFromMemory(Img::FileFormat eFormat, const unsigned char* p
 }
 
 //------------------------------------------------------------------------------
+
+PNGDecoder::PNGDecoder()
+   : _pScanlines(0), _nScanlinesAllocSize(0)
+{
+}
+
+//------------------------------------------------------------------------------
+
+PNGDecoder::~PNGDecoder()
+{
+   free(_pScanlines);
+}
+
+//------------------------------------------------------------------------------
+
+bool PNGDecoder::LoadFromDisk(const std::string& sFilename, Img::PixelFormat eDestPixelFormat, ImageObject& outputimage)
+{
+   if (!_ReadFile(sFilename, _vFile))
+   {
+      return false;
+   }
+
+   return LoadFromMemory(&_vFile[0], (unsigned int)_vFile.size(), eDestPixelFormat, outputimage);
+}
+
+//------------------------------------------------------------------------------
+
+bool PNGDecoder::LoadFromMemory(const unsigned char* pData, const unsigned int nSize, Img::PixelFormat eDestPixelFormat, ImageObject& outputimage)
+{
+   // signature and IHDR chunk
+   if (pData == 0 || nSize < 33)
+   {
+      return false;
+   }
+
+   static const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+   if (memcmp(pData, signature, 8) != 0 || !LodePNG_chunk_type_equals(pData + 8, "IHDR"))
+   {
+      return false;
+   }
+
+   unsigned int w = LodePNG_read32bitInt(&pData[16]);
+   unsigned int h = LodePNG_read32bitInt(&pData[20]);
+   unsigned int nBitDepth = pData[24];
+   unsigned int nColorType = pData[25];
+   unsigned int nInterlace = pData[28];
+
+   // only 8 bit RGB and RGBA without interlacing is decoded here
+   bool bDirect = (nBitDepth == 8 && (nColorType == 2 || nColorType == 6) && nInterlace == 0 && 
+                   pData[26] == 0 && pData[27] == 0 && w > 0 && h > 0);
+
+   if (nColorType == 2 && !(eDestPixelFormat == Img::PixelFormat_RGB || eDestPixelFormat == Img::PixelFormat_RGBA))
+   {
+      bDirect = false;
+   }
+
+   // collect IDAT chunks
+   _vIdat.clear();
+   size_t pos = 8;
+   bool bEnd = false;
+   while (bDirect && !bEnd)
+   {
+      if (pos + 12 > nSize)
+      {
+         return false;
+      }
+
+      const unsigned char* chunk = pData + pos;
+      size_t nLength = LodePNG_chunk_length(chunk);
+      if (nLength > nSize - pos - 12)
+      {
+         return false;
+      }
+
+      if (LodePNG_chunk_type_equals(chunk, "IDAT"))
+      {
+         if (LodePNG_chunk_check_crc(chunk))
+         {
+            return false;
+         }
+         _vIdat.insert(_vIdat.end(), chunk + 8, chunk + 8 + nLength);
+      }
+      else if (LodePNG_chunk_type_equals(chunk, "IEND"))
+      {
+         bEnd = true;
+      }
+      else if (LodePNG_chunk_type_equals(chunk, "IHDR"))
+      {
+         if (LodePNG_chunk_check_crc(chunk))
+         {
+            return false;
+         }
+      }
+      else if (LodePNG_chunk_critical(chunk) || LodePNG_chunk_type_equals(chunk, "tRNS"))
+      {
+         bDirect = false;  // palette or transparency: use generic decoder
+      }
+
+      pos += nLength + 12;
+   }
+
+   if (!bDirect)
+   {
+      return ImageLoader::LoadFromMemory(Img::Format_PNG, pData, nSize, eDestPixelFormat, outputimage);
+   }
+
+   // inflate into scanline buffer
+   if (_vIdat.size() < 6 || (_vIdat[0] * 256 + _vIdat[1]) % 31 != 0 || (_vIdat[0] & 15) != 8 || ((_vIdat[0] >> 4) & 15) > 7 || ((_vIdat[1] >> 5) & 1) != 0)
+   {
+      return false;
+   }
+
+   ucvector scanlines;
+   ucvector_init_buffer(&scanlines, _pScanlines, _nScanlinesAllocSize);
+   unsigned error = LodeFlate_inflate(&scanlines, &_vIdat[0], _vIdat.size(), 2);
+   _pScanlines = scanlines.data;
+   _nScanlinesAllocSize = scanlines.allocsize;
+   if (error)
+   {
+      return false;
+   }
+
+   if (LodeZlib_read32bitInt(&_vIdat[_vIdat.size() - 4]) != adler32(scanlines.data, (unsigned)scanlines.size))
+   {
+      return false;
+   }
+
+   unsigned int nChannels = (nColorType == 6) ? 4 : 3;
+   if (scanlines.size < size_t(h) * (size_t(w) * nChannels + 1))
+   {
+      return false;
+   }
+
+   // unfilter scanlines
+   bool bSameFormat = (nColorType == 6 && eDestPixelFormat == Img::PixelFormat_RGBA) ||
+                      (nColorType == 2 && eDestPixelFormat == Img::PixelFormat_RGB);
+
+   outputimage.ReallocateImage(w, h, eDestPixelFormat);
+
+   if (bSameFormat)
+   {
+      return unfilter(outputimage.GetRawData().get(), _pScanlines, w, h, 8*nChannels) == 0;
+   }
+
+   _vPixels.resize(size_t(w) * size_t(h) * nChannels);
+   if (unfilter(&_vPixels[0], _pScanlines, w, h, 8*nChannels) != 0)
+   {
+      return false;
+   }
+
+   if (nColorType == 6)
+   {
+      outputimage.FillFromRGBA(&_vPixels[0]);
+   }
+   else
+   {
+      // RGB -> RGBA, opaque like LodePNG::decode
+      const unsigned char* src = &_vPixels[0];
+      unsigned char* dst = outputimage.GetRawData().get();
+      size_t nPixels = size_t(w) * size_t(h);
+      for (size_t i=0;i<nPixels;i++)
+      {
+         dst[4*i+0] = src[3*i+0];
+         dst[4*i+1] = src[3*i+1];
+         dst[4*i+2] = src[3*i+2];
+         dst[4*i+3] = 255;
+      }
+   }
+
+   return true;
+}
+
+//------------------------------------------------------------------------------
+
@@ -20,6 +20,7 @@
 #define _IMAGELOADER_H
 
 #include "ImageHandler.h"
+#include <vector>
 
 /*
    Example Code:
@@ -69,6 +70,39 @@ public:
    
 };
 
+//------------------------------------------------------------------------------
+// PNG decoder keeping its buffers between calls. Decoding 8-bit RGB(A) PNG
+// files (which is what all tiles are) writes the image directly into the buffer
+// of the output image, which is reused if it has the right size 
+// (see ImageObject::ReallocateImage). Other PNG files are decoded using 
+// ImageLoader::LoadFromMemory.
+// A decoder must not be used by more than one thread at the same time, use one
+// decoder per thread.
+
+class OPENGLOBE_API PNGDecoder
+{
+public:
+   PNGDecoder();
+   virtual ~PNGDecoder();
+
+   // decompress from disk
+   bool LoadFromDisk(const std::string& sFilename, Img::PixelFormat eDestPixelFormat, ImageObject& outputimage);
+
+   // decompress from memory
+   bool LoadFromMemory(const unsigned char* pData, const unsigned int nSize, Img::PixelFormat eDestPixelFormat, ImageObject& outputimage);
+
+protected:
+   std::vector<unsigned char> _vFile;     // content of file (LoadFromDisk)
+   std::vector<unsigned char> _vIdat;     // concatenated IDAT chunks
+   std::vector<unsigned char> _vPixels;   // unfiltered image if it can't be written to output image directly
+   unsigned char* _pScanlines;            // inflated (filtered) scanlines, allocated using malloc
+   size_t _nScanlinesAllocSize;
+
+private:
+   PNGDecoder(const PNGDecoder&);
+   PNGDecoder& operator=(const PNGDecoder&);
+};
+
 //------------------------------------------------------------------------------
 
 #endif
\ No newline at end of file
@@ -0,0 +1,355 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include "ImageWarp.h"
+#include <cmath>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OG_WARP_SSE2
+#include <emmintrin.h>
+#endif
+
+//------------------------------------------------------------------------------
+// Position of the first pixel of row ty and step to the next pixel of the row.
+
+static inline void _RowMapping(const double corner[8], int ty, int tilesize, double& x, double& y, double& sx, double& sy)
+{
+   double d = 1.0/(double(tilesize)-1.0);
+   double dy = double(ty)*d;
+
+   // left (A,D) and right (B,C) end of row
+   double lx = corner[0]*(1.0-dy) + corner[6]*dy;
+   double ly = corner[1]*(1.0-dy) + corner[7]*dy;
+   double rx = corner[2]*(1.0-dy) + corner[4]*dy;
+   double ry = corner[3]*(1.0-dy) + corner[5]*dy;
+
+   x = lx;
+   y = ly;
+   sx = (rx-lx)*d;
+   sy = (ry-ly)*d;
+}
+
+//------------------------------------------------------------------------------
+
+static inline bool _IsValid(const double valid[4], double x, double y)
+{
+   return x >= valid[0] && x <= valid[2] && y >= valid[1] && y <= valid[3];
+}
+
+//------------------------------------------------------------------------------
+
+static inline int _Clamp(int v, int vmax)
+{
+   return v < 0 ? 0 : (v > vmax ? vmax : v);
+}
+
+//------------------------------------------------------------------------------
+
+static inline unsigned char _ToByte(double v)
+{
+   v += 0.5;
+   return (unsigned char)(v < 0.0 ? 0.0 : (v > 255.0 ? 255.0 : v));
+}
+
+//------------------------------------------------------------------------------
+// Catmull-Rom weights for fraction t
+
+static inline void _CubicWeights(double t, double w[4])
+{
+   w[0] = ((-0.5*t + 1.0)*t - 0.5)*t;
+   w[1] = (1.5*t - 2.5)*t*t + 1.0;
+   w[2] = ((-1.5*t + 2.0)*t + 0.5)*t;
+   w[3] = (0.5*t - 0.5)*t*t;
+}
+
+//------------------------------------------------------------------------------
+// Sample source image at (x,y), coordinates are clamped to the image. 
+
+static inline void _SampleNearest(const unsigned char* src, int width, int height, double x, double y, unsigned char* out)
+{
+   int px = _Clamp(int(floor(x)), width-1);
+   int py = _Clamp(int(floor(y)), height-1);
+   const unsigned char* p = src + 3*(size_t(py)*size_t(width) + size_t(px));
+   out[0] = p[0];
+   out[1] = p[1];
+   out[2] = p[2];
+}
+
+static inline void _SampleBilinear(const unsigned char* src, int width, int height, double x, double y, unsigned char* out)
+{
+   double fx = floor(x);
+   double fy = floor(y);
+   double uf = x-fx;
+   double vf = y-fy;
+   int x0 = _Clamp(int(fx), width-1);
+   int x1 = _Clamp(int(fx)+1, width-1);
+   const unsigned char* row0 = src + 3*size_t(_Clamp(int(fy), height-1))*size_t(width);
+   const unsigned char* row1 = src + 3*size_t(_Clamp(int(fy)+1, height-1))*size_t(width);
+
+   for (int c=0;c<3;c++)
+   {
+      out[c] = _ToByte(double(row0[3*x0+c])*(1-uf)*(1-vf) + double(row0[3*x1+c])*uf*(1-vf) + double(row1[3*x0+c])*(1-uf)*vf + double(row1[3*x1+c])*uf*vf);
+   }
+}
+
+static inline void _SampleBicubic(const unsigned char* src, int width, int height, double x, double y, unsigned char* out)
+{
+   double fx = floor(x);
+   double fy = floor(y);
+   double wx[4], wy[4];
+   _CubicWeights(x-fx, wx);
+   _CubicWeights(y-fy, wy);
+
+   int px[4];
+   for (int i=0;i<4;i++)
+   {
+      px[i] = 3*_Clamp(int(fx)+i-1, width-1);
+   }
+
+   double sum[3] = {0, 0, 0};
+   for (int j=0;j<4;j++)
+   {
+      const unsigned char* row = src + 3*size_t(_Clamp(int(fy)+j-1, height-1))*size_t(width);
+      for (int c=0;c<3;c++)
+      {
+         double v = double(row[px[0]+c])*wx[0] + double(row[px[1]+c])*wx[1] + double(row[px[2]+c])*wx[2] + double(row[px[3]+c])*wx[3];
+         sum[c] += v*wy[j];
+      }
+   }
+
+   out[0] = _ToByte(sum[0]);
+   out[1] = _ToByte(sum[1]);
+   out[2] = _ToByte(sum[2]);
+}
+
+static inline void _Sample(const unsigned char* src, int width, int height, double x, double y, EWarpFilter eFilter, unsigned char* out)
+{
+   switch (eFilter)
+   {
+   case WARPFILTER_NEAREST:
+      _SampleNearest(src, width, height, x, y, out);
+      break;
+   case WARPFILTER_BICUBIC:
+      _SampleBicubic(src, width, height, x, y, out);
+      break;
+   default:
+      _SampleBilinear(src, width, height, x, y, out);
+      break;
+   }
+}
+
+//------------------------------------------------------------------------------
+// Warp one row with bounds checks for every pixel.
+
+static void _WarpRow(const unsigned char* src, int width, int height, double x, double y, double sx, double sy, const double valid[4], EWarpFilter eFilter, bool bFill, unsigned char* out, int nCount)
+{
+   for (int tx=0;tx<nCount;tx++)
+   {
+      double px = x + double(tx)*sx;
+      double py = y + double(tx)*sy;
+
+      if (_IsValid(valid, px, py) && (!bFill || out[4*tx+3] == 0))
+      {
+         _Sample(src, width, height, px, py, eFilter, out + 4*tx);
+         out[4*tx+3] = 255;
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+
+void ImageWarp::RGB_Scalar(const unsigned char* src, int width, int height, const double corner[8], const double valid[4], EWarpFilter eFilter, bool bFill, unsigned char* tile, int tilesize)
+{
+   for (int ty=0;ty<tilesize;ty++)
+   {
+      double x, y, sx, sy;
+      _RowMapping(corner, ty, tilesize, x, y, sx, sy);
+      _WarpRow(src, width, height, x, y, sx, sy, valid, eFilter, bFill, tile + 4*size_t(ty)*size_t(tilesize), tilesize);
+   }
+}
+
+//------------------------------------------------------------------------------
+
+#ifdef OG_WARP_SSE2
+
+// Load RGB pixel as 4 floats (r,g,b,255)
+static inline __m128 _LoadRGB(const unsigned char* p, __m128i zero)
+{
+   int v = int(p[0]) | (int(p[1]) << 8) | (int(p[2]) << 16) | int(0xFF000000);
+   __m128i i = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero), zero);
+   return _mm_cvtepi32_ps(i);
+}
+
+// Store 4 floats as RGBA pixel (rounded and clamped to 0..255)
+static inline void _StoreRGBA(__m128 v, unsigned char* p)
+{
+   __m128i i = _mm_cvttps_epi32(_mm_add_ps(v, _mm_set1_ps(0.5f)));
+   i = _mm_packs_epi32(i, i);
+   int rgba = _mm_cvtsi128_si32(_mm_packus_epi16(i, i));
+   p[0] = (unsigned char)(rgba);
+   p[1] = (unsigned char)(rgba >> 8);
+   p[2] = (unsigned char)(rgba >> 16);
+   p[3] = (unsigned char)(rgba >> 24);
+}
+
+#endif
+
+//------------------------------------------------------------------------------
+// Warp row which is completely inside the image, no bounds checks are required.
+// Sampled pixels for nearest: (px,py), bilinear: (px..px+1,py..py+1), 
+// bicubic: (px-1..px+2, py-1..py+2).
+
+static void _WarpRowInside(const unsigned char* src, int width, int height, double x, double y, double sx, double sy, EWarpFilter eFilter, bool bFill, unsigned char* out, int nCount)
+{
+   const size_t stride = 3*size_t(width);
+
+   if (eFilter == WARPFILTER_NEAREST)
+   {
+      for (int tx=0;tx<nCount;tx++)
+      {
+         if (!bFill || out[4*tx+3] == 0)
+         {
+            const unsigned char* p = src + size_t(int(y + double(tx)*sy))*stride + 3*size_t(int(x + double(tx)*sx));
+            out[4*tx+0] = p[0];
+            out[4*tx+1] = p[1];
+            out[4*tx+2] = p[2];
+            out[4*tx+3] = 255;
+         }
+      }
+      return;
+   }
+
+#ifdef OG_WARP_SSE2
+   // the 4 channels of a pixel are filtered at once
+   const __m128i zero = _mm_setzero_si128();
+   const __m128 one = _mm_set1_ps(1.0f);
+
+   if (eFilter == WARPFILTER_BILINEAR)
+   {
+      for (int tx=0;tx<nCount;tx++)
+      {
+         if (!bFill || out[4*tx+3] == 0)
+         {
+            double px = x + double(tx)*sx;
+            double py = y + double(tx)*sy;
+            int ix = int(px);
+            int iy = int(py);
+            __m128 u = _mm_set1_ps(float(px - double(ix)));
+            __m128 v = _mm_set1_ps(float(py - double(iy)));
+            __m128 iu = _mm_sub_ps(one, u);
+            __m128 iv = _mm_sub_ps(one, v);
+
+            const unsigned char* p0 = src + size_t(iy)*stride + 3*size_t(ix);
+            const unsigned char* p1 = p0 + stride;
+
+            __m128 top = _mm_add_ps(_mm_mul_ps(_LoadRGB(p0, zero), iu), _mm_mul_ps(_LoadRGB(p0+3, zero), u));
+            __m128 bottom = _mm_add_ps(_mm_mul_ps(_LoadRGB(p1, zero), iu), _mm_mul_ps(_LoadRGB(p1+3, zero), u));
+            _StoreRGBA(_mm_add_ps(_mm_mul_ps(top, iv), _mm_mul_ps(bottom, v)), out + 4*tx);
+         }
+      }
+   }
+   else
+   {
+      for (int tx=0;tx<nCount;tx++)
+      {
+         if (!bFill || out[4*tx+3] == 0)
+         {
+            double px = x + double(tx)*sx;
+            double py = y + double(tx)*sy;
+            int ix = int(px);
+            int iy = int(py);
+            double wx[4], wy[4];
+            _CubicWeights(px - double(ix), wx);
+            _CubicWeights(py - double(iy), wy);
+
+            __m128 wx0 = _mm_set1_ps(float(wx[0]));
+            __m128 wx1 = _mm_set1_ps(float(wx[1]));
+            __m128 wx2 = _mm_set1_ps(float(wx[2]));
+            __m128 wx3 = _mm_set1_ps(float(wx[3]));
+
+            const unsigned char* p = src + size_t(iy-1)*stride + 3*size_t(ix-1);
+            __m128 sum = _mm_setzero_ps();
+            for (int j=0;j<4;j++)
+            {
+               __m128 r = _mm_mul_ps(_LoadRGB(p, zero), wx0);
+               r = _mm_add_ps(r, _mm_mul_ps(_LoadRGB(p+3, zero), wx1));
+               r = _mm_add_ps(r, _mm_mul_ps(_LoadRGB(p+6, zero), wx2));
+               r = _mm_add_ps(r, _mm_mul_ps(_LoadRGB(p+9, zero), wx3));
+               sum = _mm_add_ps(sum, _mm_mul_ps(r, _mm_set1_ps(float(wy[j]))));
+               p += stride;
+            }
+
+            // weights sum up to 1, so alpha is 255 (before rounding)
+            _StoreRGBA(sum, out + 4*tx);
+            out[4*tx+3] = 255;
+         }
+      }
+   }
+#else
+   for (int tx=0;tx<nCount;tx++)
+   {
+      if (!bFill || out[4*tx+3] == 0)
+      {
+         _Sample(src, width, height, x + double(tx)*sx, y + double(tx)*sy, eFilter, out + 4*tx);
+         out[4*tx+3] = 255;
+      }
+   }
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+void ImageWarp::RGB(const unsigned char* src, int width, int height, const double corner[8], const double valid[4], EWarpFilter eFilter, bool bFill, unsigned char* tile, int tilesize)
+{
+   // area where the filter doesn't read outside of the image
+   double border0 = (eFilter == WARPFILTER_BICUBIC) ? 1.0 : 0.0;
+   double border1 = (eFilter == WARPFILTER_NEAREST) ? 0.0 : ((eFilter == WARPFILTER_BILINEAR) ? 1.0 : 2.0);
+   double inside[4];
+   inside[0] = valid[0] > border0 ? valid[0] : border0;
+   inside[1] = valid[1] > border0 ? valid[1] : border0;
+   inside[2] = double(width) - border1;
+   inside[3] = double(height) - border1;
+   if (valid[2] < inside[2]) inside[2] = valid[2];
+   if (valid[3] < inside[3]) inside[3] = valid[3];
+
+   for (int ty=0;ty<tilesize;ty++)
+   {
+      double x, y, sx, sy;
+      _RowMapping(corner, ty, tilesize, x, y, sx, sy);
+      unsigned char* out = tile + 4*size_t(ty)*size_t(tilesize);
+
+      // positions along a row are a linear function, so the row is inside if
+      // the first and the last pixel are inside.
+      double xe = x + double(tilesize-1)*sx;
+      double ye = y + double(tilesize-1)*sy;
+
+      if (x >= inside[0] && x < inside[2] && y >= inside[1] && y < inside[3] &&
+          xe >= inside[0] && xe < inside[2] && ye >= inside[1] && ye < inside[3])
+      {
+         _WarpRowInside(src, width, height, x, y, sx, sy, eFilter, bFill, out, tilesize);
+      }
+      else
+      {
+         _WarpRow(src, width, height, x, y, sx, sy, valid, eFilter, bFill, out, tilesize);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+
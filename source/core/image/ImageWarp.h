@@ -0,0 +1,61 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#ifndef _IMAGEWARP_H
+#define _IMAGEWARP_H
+
+#include "og.h"
+
+//------------------------------------------------------------------------------
+
+enum EWarpFilter
+{
+   WARPFILTER_NEAREST,
+   WARPFILTER_BILINEAR,
+   WARPFILTER_BICUBIC,
+};
+
+//------------------------------------------------------------------------------
+// Map (warp) source images to tiles. The position of a tile pixel in the 
+// source image is the bilinear interpolation of the positions of the 4 corner 
+// pixels of the tile, so positions are calculated incrementally along a row. 
+// Rows completely inside the source image are sampled without any bounds 
+// checks, SSE2 is used for filtering if available.
+
+class OPENGLOBE_API ImageWarp
+{
+public:
+   // Warp RGB image (3 bytes per pixel) with size (width, height) to RGBA 
+   // tile with size (tilesize, tilesize).
+   // corner: position (x,y) in source image of the tile pixels (0,0), 
+   //         (tilesize-1,0), (tilesize-1,tilesize-1) and (0,tilesize-1).
+   // valid:  area (x0,y0,x1,y1) of the source image containing data. Pixels 
+   //         mapped outside of this area are not written, all other pixels 
+   //         are written with alpha 255. Pixels outside of the image but inside
+   //         the valid area are clamped to the border of the image.
+   // If bFill is true, only pixels with alpha 0 are written.
+   static void RGB(const unsigned char* src, int width, int height, const double corner[8], const double valid[4], EWarpFilter eFilter, bool bFill, unsigned char* tile, int tilesize);
+
+   // Reference implementation without SSE and without fast path.
+   static void RGB_Scalar(const unsigned char* src, int width, int height, const double corner[8], const double valid[4], EWarpFilter eFilter, bool bFill, unsigned char* tile, int tilesize);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
+
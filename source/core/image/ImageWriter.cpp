@@ -23,7 +23,61 @@
 
 #include "image/JPEGHandler.h"
 
+#ifdef OG_USE_ZLIB
+#include <zlib.h>
+#endif
+
 #include <fstream>
+#include <cstring>
+
+//------------------------------------------------------------------------------
+
+PNGSettings::PNGSettings()
+{
+#ifdef OG_USE_ZLIB
+   eEncoder = Img::PNGEncoder_ZLIB;
+#else
+   eEncoder = Img::PNGEncoder_STB;
+#endif
+   nLevel = 3;
+   eFilter = Img::PNGFilter_Adaptive;
+}
+
+//------------------------------------------------------------------------------
+
+bool PNGSettings::SetFilter(const std::string& sFilter)
+{
+   if (sFilter == "none")           { eFilter = Img::PNGFilter_None; }
+   else if (sFilter == "sub")       { eFilter = Img::PNGFilter_Sub; }
+   else if (sFilter == "up")        { eFilter = Img::PNGFilter_Up; }
+   else if (sFilter == "average")   { eFilter = Img::PNGFilter_Average; }
+   else if (sFilter == "paeth")     { eFilter = Img::PNGFilter_Paeth; }
+   else if (sFilter == "adaptive")  { eFilter = Img::PNGFilter_Adaptive; }
+   else 
+   {
+      return false;
+   }
+
+   return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool PNGSettings::SetEncoder(const std::string& sEncoder)
+{
+   if (sEncoder == "stb")        { eEncoder = Img::PNGEncoder_STB; }
+   else if (sEncoder == "zlib")  { eEncoder = Img::PNGEncoder_ZLIB; }
+   else
+   {
+      return false;
+   }
+
+   return true;
+}
+
+//------------------------------------------------------------------------------
+
+static PNGSettings s_PNGSettings;   // settings used by WritePNG
 
 //------------------------------------------------------------------------------
 
@@ -39,13 +93,259 @@ ImageWriter::~ImageWriter()
 
 //------------------------------------------------------------------------------
 
+void ImageWriter::SetPNGSettings(const PNGSettings& settings)
+{
+   s_PNGSettings = settings;
+}
+
+//------------------------------------------------------------------------------
 
-bool ImageWriter::WritePNG(const std::string& sFilename, unsigned char* buffer_rbga, int width, int height)
+const PNGSettings& ImageWriter::GetPNGSettings()
 {
-   return (stbi_write_png(sFilename.c_str(), width, height, 4, buffer_rbga, 4*width) == 0);
+   return s_PNGSettings;
 }
 
+//------------------------------------------------------------------------------
+// apply PNG filter type (0-4) to a scanline. prev is the unfiltered previous 
+// scanline (all zero for first scanline).
+
+static void _FilterScanline(unsigned char* out, const unsigned char* line, const unsigned char* prev, size_t nBytes, int bpp, int type)
+{
+   size_t i;
+
+   switch (type)
+   {
+   case Img::PNGFilter_None:
+      memcpy(out, line, nBytes);
+      break;
+   case Img::PNGFilter_Sub:
+      for (i=0;i<(size_t)bpp;i++) out[i] = line[i];
+      for (i=bpp;i<nBytes;i++) out[i] = (unsigned char)(line[i] - line[i-bpp]);
+      break;
+   case Img::PNGFilter_Up:
+      for (i=0;i<nBytes;i++) out[i] = (unsigned char)(line[i] - prev[i]);
+      break;
+   case Img::PNGFilter_Average:
+      for (i=0;i<(size_t)bpp;i++) out[i] = (unsigned char)(line[i] - (prev[i]>>1));
+      for (i=bpp;i<nBytes;i++) out[i] = (unsigned char)(line[i] - ((line[i-bpp] + prev[i])>>1));
+      break;
+   case Img::PNGFilter_Paeth:
+      for (i=0;i<(size_t)bpp;i++) out[i] = (unsigned char)(line[i] - stbi__paeth(0, prev[i], 0));
+      for (i=bpp;i<nBytes;i++) out[i] = (unsigned char)(line[i] - stbi__paeth(line[i-bpp], prev[i], prev[i-bpp]));
+      break;
+   default:
+      assert(false);
+   }
+}
+
+//------------------------------------------------------------------------------
+// create filtered scanlines (filter type byte + filtered data for every scanline)
+
+static void _FilterImage(const unsigned char* pixels, int width, int height, int bpp, Img::PNGFilter eFilter, std::vector<unsigned char>& out)
+{
+   size_t nBytes = size_t(width)*size_t(bpp);
+   std::vector<unsigned char> vZero(nBytes, 0);
+   std::vector<unsigned char> vTest;
+
+   out.resize((nBytes+1)*size_t(height));
+
+   if (eFilter == Img::PNGFilter_Adaptive)
+   {
+      vTest.resize(nBytes);
+   }
+
+   for (int y=0;y<height;y++)
+   {
+      const unsigned char* line = pixels + size_t(y)*nBytes;
+      const unsigned char* prev = y>0 ? line - nBytes : &vZero[0];
+      unsigned char* dst = &out[size_t(y)*(nBytes+1)];
 
+      if (eFilter != Img::PNGFilter_Adaptive)
+      {
+         dst[0] = (unsigned char)eFilter;
+         _FilterScanline(dst+1, line, prev, nBytes, bpp, eFilter);
+      }
+      else
+      {
+         // use filter with minimum sum of absolute (signed) values
+         size_t nBest = 0;
+         for (int type=Img::PNGFilter_None;type<=Img::PNGFilter_Paeth;type++)
+         {
+            _FilterScanline(&vTest[0], line, prev, nBytes, bpp, type);
+            size_t nSum = 0;
+            for (size_t i=0;i<nBytes;i++)
+            {
+               nSum += abs((int)(signed char)vTest[i]);
+            }
+
+            if (type == Img::PNGFilter_None || nSum < nBest)
+            {
+               nBest = nSum;
+               dst[0] = (unsigned char)type;
+               memcpy(dst+1, &vTest[0], nBytes);
+            }
+         }
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// zlib stream without compression (level 0)
+
+static void _DeflateStored(const unsigned char* data, size_t nSize, std::vector<unsigned char>& out)
+{
+   out.clear();
+   out.reserve(nSize + 6 + 5*(nSize/65535+1));
+   out.push_back(0x78);
+   out.push_back(0x01);
+
+   size_t pos = 0;
+   do
+   {
+      size_t nBlock = math::Min<size_t>(nSize - pos, 65535);
+      out.push_back(pos + nBlock == nSize ? 1 : 0);    // BFINAL, BTYPE 00
+      out.push_back((unsigned char)(nBlock & 255));
+      out.push_back((unsigned char)(nBlock >> 8));
+      out.push_back((unsigned char)(~nBlock & 255));
+      out.push_back((unsigned char)((~nBlock >> 8) & 255));
+      out.insert(out.end(), data + pos, data + pos + nBlock);
+      pos += nBlock;
+   } while (pos < nSize);
+
+   unsigned int s1 = 1, s2 = 0;
+   for (size_t i=0;i<nSize;i++)
+   {
+      s1 = (s1 + data[i]) % 65521;
+      s2 = (s2 + s1) % 65521;
+   }
+   out.push_back((unsigned char)(s2 >> 8));
+   out.push_back((unsigned char)s2);
+   out.push_back((unsigned char)(s1 >> 8));
+   out.push_back((unsigned char)s1);
+}
+
+//------------------------------------------------------------------------------
+
+static bool _Deflate(std::vector<unsigned char>& data, const PNGSettings& settings, std::vector<unsigned char>& out)
+{
+   int nLevel = math::Max<int>(0, math::Min<int>(9, settings.nLevel));
+
+#ifdef OG_USE_ZLIB
+   if (settings.eEncoder == Img::PNGEncoder_ZLIB)
+   {
+      uLongf nOutSize = compressBound((uLong)data.size());
+      out.resize(nOutSize);
+      if (compress2(&out[0], &nOutSize, &data[0], (uLong)data.size(), nLevel) != Z_OK)
+      {
+         return false;
+      }
+      out.resize(nOutSize);
+      return true;
+   }
+#endif
+
+   if (nLevel == 0)
+   {
+      _DeflateStored(&data[0], data.size(), out);
+      return true;
+   }
+
+   // stb quality is the maximum length of the hash chains (previously 8, which is level 6)
+   int nLen = 0;
+   unsigned char* pZlib = stbi_zlib_compress(&data[0], (int)data.size(), &nLen, nLevel + 2);
+   if (!pZlib)
+   {
+      return false;
+   }
+   out.assign(pZlib, pZlib + nLen);
+   free(pZlib);
+
+   return true;
+}
+
+//------------------------------------------------------------------------------
+
+static void _AppendChunk(std::vector<unsigned char>& png, const char* type, const unsigned char* data, size_t nSize)
+{
+   size_t start = png.size();
+   png.resize(start + 12 + nSize);
+   unsigned char* p = &png[start];
+   stbi__wp32(p, (unsigned int)nSize);
+   stbi__wptag(p, type);
+   if (nSize > 0)
+   {
+      memcpy(p, data, nSize);
+   }
+   p += nSize;
+   unsigned int crc = stbi__crc32(&png[start+4], (int)nSize + 4);
+   stbi__wp32(p, crc);
+}
+
+//------------------------------------------------------------------------------
+
+bool ImageWriter::EncodePNG(const unsigned char* buffer_rbga, int width, int height, const PNGSettings& settings, std::vector<unsigned char>& out)
+{
+   if (!buffer_rbga || width <= 0 || height <= 0)
+   {
+      return false;
+   }
+
+   std::vector<unsigned char> vFiltered, vZlib;
+   _FilterImage(buffer_rbga, width, height, 4, settings.eFilter, vFiltered);
+
+   if (!_Deflate(vFiltered, settings, vZlib))
+   {
+      return false;
+   }
+
+   static const unsigned char sig[8] = { 137,80,78,71,13,10,26,10 };
+   unsigned char ihdr[13];
+   unsigned char* p = ihdr;
+   stbi__wp32(p, (unsigned int)width);
+   stbi__wp32(p, (unsigned int)height);
+   ihdr[8] = 8;   // bit depth
+   ihdr[9] = 6;   // color type RGBA
+   ihdr[10] = 0;  // compression
+   ihdr[11] = 0;  // filter method
+   ihdr[12] = 0;  // no interlace
+
+   out.clear();
+   out.reserve(8 + 12+13 + 12+vZlib.size() + 12);
+   out.insert(out.end(), sig, sig+8);
+   _AppendChunk(out, "IHDR", ihdr, 13);
+   _AppendChunk(out, "IDAT", &vZlib[0], vZlib.size());
+   _AppendChunk(out, "IEND", 0, 0);
+
+   return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool ImageWriter::WritePNG(const std::string& sFilename, unsigned char* buffer_rbga, int width, int height, const PNGSettings& settings)
+{
+   std::vector<unsigned char> vPNG;
+   if (!EncodePNG(buffer_rbga, width, height, settings, vPNG))
+   {
+      return false;
+   }
+
+   std::ofstream off(sFilename.c_str(), std::ios::out | std::ios::binary);
+   if (off.good())
+   {
+      off.write((char*)&vPNG[0], (std::streamsize)vPNG.size());
+      off.close();
+      return !off.fail();
+   }
+
+   return false;
+}
+
+//------------------------------------------------------------------------------
+
+bool ImageWriter::WritePNG(const std::string& sFilename, unsigned char* buffer_rbga, int width, int height)
+{
+   return WritePNG(sFilename, buffer_rbga, width, height, s_PNGSettings);
+}
 
 //------------------------------------------------------------------------------
 
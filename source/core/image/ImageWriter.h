@@ -22,6 +22,46 @@
 #include "og.h"
 #include "image/ImageHandler.h"
 #include <string>
+#include <vector>
+
+namespace Img
+{
+   enum PNGEncoder
+   {
+      PNGEncoder_STB,      // built in deflate (stb_image_write), always available
+      PNGEncoder_ZLIB,     // zlib deflate, only available if compiled with OG_USE_ZLIB (otherwise STB is used)
+   };
+
+   enum PNGFilter
+   {
+      PNGFilter_None = 0,  // PNG filter types 0 to 4, same filter for all scanlines
+      PNGFilter_Sub = 1,
+      PNGFilter_Up = 2,
+      PNGFilter_Average = 3,
+      PNGFilter_Paeth = 4,
+      PNGFilter_Adaptive,  // choose filter for each scanline (minimum sum of absolute differences)
+   };
+}
+
+//------------------------------------------------------------------------------
+// Settings for writing PNG files.
+
+struct OPENGLOBE_API PNGSettings
+{
+   PNGSettings();
+
+   Img::PNGEncoder   eEncoder;   // deflate implementation (default: zlib if available)
+   int               nLevel;     // compression level: 0 (no compression, fastest) to 9 (smallest), default 3
+   Img::PNGFilter    eFilter;    // scanline filter, default adaptive
+
+   // set filter by name ("none", "sub", "up", "average", "paeth" or "adaptive"). Returns false if name is unknown.
+   bool SetFilter(const std::string& sFilter);
+
+   // set encoder by name ("stb" or "zlib"). Returns false if name is unknown.
+   bool SetEncoder(const std::string& sEncoder);
+};
+
+//------------------------------------------------------------------------------
 
 class OPENGLOBE_API ImageWriter
 {
@@ -29,12 +69,22 @@ public:
    ImageWriter();
    virtual ~ImageWriter();
 
-   // write rgba buffer to PNG
+   // write rgba buffer to PNG (using settings set with SetPNGSettings)
    static bool WritePNG(const std::string& sFilename, unsigned char* buffer_rbga, int width, int height);
 
+   // write rgba buffer to PNG using specified settings
+   static bool WritePNG(const std::string& sFilename, unsigned char* buffer_rbga, int width, int height, const PNGSettings& settings);
+
    // write imageobject to PNG (currently only RGBA images are supported)
    static bool WritePNG(const std::string& sFilename, ImageObject& image);
 
+   // encode rgba buffer to PNG in memory
+   static bool EncodePNG(const unsigned char* buffer_rbga, int width, int height, const PNGSettings& settings, std::vector<unsigned char>& out);
+
+   // set settings used by WritePNG. Call this before starting to write tiles, it is not thread safe.
+   static void SetPNGSettings(const PNGSettings& settings);
+   static const PNGSettings& GetPNGSettings();
+
    // writes JPG image. Note: Image is converted to RGB.
    static bool WriteJPG(const std::string& sFilename, ImageObject& image, int quality);
 
@@ -21,9 +21,18 @@
 #include <fstream>
 #define BOOST_FILESYSTEM_VERSION 2
 #include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <set>
+#include <map>
 #include <fcntl.h>
+#ifndef OS_WINDOWS
+#include <unistd.h>
+#endif
 #ifdef OS_WINDOWS
 #include <share.h>
 #include <io.h>
@@ -102,6 +111,23 @@ bool FileSystem::rename(const std::string& sFile1, const std::string& sFile2)
 
 //-----------------------------------------------------------------------------
 
+bool FileSystem::copy(const std::string& sFile1, const std::string& sFile2)
+{
+   try
+   {
+      boost::filesystem::remove(sFile2);
+      boost::filesystem::copy_file(sFile1, sFile2);
+   }
+   catch ( std::exception const& )
+   {
+      return false;
+   }
+
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+
 bool FileSystem::FileExists(const std::string& sFile)
 {
    return boost::filesystem::exists(sFile);
@@ -358,44 +384,420 @@ std::vector<std::string> FileSystem::LinesToVector(const std::string& sPath)
    return vOut;
 }
 //------------------------------------------------------------------------------
-// lock mechanism implemented according to:
+// Lock state of this process
+
+namespace
+{
+   typedef std::pair<std::string, int64> LockKey;  // lock file, byte offset
+
+   struct LockFileRef
+   {
+      int fd;
+      int refcount;
+   };
+
+   struct LockState
+   {
+      LockState() : eMode(LOCKMODE_LOCKFILE), bModeFixed(false), bUnsupported(false)
+      {
+         const char* szMode = getenv("OPENWEBGLOBE_LOCKMODE");
+         if (szMode && std::string(szMode) == "advisory")
+         {
+            eMode = LOCKMODE_ADVISORY;
+         }
+         else if (szMode && std::string(szMode) != "file")
+         {
+            std::cout << "WARNING: unknown OPENWEBGLOBE_LOCKMODE " << szMode << ", using lock files.\n";
+         }
+
+         const char* szLockFile = getenv("OPENWEBGLOBE_LOCKFILE");
+         if (szLockFile)
+         {
+            sLockFile = szLockFile;
+         }
+      }
+
+      boost::mutex                        mutex;
+      boost::condition_variable           cond;
+      ELockMode                           eMode;
+      bool                                bModeFixed;  // a file was locked, mode can't change anymore
+      bool                                bUnsupported; // advisory locks failed (error was reported)
+      std::string                         sLockFile;   // single lock file for advisory locks (optional)
+      LockStatistics                      stats;
+      std::set<LockKey>                   setLocked;   // advisory locks held by threads of this process
+      std::map<std::string, LockFileRef>  mapFiles;    // open lock files (advisory locks)
+   };
+
+   LockState& _GetLockState()
+   {
+      static LockState s_state;
+      return s_state;
+   }
+
+   //---------------------------------------------------------------------------
+
+   void _SleepMs(int ms)
+   {
+      boost::this_thread::sleep(boost::posix_time::milliseconds(ms));
+   }
+
+   //---------------------------------------------------------------------------
+
+   double _ElapsedSeconds(const boost::posix_time::ptime& t0)
+   {
+      return double((boost::posix_time::microsec_clock::universal_time() - t0).total_microseconds()) / 1e6;
+   }
+
+   //---------------------------------------------------------------------------
+   // Advisory locks of all files in a directory are byte range locks in one
+   // lock file per directory, the offset is a hash of the filename (different 
+   // files with same hash share a lock, which is safe). With a single lock
+   // file the hash of the whole path is used.
+
+   LockKey _GetLockKey(const std::string& sLockFile, const std::string& file)
+   {
+      size_t pos = file.find_last_of("/\\");
+      std::string sDir = (pos == std::string::npos) ? std::string() : file.substr(0, pos+1);
+      std::string sName = (pos == std::string::npos || sLockFile.length() > 0) ? file : file.substr(pos+1);
+
+      uint64 hash = 14695981039346656037ULL;  // FNV-1a
+      for (size_t i=0;i<sName.length();i++)
+      {
+         hash ^= (unsigned char)sName[i];
+         hash *= 1099511628211ULL;
+      }
+
+      return LockKey(sLockFile.length() > 0 ? sLockFile : sDir + ".oglock", int64(hash & 0xFFFFFF));
+   }
+}
+
+//------------------------------------------------------------------------------
+
+bool FileSystem::SetLockMode(ELockMode eMode)
+{
+   LockState& state = _GetLockState();
+   boost::mutex::scoped_lock lock(state.mutex);
+   if (state.bModeFixed && state.eMode != eMode)
+   {
+      std::cout << "ERROR: can't change lock mode after locking files.\n";
+      return false;
+   }
+   state.eMode = eMode;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool FileSystem::SetLockMode(const std::string& sMode)
+{
+   if (sMode == "advisory" || sMode == "fcntl")
+   {
+      return SetLockMode(LOCKMODE_ADVISORY);
+   }
+   else if (sMode == "file")
+   {
+      return SetLockMode(LOCKMODE_LOCKFILE);
+   }
+
+   return false;
+}
+
+//------------------------------------------------------------------------------
+
+ELockMode FileSystem::GetLockMode()
+{
+   LockState& state = _GetLockState();
+   boost::mutex::scoped_lock lock(state.mutex);
+   return state.eMode;
+}
+
+//------------------------------------------------------------------------------
+
+LockStatistics FileSystem::GetLockStatistics()
+{
+   LockState& state = _GetLockState();
+   boost::mutex::scoped_lock lock(state.mutex);
+   return state.stats;
+}
+
+//------------------------------------------------------------------------------
+
+void FileSystem::ResetLockStatistics()
+{
+   LockState& state = _GetLockState();
+   boost::mutex::scoped_lock lock(state.mutex);
+   state.stats = LockStatistics();
+}
+
+//------------------------------------------------------------------------------
+// lock file mechanism implemented according to:
 // http://www.dwheeler.com/secure-programs/Secure-Programs-HOWTO/avoid-race.html
 // http://wiki.lustre.org/index.php/Architecture_-_External_File_Locking
 
-int FileSystem::Lock(const std::string& file)
+static int _LockFile(const std::string& file, int nTimeout, bool& bContended)
 {
    std::string sLockFile = file + ".lock";
-
-  
    int open_flags =  O_CREAT|O_EXCL;
+   int nWait = 1;  // ms, doubled after every attempt up to 1 s
+   boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
 
-   int fd = -1;
-   
-   fd = open (sLockFile.c_str(), open_flags, 660);
+   int fd = open (sLockFile.c_str(), open_flags, 0660);
    while (fd == -1)
    {
+      bContended = true;
+      if (nTimeout >= 0 && _ElapsedSeconds(t0)*1000.0 >= nTimeout)
+      {
+         return -1;
+      }
 
-#     ifdef OS_WINDOWS
-         Sleep(1);
-#     else
-         sleep(1);
-#     endif
+      _SleepMs(nWait);
+      nWait = nWait < 1000 ? 2*nWait : 1000;
 
-      fd = open (sLockFile.c_str(), open_flags, 660);
+      fd = open (sLockFile.c_str(), open_flags, 0660);
    }
 
    return fd;
 }
+
 //------------------------------------------------------------------------------
+
+#ifndef OS_WINDOWS
+
+// Returns 0 if lock was acquired, 1 on timeout, -1 if kernel locks are not supported.
+static int _LockRange(int fd, int64 offset, int nTimeout, bool& bContended)
+{
+   struct flock fl;
+   memset(&fl, 0, sizeof(fl));
+   fl.l_type = F_WRLCK;
+   fl.l_whence = SEEK_SET;
+   fl.l_start = (off_t)offset;
+   fl.l_len = 1;
+
+   if (fcntl(fd, F_SETLK, &fl) == 0)
+   {
+      return 0;
+   }
+
+   if (errno != EACCES && errno != EAGAIN && errno != EINTR)
+   {
+      return -1;
+   }
+
+   bContended = true;
+
+   if (nTimeout < 0)
+   {
+      // blocking wait
+      while (fcntl(fd, F_SETLKW, &fl) == -1)
+      {
+         if (errno != EINTR)
+         {
+            return -1;
+         }
+      }
+      return 0;
+   }
+
+   boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+   int nWait = 1;
+   while (_ElapsedSeconds(t0)*1000.0 < nTimeout)
+   {
+      _SleepMs(nWait);
+      nWait = nWait < 50 ? 2*nWait : 50;
+
+      if (fcntl(fd, F_SETLK, &fl) == 0)
+      {
+         return 0;
+      }
+      if (errno != EACCES && errno != EAGAIN && errno != EINTR)
+      {
+         return -1;
+      }
+   }
+
+   return 1;
+}
+
+//------------------------------------------------------------------------------
+
+static void _UnlockRange(int fd, int64 offset)
+{
+   struct flock fl;
+   memset(&fl, 0, sizeof(fl));
+   fl.l_type = F_UNLCK;
+   fl.l_whence = SEEK_SET;
+   fl.l_start = (off_t)offset;
+   fl.l_len = 1;
+   fcntl(fd, F_SETLK, &fl);
+}
+
+//------------------------------------------------------------------------------
+// Release lock of this process (state.mutex must be locked)
+
+static void _ReleaseAdvisory(LockState& state, const LockKey& key)
+{
+   state.setLocked.erase(key);
+
+   std::map<std::string, LockFileRef>::iterator it = state.mapFiles.find(key.first);
+   if (it != state.mapFiles.end() && --it->second.refcount == 0)
+   {
+      // closing a file releases all fcntl locks of the process on that file,
+      // this is only done when no lock is held.
+      close(it->second.fd);
+      state.mapFiles.erase(it);
+   }
+
+   state.cond.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// fcntl locks belong to the process, threads of this process are 
+// synchronized using state.setLocked.
+
+static int _LockAdvisory(const std::string& file, int nTimeout, bool& bContended, bool& bSupported)
+{
+   LockState& state = _GetLockState();
+   LockKey key = _GetLockKey(state.sLockFile, file);
+   boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(nTimeout < 0 ? 0 : nTimeout);
+   int fd;
+
+   {
+      boost::mutex::scoped_lock lock(state.mutex);
+      while (state.setLocked.count(key))
+      {
+         bContended = true;
+         if (nTimeout < 0)
+         {
+            state.cond.wait(lock);
+         }
+         else if (!state.cond.timed_wait(lock, deadline) && state.setLocked.count(key))
+         {
+            return -1;
+         }
+      }
+
+      std::map<std::string, LockFileRef>::iterator it = state.mapFiles.find(key.first);
+      if (it == state.mapFiles.end())
+      {
+         LockFileRef ref;
+         ref.fd = open(key.first.c_str(), O_CREAT|O_RDWR, 0660);
+         ref.refcount = 0;
+         if (ref.fd == -1)
+         {
+            std::cout << "ERROR: can't open lock file " << key.first << "\n";
+            return -1;
+         }
+         it = state.mapFiles.insert(std::make_pair(key.first, ref)).first;
+      }
+
+      it->second.refcount++;
+      state.setLocked.insert(key);
+      fd = it->second.fd;
+   }
+
+   // lock for other processes (on this or other computers)
+   if (nTimeout >= 0)
+   {
+      int64 nRemaining = (deadline - boost::get_system_time()).total_milliseconds();
+      nTimeout = nRemaining > 0 ? int(nRemaining) : 0;
+   }
+
+   int result = _LockRange(fd, key.second, nTimeout, bContended);
+   if (result != 0)
+   {
+      boost::mutex::scoped_lock lock(state.mutex);
+      _ReleaseAdvisory(state, key);
+      bSupported = (result != -1);
+      return -1;
+   }
+
+   return fd;
+}
+
+#endif
+
+//------------------------------------------------------------------------------
+
+int FileSystem::Lock(const std::string& file, int nTimeout)
+{
+   LockState& state = _GetLockState();
+   boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+   bool bContended = false;
+   int handle = -1;
+   ELockMode eMode;
+
+   {
+      // the mode is fixed from now on: switching while other threads or
+      // processes hold locks in the other mode would break exclusion.
+      boost::mutex::scoped_lock lock(state.mutex);
+      state.bModeFixed = true;
+      eMode = state.eMode;
+   }
+
+#ifndef OS_WINDOWS
+   if (eMode == LOCKMODE_ADVISORY)
+   {
+      bool bSupported = true;
+      handle = _LockAdvisory(file, nTimeout, bContended, bSupported);
+      if (handle == -1 && !bSupported)
+      {
+         boost::mutex::scoped_lock lock(state.mutex);
+         if (!state.bUnsupported)
+         {
+            std::cout << "ERROR: advisory file locks are not supported on this file system. Set OPENWEBGLOBE_LOCKMODE=file for all processes.\n";
+            state.bUnsupported = true;
+         }
+      }
+   }
+   else
+#endif
+   {
+      handle = _LockFile(file, nTimeout, bContended);
+   }
+
+   boost::mutex::scoped_lock lock(state.mutex);
+   if (handle != -1)
+   {
+      state.stats.nLocks++;
+   }
+   else
+   {
+      state.stats.nTimeouts++;
+   }
+   if (bContended)
+   {
+      state.stats.nContended++;
+      state.stats.dWaitTime += _ElapsedSeconds(t0);
+   }
+
+   return handle;
+}
+
+//------------------------------------------------------------------------------
+
 void FileSystem::Unlock(const std::string& file, int handle)
 {
    if (handle == -1)
 	  return;
+
+#ifndef OS_WINDOWS
+   LockState& state = _GetLockState();
+   boost::mutex::scoped_lock lock(state.mutex);
+   LockKey key = _GetLockKey(state.sLockFile, file);
+   if (state.setLocked.count(key))
+   {
+      _UnlockRange(handle, key.second);
+      _ReleaseAdvisory(state, key);
+      return;
+   }
+   lock.unlock();
+#endif
+
    std::string sLockFile = file + ".lock";
    close(handle);
    unlink(sLockFile.c_str());
-   
 }
+
 //------------------------------------------------------------------------------
 std::string FileSystem::GetCWD()
 {
@@ -26,6 +26,36 @@
 #include <boost/shared_array.hpp>
 #include <stdint.h>
 
+//------------------------------------------------------------------------------
+//! Lock mechanism used by FileSystem::Lock. The mode of a process is taken
+//! from the environment variable OPENWEBGLOBE_LOCKMODE ("file" or "advisory",
+//! default is "file"), so all tools use the same mechanism.
+//! Advisory locks are only safe on file systems with cluster wide fcntl locks
+//! (e.g. NFS with lockd, Lustre mounted with "flock"). With NFS "nolock" or
+//! Lustre "localflock" they only lock on the local node! Run ogFileLockTest
+//! on several nodes before enabling them.
+//! Advisory locks use a lock file ".oglock" per directory. If the environment
+//! variable OPENWEBGLOBE_LOCKFILE is set, this single file is used instead
+//! (it must be on a file system shared by all nodes).
+enum ELockMode
+{
+   LOCKMODE_LOCKFILE = 0,  // exclusive lock file "<file>.lock" (polling), for shared file systems without lock support
+   LOCKMODE_ADVISORY = 1,  // kernel byte range lock (fcntl) in a shared lock file, blocking wait
+};
+
+//------------------------------------------------------------------------------
+//! Lock contention counters of this process
+struct OPENGLOBE_API LockStatistics
+{
+   LockStatistics() : nLocks(0), nContended(0), nTimeouts(0), dWaitTime(0) {}
+
+   uint64 nLocks;       // number of acquired locks
+   uint64 nContended;   // number of locks which were held by someone else when requested
+   uint64 nTimeouts;    // number of locks which couldn't be acquired in time
+   double dWaitTime;    // total time waiting for contended locks [s]
+};
+
+//------------------------------------------------------------------------------
 //! File utilities like creating directories, removing files, renaming, retrieving modification time etc.
 //! This is based on boost::filesystem (previous versions used wxWidgets and Qt)
 //! \author Martin Christen, martin.christen@fhnw.ch
@@ -69,6 +99,13 @@ public:
    static bool rename(const std::string& sFile1, const std::string& sFile2);
    //---------------------------------------------------------------------------
    /*!
+   * \brief Copies ascii sFile1 to ascii sFile2. An existing sFile2 is replaced.
+   * \param sFile1 File to be copied
+   * \param sFile2 Name of the copy
+   */
+   static bool copy(const std::string& sFile1, const std::string& sFile2);
+   //---------------------------------------------------------------------------
+   /*!
    * \brief Returns true if the ascii file exists and is a plain file.
    * \param sFile path to file
    * \return true or false
@@ -119,14 +156,15 @@ public:
    static std::vector<std::string> LinesToVector(const std::string& sPath);
    //---------------------------------------------------------------------------
    /*!
-   * \brief Exclusively locks a file by creating an exclusive locking file. 
+   * \brief Exclusively locks a file (see SetLockMode for the mechanism used). 
    * The file may not exist yet when this function is called! In this case it locks the "future" file.
    * If file is already locked, waits until the file can be accessed.
    * This function can be used on clusters.
    * \param file the filename of the file to be locked.
-   * \return handle
+   * \param nTimeout maximum time to wait in milliseconds, -1 waits forever.
+   * \return handle, -1 if the lock couldn't be acquired (timeout, or advisory locks not supported)
    */
-   static   int Lock(const std::string& file);
+   static   int Lock(const std::string& file, int nTimeout = -1);
    //---------------------------------------------------------------------------
    /*!
    * \brief unlocks a previously locked file. Other computers / processes / threads can access the file again.
@@ -135,6 +173,21 @@ public:
    */
    static   void Unlock(const std::string& file, int handle);
    //---------------------------------------------------------------------------
+   /*!
+   * \brief Set lock mechanism used by Lock/Unlock (overrides OPENWEBGLOBE_LOCKMODE).
+   * All processes working on the same files must use the same mode. The mode
+   * can't be changed once a file was locked.
+   * \return false if a file was already locked (mode is not changed)
+   */
+   static   bool SetLockMode(ELockMode eMode);
+   //! \brief Set lock mode by name ("advisory" or "file"). Returns false if name is unknown or a file was already locked.
+   static   bool SetLockMode(const std::string& sMode);
+   static   ELockMode GetLockMode();
+   //---------------------------------------------------------------------------
+   //! \brief Retrieve lock contention counters (of all threads of this process)
+   static   LockStatistics GetLockStatistics();
+   static   void ResetLockStatistics();
+   //---------------------------------------------------------------------------
    //! \brief Retrieve current working directory
    static std::string GetCWD();
 };
@@ -22,6 +22,8 @@
 #include "math/ElevationPoint.h"
 #include <float.h>
 #include <vector>
+#include <algorithm>
+#include <utility>
 #include <cstddef>
 
 namespace math
@@ -40,6 +42,78 @@ namespace math
       return c;
    }
 
+   //--------------------------------------------------------------------------
+   // Index of cell (x,y) on a hilbert curve covering 2^order x 2^order cells.
+   inline uint64 HilbertIndex(unsigned int x, unsigned int y, int order)
+   {
+      uint64 d = 0;
+      for (unsigned int s = 1u << (order-1); s > 0; s /= 2)
+      {
+         unsigned int rx = (x & s) > 0 ? 1 : 0;
+         unsigned int ry = (y & s) > 0 ? 1 : 0;
+         d += uint64(s) * uint64(s) * uint64((3 * rx) ^ ry);
+
+         // rotate quadrant
+         if (ry == 0)
+         {
+            if (rx == 1)
+            {
+               x = s-1 - (x & (s-1));
+               y = s-1 - (y & (s-1));
+            }
+            std::swap(x, y);
+         }
+      }
+      return d;
+   }
+
+   //--------------------------------------------------------------------------
+   // Calculate an order of the points along a hilbert curve, so that successive
+   // points are close to each other. vOrder contains the indices of the points.
+   // Points in the same hilbert cell keep their relative order.
+   inline void HilbertOrder(const std::vector<ElevationPoint>& vPoints, std::vector<size_t>& vOrder)
+   {
+      const int order = 16;
+      const double cells = double(1 << order);
+
+      vOrder.clear();
+      if (vPoints.size() == 0)
+      {
+         return;
+      }
+
+      double xmin = vPoints[0].x, xmax = vPoints[0].x;
+      double ymin = vPoints[0].y, ymax = vPoints[0].y;
+
+      for (size_t i=1;i<vPoints.size();i++)
+      {
+         xmin = std::min<double>(xmin, vPoints[i].x);
+         ymin = std::min<double>(ymin, vPoints[i].y);
+         xmax = std::max<double>(xmax, vPoints[i].x);
+         ymax = std::max<double>(ymax, vPoints[i].y);
+      }
+
+      double sx = xmax > xmin ? (cells-1.0) / (xmax-xmin) : 0.0;
+      double sy = ymax > ymin ? (cells-1.0) / (ymax-ymin) : 0.0;
+
+      // (hilbert index, point index): sorting pairs keeps the original order for equal indices
+      std::vector<std::pair<uint64, size_t> > vKeys(vPoints.size());
+      for (size_t i=0;i<vPoints.size();i++)
+      {
+         unsigned int cx = (unsigned int)((vPoints[i].x - xmin) * sx);
+         unsigned int cy = (unsigned int)((vPoints[i].y - ymin) * sy);
+         vKeys[i] = std::make_pair(HilbertIndex(cx, cy, order), i);
+      }
+
+      std::sort(vKeys.begin(), vKeys.end());
+
+      vOrder.resize(vKeys.size());
+      for (size_t i=0;i<vKeys.size();i++)
+      {
+         vOrder[i] = vKeys[i].second;
+      }
+   }
+
    //--------------------------------------------------------------------------
 }
 
@@ -26,6 +26,7 @@
 #include "DelaunayLocationLinear.inl"
 #include "DelaunayLocationQuadtree.inl"
 #include "DelaunayLocationKdTree.inl"
+#include "DelaunayLocationWalk.inl"
 #include <float.h>
 #include <iostream>
 
@@ -42,9 +43,6 @@ namespace math
 
    boost::shared_ptr<IDelaunayLocationStructure>   IDelaunayLocationStructure::CreateLocationStructure(double xmin, double ymin, double xmax, double ymax, EDelaunayLocationAlgorithms eAlgorithm)
    {
-       return boost::shared_ptr<IDelaunayLocationStructure>(new DelaunayLocationLinear());
-
-
       if (eAlgorithm == DELAUNAYLOCATION_LINEARLIST)
       {
 #ifdef _DEBUG
@@ -52,17 +50,23 @@ namespace math
 #endif
          return boost::shared_ptr<IDelaunayLocationStructure>(new DelaunayLocationLinear());
       }
-      else if (eAlgorithm == DELAUNAYLOCATION_QUADTREE_HIERARCHY)
+      else if (eAlgorithm == DELAUNAYLOCATION_JUMPANDWALK)
       {
 #ifdef _DEBUG
-         std::cout << "Location Struct: Quadtree Hierarchy\n";
+         std::cout << "Location Struct: Jump and Walk\n";
 #endif
-         return boost::shared_ptr<IDelaunayLocationStructure>(new DelaunayLocationQuadtreeHierarchy(xmin, ymin, xmax, ymax));
+         return boost::shared_ptr<IDelaunayLocationStructure>(new DelaunayLocationJumpAndWalk(xmin, ymin, xmax, ymax));
       }
-      else if (eAlgorithm == DELAUNAYLOCATION_KDTREE_HIERARCHY)
+      else if (eAlgorithm == DELAUNAYLOCATION_QUADTREE_HIERARCHY || 
+               eAlgorithm == DELAUNAYLOCATION_KDTREE_HIERARCHY)
       {
-         assert(false); // not yet implemented!!
-         return boost::shared_ptr<IDelaunayLocationStructure>(new DelaunayLocationKdTreeHierarchy(xmin, ymin, xmax, ymax));
+         // The hierarchies are not notified when triangles are flipped in place 
+         // (DelaunayTriangle::FlipEdge), so they can't locate points reliably.
+         // Jump and walk is used instead.
+#ifdef _DEBUG
+         std::cout << "Location Struct: Hierarchy not supported, using Jump and Walk\n";
+#endif
+         return boost::shared_ptr<IDelaunayLocationStructure>(new DelaunayLocationJumpAndWalk(xmin, ymin, xmax, ymax));
       }
       else
       {
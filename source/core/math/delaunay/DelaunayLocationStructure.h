@@ -34,6 +34,7 @@ namespace math
       DELAUNAYLOCATION_LINEARLIST = 0,          // not accelerated location function, triangles are stored in a list.
       DELAUNAYLOCATION_QUADTREE_HIERARCHY = 1,  // accelerated using quadtree hierachy   
       DELAUNAYLOCATION_KDTREE_HIERARCHY = 2,    // accelerated using kd-tree hierachy (also known as BHI or SKD-TREE)
+      DELAUNAYLOCATION_JUMPANDWALK = 3,         // accelerated using a uniform grid (jump) and walking along neighbour triangles (walk)
    };
 
    //--------------------------------------------------------------------------
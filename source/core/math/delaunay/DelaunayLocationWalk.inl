@@ -0,0 +1,328 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+namespace math
+{
+   //--------------------------------------------------------------------------
+   // Jump-and-walk point location.
+   //
+   // Triangles are stored like in DelaunayLocationLinear (traversal order stays
+   // the same). A coarse uniform grid remembers a triangle for every cell
+   // ("jump"), from there the location walks along the neighbour relations
+   // towards the query point ("walk"). Unlike the hierarchies this does not
+   // care about triangles being modified in place (FlipEdge), because the walk
+   // only uses the topology.
+   // If the walk fails (holes, degenerated triangles) a linear search is done.
+   // Points on edges or vertices resolve to the triangle the linear search
+   // would return (see _Resolve).
+
+   class OPENGLOBE_API DelaunayLocationJumpAndWalk : public DelaunayLocationLinear
+   {
+   public:
+      DelaunayLocationJumpAndWalk(double xmin, double ymin, double xmax, double ymax)
+         : _xmin(xmin), _ymin(ymin), _xmax(xmax), _ymax(ymax)
+      {
+         _pLastTriangle = 0;
+         _nGridSize = 0;
+         _nRotation = 0;
+      }
+
+      virtual ~DelaunayLocationJumpAndWalk(){}
+
+      //-----------------------------------------------------------------------
+   protected:
+
+      virtual void AddTriangle(DelaunayTriangle* pTriangle)
+      {
+         _lstTriangles.insert(pTriangle);
+         _pLastTriangle = pTriangle;
+
+         if (_lstTriangles.size() > 8*_vGrid.size() && 
+             _lstTriangles.size() >= DELAUNAYWALK_MIN_GRID_TRIANGLES &&
+             _nGridSize < DELAUNAYWALK_MAX_GRID_SIZE)
+         {
+            _RebuildGrid();
+         }
+         else
+         {
+            _SetGridHint(pTriangle);
+         }
+      }
+
+      //-----------------------------------------------------------------------
+
+      virtual void RemoveTriangle(DelaunayTriangle* pTriangle)
+      {
+         DelaunayLocationLinear::RemoveTriangle(pTriangle);
+
+         if (pTriangle == _pLastTriangle)
+         {
+            _pLastTriangle = 0;
+         }
+         // grid hints are validated on use, removing them here is not necessary.
+      }
+
+      //-----------------------------------------------------------------------
+
+      virtual DelaunayTriangle* GetTriangleAt(double x, double y, ePointTriangleRelation& eRelation)
+      {
+         DelaunayTriangle* pStart = _GetStartTriangle(x, y);
+
+         if (pStart)
+         {
+            DelaunayTriangle* pTri = _Walk(pStart, x, y, eRelation);
+            if (pTri && eRelation != PointTriangle_Invalid)
+            {
+               _pLastTriangle = pTri;
+               if (eRelation != PointTriangle_Inside)
+               {
+                  // point is on an edge or vertex: several triangles contain it.
+                  pTri = _Resolve(pTri, x, y, eRelation);
+               }
+               return pTri;
+            }
+         }
+
+         // walk failed: fall back to linear search
+         return DelaunayLocationLinear::GetTriangleAt(x, y, eRelation);
+      }
+
+      //-----------------------------------------------------------------------
+
+   private:
+      enum
+      {
+         DELAUNAYWALK_MIN_GRID_TRIANGLES = 64,  // small triangulations don't use a grid
+         DELAUNAYWALK_MAX_GRID_SIZE = 1024,     // maximum number of cells in x and y
+      };
+
+      //-----------------------------------------------------------------------
+
+      inline int _GetCell(double x, double y)
+      {
+         int cx = int(double(_nGridSize)*(x-_xmin)/(_xmax-_xmin));
+         int cy = int(double(_nGridSize)*(y-_ymin)/(_ymax-_ymin));
+
+         cx = math::Max<int>(0, math::Min<int>(cx, _nGridSize-1));
+         cy = math::Max<int>(0, math::Min<int>(cy, _nGridSize-1));
+
+         return cy*_nGridSize+cx;
+      }
+
+      //-----------------------------------------------------------------------
+
+      inline void _SetGridHint(DelaunayTriangle* pTri)
+      {
+         if (_nGridSize > 0)
+         {
+            double cx = (pTri->GetVertex(0)->x() + pTri->GetVertex(1)->x() + pTri->GetVertex(2)->x()) / 3.0;
+            double cy = (pTri->GetVertex(0)->y() + pTri->GetVertex(1)->y() + pTri->GetVertex(2)->y()) / 3.0;
+
+            _vGrid[_GetCell(cx, cy)] = pTri;
+         }
+      }
+
+      //-----------------------------------------------------------------------
+
+      // Resize grid to hold approx. 2 triangles per cell and refill it.
+      void _RebuildGrid()
+      {
+         int nGridSize = _nGridSize > 0 ? _nGridSize : 4;
+         while (2*size_t(nGridSize)*size_t(nGridSize) < _lstTriangles.size() && nGridSize < DELAUNAYWALK_MAX_GRID_SIZE)
+         {
+            nGridSize *= 2;
+         }
+
+         _nGridSize = nGridSize;
+         _vGrid.assign(size_t(_nGridSize)*size_t(_nGridSize), (DelaunayTriangle*)0);
+
+         std::set<DelaunayTriangle*>::iterator it = _lstTriangles.begin();
+         while (it != _lstTriangles.end())
+         {
+            _SetGridHint(*it);
+            ++it;
+         }
+      }
+
+      //-----------------------------------------------------------------------
+
+      DelaunayTriangle* _GetStartTriangle(double x, double y)
+      {
+         if (_nGridSize > 0)
+         {
+            DelaunayTriangle* pHint = _vGrid[_GetCell(x, y)];
+
+            // hint may point to a deleted triangle.
+            if (pHint && _lstTriangles.find(pHint) != _lstTriangles.end())
+            {
+               return pHint;
+            }
+         }
+
+         if (_pLastTriangle)
+         {
+            return _pLastTriangle;
+         }
+
+         if (_lstTriangles.size() > 0)
+         {
+            return *_lstTriangles.begin();
+         }
+
+         return 0;
+      }
+
+      //-----------------------------------------------------------------------
+
+      // Visibility walk from pTri to point (x,y). Returns 0 if the walk leaves
+      // the triangulation or doesn't terminate.
+      DelaunayTriangle* _Walk(DelaunayTriangle* pTri, double x, double y, ePointTriangleRelation& eRelation)
+      {
+         DelaunayVertex tmpVertex(x,y);
+         DelaunayTriangle* pPrevious = 0;
+         size_t nMaxSteps = _lstTriangles.size() + 1;
+
+         for (size_t nStep = 0; nStep < nMaxSteps; nStep++)
+         {
+            DelaunayTriangle* pNext = 0;
+            bool bOutside = false;
+
+            // rotate first edge to test, this prevents cycles in non-delaunay triangulations.
+            int nFirst = (_nRotation++) % 3;
+
+            for (int k=0;k<3;k++)
+            {
+               int e = (nFirst + k) % 3;
+               DelaunayTriangle* pNeighbour = pTri->GetTriangle(e);
+
+               if (pNeighbour && pNeighbour == pPrevious)
+               {
+                  continue; // we came from there
+               }
+
+               if (math::ccw(&tmpVertex, pTri->GetVertex(e), pTri->GetVertex((e+1)%3)) < 0)
+               {
+                  pNext = pNeighbour;
+                  bOutside = true;
+                  break;
+               }
+            }
+
+            if (!bOutside)
+            {
+               eRelation = GetPointTriangleRelationRobust(&tmpVertex, pTri, _dEpsilon);
+               if (eRelation != PointTriangle_Outside)
+               {
+                  return pTri;
+               }
+               return 0;
+            }
+
+            if (!pNext)
+            {
+               return 0; // left triangulation (hole or border)
+            }
+
+            pPrevious = pTri;
+            pTri = pNext;
+         }
+
+         return 0;
+      }
+
+      //-----------------------------------------------------------------------
+
+      // Add all triangles sharing vertex pVertex (starting with pTri) to vTriangles.
+      void _CollectRing(DelaunayTriangle* pTri, DelaunayVertex* pVertex, std::vector<DelaunayTriangle*>& vTriangles)
+      {
+         std::vector<DelaunayTriangle*> vRing;
+         std::vector<DelaunayTriangle*> vStack;
+         vStack.push_back(pTri);
+
+         while (vStack.size() > 0)
+         {
+            DelaunayTriangle* pCurrent = vStack.back();
+            vStack.pop_back();
+
+            if (std::find(vRing.begin(), vRing.end(), pCurrent) != vRing.end())
+            {
+               continue;
+            }
+
+            vRing.push_back(pCurrent);
+
+            for (int k=0;k<3;k++)
+            {
+               DelaunayTriangle* pNeighbour = pCurrent->GetTriangle(k);
+               if (pNeighbour && 
+                   (pNeighbour->GetVertex(0) == pVertex || pNeighbour->GetVertex(1) == pVertex || pNeighbour->GetVertex(2) == pVertex))
+               {
+                  vStack.push_back(pNeighbour);
+               }
+            }
+         }
+
+         vTriangles.insert(vTriangles.end(), vRing.begin(), vRing.end());
+      }
+
+      //-----------------------------------------------------------------------
+
+      // A point on an edge or vertex is contained in more than one triangle.
+      // The linear search returns the first of them in traversal order (and
+      // Reduce/Simplify depend on that choice), so test all triangles around
+      // the vertices of pTri in the same order. Only the returned triangle may
+      // move the query point onto its edge, so every test uses a fresh vertex.
+      DelaunayTriangle* _Resolve(DelaunayTriangle* pTri, double x, double y, ePointTriangleRelation& eRelation)
+      {
+         std::vector<DelaunayTriangle*> vTriangles;
+         _CollectRing(pTri, pTri->GetVertex(0), vTriangles);
+         _CollectRing(pTri, pTri->GetVertex(1), vTriangles);
+         _CollectRing(pTri, pTri->GetVertex(2), vTriangles);
+
+         std::sort(vTriangles.begin(), vTriangles.end(), std::less<DelaunayTriangle*>());
+         vTriangles.erase(std::unique(vTriangles.begin(), vTriangles.end()), vTriangles.end());
+
+         for (size_t i=0;i<vTriangles.size();i++)
+         {
+            DelaunayVertex tmpVertex(x,y);
+            ePointTriangleRelation e = GetPointTriangleRelationRobust(&tmpVertex, vTriangles[i], _dEpsilon);
+            if (e != PointTriangle_Outside)
+            {
+               eRelation = e;
+               return vTriangles[i];
+            }
+         }
+
+         return pTri;
+      }
+
+      //-----------------------------------------------------------------------
+
+      double _xmin, _ymin, _xmax, _ymax;
+      DelaunayTriangle* _pLastTriangle;
+      std::vector<DelaunayTriangle*> _vGrid;
+      int _nGridSize;
+      unsigned int _nRotation;
+   };
+}
+
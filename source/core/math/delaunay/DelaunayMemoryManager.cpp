@@ -18,25 +18,127 @@
 
 #include "DelaunayMemoryManager.h"
 #include <iostream>
+#include <cstdlib>
+#include <new>
 
 //-----------------------------------------------------------------------------
 
-unsigned int DelaunayMemoryManager::_nTrianglesCount = 0;
-unsigned int DelaunayMemoryManager::_nVerticesCount = 0;
+int DelaunayMemoryManager::_nTrianglesCount = 0;
+int DelaunayMemoryManager::_nVerticesCount = 0;
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+   // Pool for objects of one type. Must be POD (it is OpenMP threadprivate).
+   struct SDelaunayPool
+   {
+      void*          pFreeList;  // freed objects, linked through their first bytes
+      char*          pSlab;      // current slab, first bytes link to previous slab
+      size_t         nUsed;      // used bytes in current slab
+      size_t         nAlive;     // number of allocated objects
+   };
+
+   // objects are aligned to 16 bytes, the slab header has the same size.
+   const size_t DMM_ALIGNMENT = 16;
+
+   inline size_t _AlignedSize(size_t nSize)
+   {
+      return (nSize + DMM_ALIGNMENT - 1) & ~(DMM_ALIGNMENT - 1);
+   }
+
+   //--------------------------------------------------------------------------
+
+   void* _PoolAlloc(SDelaunayPool& oPool, size_t nObjectSize)
+   {
+#ifdef DMM_NO_POOLS
+      oPool.nAlive++;
+      return ::operator new(nObjectSize, std::nothrow);
+#else
+      size_t nSize = _AlignedSize(nObjectSize);
+      void* p;
+
+      if (oPool.pFreeList)
+      {
+         p = oPool.pFreeList;
+         oPool.pFreeList = *((void**)p);
+      }
+      else
+      {
+         if (!oPool.pSlab || oPool.nUsed + nSize > DMM_ALIGNMENT + DMM_SLAB_OBJECTS*nSize)
+         {
+            char* pSlab = (char*)malloc(DMM_ALIGNMENT + DMM_SLAB_OBJECTS*nSize);
+            if (!pSlab)
+            {
+               return 0;
+            }
+            *((char**)pSlab) = oPool.pSlab;
+            oPool.pSlab = pSlab;
+            oPool.nUsed = DMM_ALIGNMENT;
+         }
+
+         p = oPool.pSlab + oPool.nUsed;
+         oPool.nUsed += nSize;
+      }
+
+      oPool.nAlive++;
+      return p;
+#endif
+   }
+
+   //--------------------------------------------------------------------------
+
+   void _PoolFree(SDelaunayPool& oPool, void* p)
+   {
+#ifdef DMM_NO_POOLS
+      oPool.nAlive--;
+      ::operator delete(p);
+#else
+      *((void**)p) = oPool.pFreeList;
+      oPool.pFreeList = p;
+      oPool.nAlive--;
+
+      if (oPool.nAlive == 0)
+      {
+         // release all slabs at once
+         while (oPool.pSlab)
+         {
+            char* pPrevious = *((char**)oPool.pSlab);
+            free(oPool.pSlab);
+            oPool.pSlab = pPrevious;
+         }
+
+         oPool.pFreeList = 0;
+         oPool.nUsed = 0;
+      }
+#endif
+   }
+
+   //--------------------------------------------------------------------------
+
+   SDelaunayPool s_oVertexPool = {0, 0, 0, 0};
+   SDelaunayPool s_oTrianglePool = {0, 0, 0, 0};
+#  pragma omp threadprivate(s_oVertexPool, s_oTrianglePool)
+
+}
 
 //-----------------------------------------------------------------------------
 
 math::DelaunayVertex* DelaunayMemoryManager::AllocVertex(double x, double y, double elevation, double weight)
 {
-   math::DelaunayVertex* pNewVertex;
-   pNewVertex = new math::DelaunayVertex(x,y,elevation,weight);
-   if (pNewVertex) 
-      ++_nVerticesCount;
+   math::DelaunayVertex* pNewVertex = 0;
+   void* p = _PoolAlloc(s_oVertexPool, sizeof(math::DelaunayVertex));
+   if (p)
+   {
+      pNewVertex = new(p) math::DelaunayVertex(x,y,elevation,weight);
+      #pragma omp atomic
+      _nVerticesCount++;
+   }
 
 #ifdef DMM_MEMORY_DEBUG
    std::cout << "<b>Alloc Vertex(x,y,e,w)</b>\n";
-   std::cout << "Triangles: " << _nTrianglesCount << ", Vertices: " << _nVerticesCount << "\n";
-   std::cout << "Total Memory: " << double(_nTrianglesCount*sizeof(math::DelaunayTriangle) + _nVerticesCount*sizeof(math::DelaunayVertex))/1024.0/1024.0 << " MB\n";
+   std::cout << "Triangles: " << GetNumTriangles() << ", Vertices: " << GetNumVertices() << "\n";
+   std::cout << "Total Memory: " << GetMemory() << " MB\n";
 #endif
    return pNewVertex;
 }
@@ -45,15 +147,19 @@ math::DelaunayVertex* DelaunayMemoryManager::AllocVertex(double x, double y, dou
 
 math::DelaunayVertex* DelaunayMemoryManager::AllocVertex(const ElevationPoint& pt)
 {
-   math::DelaunayVertex* pNewVertex;
-   pNewVertex = new math::DelaunayVertex(pt);
-   if (pNewVertex) 
-      ++_nVerticesCount;
+   math::DelaunayVertex* pNewVertex = 0;
+   void* p = _PoolAlloc(s_oVertexPool, sizeof(math::DelaunayVertex));
+   if (p)
+   {
+      pNewVertex = new(p) math::DelaunayVertex(pt);
+      #pragma omp atomic
+      _nVerticesCount++;
+   }
 
 #ifdef DMM_MEMORY_DEBUG
    std::cout << "<b>Alloc Vertex(pt)</b>\n";
-   std::cout << "Triangles: " << _nTrianglesCount << ", Vertices: " << _nVerticesCount << "\n";
-   std::cout << "Total Memory: " << double(_nTrianglesCount*sizeof(math::DelaunayTriangle) + _nVerticesCount*sizeof(math::DelaunayVertex))/1024.0/1024.0 << " MB\n";
+   std::cout << "Triangles: " << GetNumTriangles() << ", Vertices: " << GetNumVertices() << "\n";
+   std::cout << "Total Memory: " << GetMemory() << " MB\n";
 #endif
 
    return pNewVertex;
@@ -63,15 +169,19 @@ math::DelaunayVertex* DelaunayMemoryManager::AllocVertex(const ElevationPoint& p
 
 math::DelaunayTriangle* DelaunayMemoryManager::AllocTriangle()
 {
-   math::DelaunayTriangle* pNewTriangle;
-   pNewTriangle = new math::DelaunayTriangle();
-   if (pNewTriangle) 
-      ++_nTrianglesCount;
+   math::DelaunayTriangle* pNewTriangle = 0;
+   void* p = _PoolAlloc(s_oTrianglePool, sizeof(math::DelaunayTriangle));
+   if (p)
+   {
+      pNewTriangle = new(p) math::DelaunayTriangle();
+      #pragma omp atomic
+      _nTrianglesCount++;
+   }
 
 #ifdef DMM_MEMORY_DEBUG
    std::cout << "<b>Alloc Triangle()</b>\n";
-   std::cout << "Triangles: " << _nTrianglesCount << ", Vertices: " << _nVerticesCount << "\n";
-   std::cout << "Total Memory: " << double(_nTrianglesCount*sizeof(math::DelaunayTriangle) + _nVerticesCount*sizeof(math::DelaunayVertex))/1024.0/1024.0 << " MB\n";
+   std::cout << "Triangles: " << GetNumTriangles() << ", Vertices: " << GetNumVertices() << "\n";
+   std::cout << "Total Memory: " << GetMemory() << " MB\n";
 #endif
 
    return pNewTriangle;
@@ -83,13 +193,15 @@ void DelaunayMemoryManager::Free(math::DelaunayVertex* v)
 {
    if (v)
    {
-      --_nVerticesCount;
-      delete v;
+      #pragma omp atomic
+      _nVerticesCount--;
+      v->~DelaunayVertex();
+      _PoolFree(s_oVertexPool, v);
 
 #ifdef DMM_MEMORY_DEBUG
       std::cout << "<b>Free Vertex</b>\n";
-      std::cout << "Triangles: " << _nTrianglesCount << ", Vertices: " << _nVerticesCount << "\n";
-      std::cout << "Total Memory: " << double(_nTrianglesCount*sizeof(math::DelaunayTriangle) + _nVerticesCount*sizeof(math::DelaunayVertex))/1024.0/1024.0 << " MB\n";
+      std::cout << "Triangles: " << GetNumTriangles() << ", Vertices: " << GetNumVertices() << "\n";
+      std::cout << "Total Memory: " << GetMemory() << " MB\n";
 #endif
    }
 }
@@ -100,13 +212,15 @@ void DelaunayMemoryManager::Free(math::DelaunayTriangle* t)
 {
    if (t)
    {
-      --_nTrianglesCount;
-      delete t;
+      #pragma omp atomic
+      _nTrianglesCount--;
+      t->~DelaunayTriangle(); // may free vertices
+      _PoolFree(s_oTrianglePool, t);
 
 #ifdef DMM_MEMORY_DEBUG
       std::cout << "<b>Free Triangle</b>\n";
-      std::cout << "Triangles: " << _nTrianglesCount << ", Vertices: " << _nVerticesCount << "\n";
-      std::cout << "Total Memory: " << double(_nTrianglesCount*sizeof(math::DelaunayTriangle) + _nVerticesCount*sizeof(math::DelaunayVertex))/1024.0/1024.0 << " MB\n";
+      std::cout << "Triangles: " << GetNumTriangles() << ", Vertices: " << GetNumVertices() << "\n";
+      std::cout << "Total Memory: " << GetMemory() << " MB\n";
 #endif
    }
 }
@@ -115,18 +229,18 @@ void DelaunayMemoryManager::Free(math::DelaunayTriangle* t)
 
 void DelaunayMemoryManager::DumpMemoryInfo()
 {
-   std::cout << "<b>Total Memory for Delaunay Structure</b>\n" << double(_nTrianglesCount*sizeof(math::DelaunayTriangle) + _nVerticesCount*sizeof(math::DelaunayVertex))/1024.0 << " KB\n";
-   std::cout << "Vertices: " << _nVerticesCount << "\n";
-   std::cout << "Triangles: " << _nTrianglesCount << "\n";
+   std::cout << "<b>Total Memory for Delaunay Structure</b>\n" << GetMemory()*1024.0 << " KB\n";
+   std::cout << "Vertices: " << GetNumVertices() << "\n";
+   std::cout << "Triangles: " << GetNumTriangles() << "\n";
 }
 
 //-----------------------------------------------------------------------------
 
 void DelaunayMemoryManager::DumpMemoryInfoShort()
 {
-   std::cout << "Memory Delaunay:</b>\n" << double(_nTrianglesCount*sizeof(math::DelaunayTriangle) + _nVerticesCount*sizeof(math::DelaunayVertex))/1024.0/1024.0 << " MB ";
-   std::cout << "(vtx=" << _nVerticesCount << ", ";
-   std::cout << "tri= " << _nTrianglesCount << ")\n";
+   std::cout << "Memory Delaunay:</b>\n" << GetMemory() << " MB ";
+   std::cout << "(vtx=" << GetNumVertices() << ", ";
+   std::cout << "tri= " << GetNumTriangles() << ")\n";
 }
 
 //-----------------------------------------------------------------------------
@@ -134,7 +248,7 @@ void DelaunayMemoryManager::DumpMemoryInfoShort()
 
 double DelaunayMemoryManager::GetMemory()
 {
-   return double(_nTrianglesCount*sizeof(math::DelaunayTriangle) + _nVerticesCount*sizeof(math::DelaunayVertex))/1024.0/1024.0;
+   return double(GetNumTriangles()*sizeof(math::DelaunayTriangle) + GetNumVertices()*sizeof(math::DelaunayVertex))/1024.0/1024.0;
 
 }
 
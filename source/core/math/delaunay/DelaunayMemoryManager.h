@@ -30,6 +30,20 @@
 // be warned, this slows down everything!
 //#define DMM_MEMORY_DEBUG
 
+// Triangles and vertices are allocated from per-thread pools. A pool allocates 
+// memory in slabs of DMM_SLAB_OBJECTS objects and reuses freed objects. All slabs
+// of a pool are released once all of its objects are freed (i.e. when the last
+// triangulation of the thread is cleared or destroyed).
+// Objects must be freed by the thread that allocated them, so a triangulation
+// must not be passed between threads.
+// Note: the location structures order triangles by address, Reduce/Simplify
+// pick the first triangle in that order when several vertices have the same 
+// error or a point lies on an edge. Results on such data therefore depend on
+// the allocation order, like they depended on the heap before. Define 
+// DMM_NO_POOLS to allocate with new/delete like previous versions.
+#define DMM_SLAB_OBJECTS 4096
+//#define DMM_NO_POOLS
+
 class OPENGLOBE_API DelaunayMemoryManager
 {
 public:
@@ -49,8 +63,9 @@ public:
    static void DumpMemoryInfoShort();
 
 protected:
-   static unsigned int _nTrianglesCount;
-   static unsigned int _nVerticesCount;
+   // statistics of all threads (updated with omp atomic)
+   static int _nTrianglesCount;
+   static int _nVerticesCount;
 };
 
 
@@ -26,6 +26,7 @@
 #include <iostream>
 #include <boost/bind.hpp>
 #include <sstream>
+#include <functional>
 
 namespace math
 {
@@ -114,6 +115,7 @@ namespace math
       }
 
       _bError = false;
+      _qVertexError = std::priority_queue<SVertexError>();
    }
 
    //--------------------------------------------------------------------------
@@ -247,6 +249,20 @@ namespace math
       }
    }
 
+   //--------------------------------------------------------------------------
+
+   void DelaunayTriangulation::InsertPoints(const std::vector<ElevationPoint>& vPoints)
+   {
+      std::vector<size_t> vOrder;
+      HilbertOrder(vPoints, vOrder);
+
+      for (size_t i=0;i<vOrder.size();i++)
+      {
+         InsertPoint(vPoints[vOrder[i]]);
+      }
+   }
+
+   //--------------------------------------------------------------------------
 
    void DelaunayTriangulation::_InsertPointSetId(const ElevationPoint& pt, int id)
    {
@@ -660,6 +676,7 @@ namespace math
             {
                double dError = fabs(elv - pt.elevation);
                pTri->GetVertex(vtx)->GetElevationPoint().error = dError;
+               _PushVertexError(pTri, vtx);
                
                if (dError < _minError)
                {
@@ -701,6 +718,7 @@ namespace math
       _oVertexMinError.idx0 = -1;
 
       _minError = DBL_MAX;
+      _qVertexError = std::priority_queue<SVertexError>();
       // Reset Errors:
       _qLocationStructure->Traverse(boost::bind(&DelaunayTriangulation::_ResetVertexErrors, this, _1));
       _qLocationStructure->Traverse(boost::bind(&DelaunayTriangulation::_CalcVertexErrors, this, _1));
@@ -733,13 +751,32 @@ namespace math
 
             if (idx != -1)
             {
+               bool bCalc = vVertex[i]->GetElevationPoint().error <= -1.0;
                _CalcVertexErrorsVtx(pTri,idx);
+
+               // triangles around the vertex changed: queue it again with its new traversal order.
+               if (!bCalc)
+               {
+                  _PushVertexError(pTri, idx);
+               }
             }
             else
             {
                assert(false); // vertex not found!! How can this be ??!??
             }
          }
+         else if (pTri)
+         {
+            // first triangle is part of the supersimplex, vertex may still have other triangles.
+            for (idx=0;idx<3;idx++)
+            {
+               if (pTri->GetVertex(idx) == vVertex[i])
+               {
+                  _PushVertexError(pTri, idx);
+                  break;
+               }
+            }
+         }
 
       }
       
@@ -748,23 +785,49 @@ namespace math
 
    //--------------------------------------------------------------------------
 
-   void DelaunayTriangulation::_UpdateVertexErrors(DelaunayTriangle* pTri)
+   bool DelaunayTriangulation::_GetFirstTriangle(DelaunayTriangle* pTri, int idx, STriangleVertex& oFirst)
    {
-      double dError;
-
-      if (!pTri->IsSuperSimplex())
+      // The non-supersimplex triangle with lowest address is the one a traversal
+      // of the location structure finds first.
+      std::vector<STriangleVertex> vTriangles;
+      GetCCWTriangles(pTri, idx, vTriangles);
+
+      oFirst.pTri = 0;
+      oFirst.idx0 = -1;
+      for (size_t i=0;i<vTriangles.size();i++)
       {
-         for (int i=0;i<3;i++)
+         if (!vTriangles[i].pTri->IsSuperSimplex() && 
+            (oFirst.pTri == 0 || std::less<DelaunayTriangle*>()(vTriangles[i].pTri, oFirst.pTri)))
          {
-            dError = pTri->GetVertex(i)->GetElevationPoint().error;
-            if (dError < _minError)
-            {
-               _oVertexMinError.pTri = pTri;
-               _oVertexMinError.idx0 = i;
-               _minError = dError;
-            }
+            oFirst.pTri = vTriangles[i].pTri;
+            oFirst.idx0 = (vTriangles[i].idx0+2)%3;
          }
       }
+
+      return oFirst.pTri != 0;
+   }
+
+   //--------------------------------------------------------------------------
+
+   void DelaunayTriangulation::_PushVertexError(DelaunayTriangle* pTri, int idx)
+   {
+      DelaunayVertex* pVertex = pTri->GetVertex(idx);
+      STriangleVertex oFirst;
+
+      if (pVertex->GetElevationPoint().error == DBL_MAX || !_GetFirstTriangle(pTri, idx, oFirst))
+      {
+         return; // never selected
+      }
+
+      SVertexError oEntry;
+      oEntry.error = pVertex->GetElevationPoint().error;
+      oEntry.pTri = oFirst.pTri;
+      oEntry.idx = oFirst.idx0;
+      oEntry.pVertex = pVertex;
+      oEntry.x = pVertex->x();
+      oEntry.y = pVertex->y();
+
+      _qVertexError.push(oEntry);
    }
 
    //--------------------------------------------------------------------------
@@ -772,7 +835,44 @@ namespace math
    void DelaunayTriangulation::_UpdateMinError()
    {
       _minError = DBL_MAX;
-      _qLocationStructure->Traverse(boost::bind(&DelaunayTriangulation::_UpdateVertexErrors, this, _1));    
+      _oVertexMinError.pTri = 0;
+      _oVertexMinError.idx0 = -1;
+
+      // Remove invalid entries (removed vertices, changed errors or changed
+      // triangles) until a valid entry is on top. The valid entry stays in 
+      // queue, it will be invalid once the vertex is removed.
+      while (!_qVertexError.empty())
+      {
+         const SVertexError& oTop = _qVertexError.top();
+
+         ePointTriangleRelation e;
+         DelaunayTriangle* pTri = _qLocationStructure->GetTriangleAt(oTop.x, oTop.y, e);
+         int idx = -1;
+
+         if (pTri)
+         {
+            if (pTri->GetVertex(0) == oTop.pVertex)
+               idx = 0;
+            else if (pTri->GetVertex(1) == oTop.pVertex)
+               idx = 1;
+            else if (pTri->GetVertex(2) == oTop.pVertex)
+               idx = 2;
+         }
+
+         if (idx != -1 && pTri->GetVertex(idx)->GetElevationPoint().error == oTop.error)
+         {
+            STriangleVertex oFirst;
+            if (_GetFirstTriangle(pTri, idx, oFirst) && oFirst.pTri == oTop.pTri && oFirst.idx0 == oTop.idx)
+            {
+               _oVertexMinError.pTri = oFirst.pTri;
+               _oVertexMinError.idx0 = oFirst.idx0;
+               _minError = oTop.error;
+               return;
+            }
+         }
+
+         _qVertexError.pop();
+      }
    }
 
    //--------------------------------------------------------------------------
@@ -1256,6 +1356,7 @@ namespace math
                {
                   //std::cout << "<b>*WARNING* Detected infinite loop!</b>\n";
                   pVertex->GetElevationPoint().error = -0.5;
+                  _PushVertexError(outputTriangles[0].pTri, (outputTriangles[0].idx0+2)%3);
 
                   if (DebugOutput)
                      break;
@@ -24,6 +24,8 @@
 #include "DelaunayLocationStructure.h"
 #include "math/ElevationPoint.h"
 #include <vector>
+#include <queue>
+#include <functional>
 #include <boost/shared_ptr.hpp>
 #include <limits.h>
 
@@ -56,17 +58,48 @@ namespace math
       int idx0;
    };
 
+   //--------------------------------------------------------------------------
+   // Entry of the vertex error queue. Entries are never updated or removed 
+   // when a vertex changes, they are validated when they reach the top of 
+   // the queue (lazy invalidation).
+   // Equal errors are ordered like a traversal of the location structure 
+   // finds them: by the first non-supersimplex triangle of the vertex, then
+   // by the vertex index in that triangle.
+
+   struct SVertexError
+   {
+      double error;              // error of vertex at the time of insertion
+      DelaunayTriangle* pTri;    // first non-supersimplex triangle of vertex at the time of insertion
+      int idx;                   // index of vertex in pTri
+      DelaunayVertex* pVertex;   // vertex (may be deleted, never dereference before validation!)
+      double x, y;               // position of vertex
+
+      // priority_queue returns the largest element: least error has highest priority.
+      bool operator<(const SVertexError& other) const
+      {
+         if (error != other.error)
+            return error > other.error;
+         if (pTri != other.pTri)
+            return std::less<DelaunayTriangle*>()(other.pTri, pTri);
+         return idx > other.idx;
+      }
+   };
+
    //--------------------------------------------------------------------------
 
    class OPENGLOBE_API DelaunayTriangulation
    {
    public:
-      DelaunayTriangulation(double xmin, double ymin, double xmax, double ymax, EDelaunayLocationAlgorithms eAlgorithm = DELAUNAYLOCATION_LINEARLIST);
+      DelaunayTriangulation(double xmin, double ymin, double xmax, double ymax, EDelaunayLocationAlgorithms eAlgorithm = DELAUNAYLOCATION_JUMPANDWALK);
       virtual ~DelaunayTriangulation();
 
       void Clear();  // Clear Triangulation
       void InsertPoint(const ElevationPoint& pt);
 
+      //! Insert many points. Points are inserted along a hilbert curve, which is 
+      //! a lot faster than inserting them in arbitrary order.
+      void InsertPoints(const std::vector<ElevationPoint>& vPoints);
+
       //! Retrieve vector Containing all Elevation Points
       void GetPointVec(std::vector<ElevationPoint>& lstElevationPoint);
 
@@ -160,7 +193,8 @@ namespace math
       void _CollectTriangle(DelaunayTriangle* pTri);
       void _ResetVertexErrors(DelaunayTriangle* pTri);
       void _CalcVertexErrors(DelaunayTriangle* pTri);
-      void _UpdateVertexErrors(DelaunayTriangle* pTri);
+      bool _GetFirstTriangle(DelaunayTriangle* pTri, int idx, STriangleVertex& oFirst);
+      void _PushVertexError(DelaunayTriangle* pTri, int idx);
       void _CalcVertexErrorsVtx(DelaunayTriangle* pTri, int vtx);
       void _CollectElevationPoints(DelaunayTriangle* pTri);
       void _CollectTriangulationStructure(DelaunayTriangle* pTri);
@@ -189,6 +223,7 @@ namespace math
       bool     _bError; // true if errors are calculated and ok. false -> call CalculateVertexErrors() to have valid errors!
       double _minError;
       STriangleVertex  _oVertexMinError; // holds triangle / vertex with minimum error (only valid if _bError is true!!)
+      std::priority_queue<SVertexError> _qVertexError; // vertex errors, least error on top (only valid if _bError is true!!)
       
       ElevationPoint* _pt1;
       ElevationPoint* _pt2;
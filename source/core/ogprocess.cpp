@@ -305,6 +305,46 @@ namespace ProcessingUtils
       return vData;
    }
    //---------------------------------------------------------------------------
+   OPENGLOBE_API bool ImageWindowToMemoryRGB(const DataSetInfo& oDataset, int x, int y, int w, int h, unsigned char* pData)
+   {
+      if (!oDataset.bGood || oDataset.nBands != 3 || !pData)
+      {
+         return false;
+      }
+
+      if (x<0 || y<0 || w<=0 || h<=0 || x+w>oDataset.nSizeX || y+h>oDataset.nSizeY)
+      {
+         return false;
+      }
+
+      GDALDataset* s_fh = (GDALDataset*)GDALOpen(oDataset.sFilename.c_str(), GA_ReadOnly);
+      if(!s_fh)
+      {
+         return false;
+      }
+
+      CPLErr err = s_fh->RasterIO(
+         GF_Read,                      // eRWFlag
+         x,                            // nXOff
+         y,                            // nYOff
+         w,                            // nXSize
+         h,                            // nYSize
+         (void*)pData,                 // pData
+         w,                            // nBufXSize
+         h,                            // nBufYSize
+         GDT_Byte,                     // eBufType
+         3,                            // nBandCount
+         NULL,                         // panBandMap (1,2,3)
+         3,                            // nPixelSpace
+         3*w,                          // nLineSpace
+         1                             // nBandSpace
+         );
+
+      GDALClose(s_fh);
+
+      return err == CE_None;
+   }
+   //---------------------------------------------------------------------------
    OPENGLOBE_API boost::shared_array<float> ImageToMemoryGreyScale(const DataSetInfo& oDataset)
    {
       boost::shared_array<float> vData;
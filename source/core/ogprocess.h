@@ -100,6 +100,10 @@ namespace ProcessingUtils
    // Load image with 3 channels to RGB.
    OPENGLOBE_API boost::shared_array<unsigned char> ImageToMemoryRGB(const DataSetInfo& oDataset);
    //---------------------------------------------------------------------------
+   // Load window (x, y, w, h) of image with 3 channels to RGB.
+   // pData must hold 3*w*h bytes. Returns false if reading failed.
+   OPENGLOBE_API bool ImageWindowToMemoryRGB(const DataSetInfo& oDataset, int x, int y, int w, int h, unsigned char* pData);
+   //---------------------------------------------------------------------------
    // Load image with 1 channels to GreyScale 16 Bit.
    OPENGLOBE_API boost::shared_array<float> ImageToMemoryGreyScale(const DataSetInfo& oDataset);
 
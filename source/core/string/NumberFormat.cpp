@@ -0,0 +1,403 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#include "NumberFormat.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <clocale>
+#include <locale.h>
+#ifdef OS_MACOSX
+#include <xlocale.h>
+#endif
+
+#ifdef _MSC_VER
+#define snprintf _snprintf
+#endif
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+   // exact powers of ten
+   const double s_pow10[] = 
+   {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11, 
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+   };
+
+   const int MAXPOW10 = 22;
+
+   // precision up to 9 digits uses the fast path (error of scaled value is small enough)
+   const int MAXFASTPRECISION = 9;
+
+   //--------------------------------------------------------------------------
+
+   int _FormatPrintf(char* pBuffer, double value, int precision)
+   {
+      char buffer[NumberFormat::MAXLENGTH+1];
+      int n = snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+
+      // printf uses the decimal point of the current locale
+      char cPoint = localeconv()->decimal_point[0];
+      for (int i=0;i<n;i++)
+      {
+         pBuffer[i] = buffer[i] == cPoint ? '.' : buffer[i];
+      }
+      return n;
+   }
+
+   //--------------------------------------------------------------------------
+   // Scale value to a integer with precision digits: a * 10^(precision-1-e10).
+   // Returns false if power of ten is not exact.
+
+   bool _Scale(double a, int e10, int precision, double& m)
+   {
+      int k = precision-1-e10;
+      if (k >= 0)
+      {
+         if (k > MAXPOW10) return false;
+         m = a * s_pow10[k];
+      }
+      else
+      {
+         if (-k > MAXPOW10) return false;
+         m = a / s_pow10[-k];
+      }
+      return true;
+   }
+
+   //--------------------------------------------------------------------------
+   // Parse using strtod (inf, nan, hex values, many digits or large exponents). 
+   // strtod uses the decimal point of the current locale, the "C" locale is
+   // passed explicitly.
+
+#ifdef OS_WINDOWS
+   const _locale_t s_CLocale = _create_locale(LC_NUMERIC, "C");
+#else
+   const locale_t s_CLocale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+#endif
+
+   double _ParseStrtod(const char* pBegin, const char* pEnd)
+   {
+      std::string s(pBegin, pEnd);
+#ifdef OS_WINDOWS
+      return _strtod_l(s.c_str(), 0, s_CLocale);
+#else
+      return strtod_l(s.c_str(), 0, s_CLocale);
+#endif
+   }
+
+   //--------------------------------------------------------------------------
+
+   inline bool _IsDigit(char c)
+   {
+      return c >= '0' && c <= '9';
+   }
+
+   inline bool _IsSpace(char c)
+   {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+int NumberFormat::FormatInt(char* pBuffer, int64 value)
+{
+   char digits[24];
+   int n = 0;
+   int len = 0;
+
+   uint64 u = (uint64)value;
+   if (value < 0)
+   {
+      pBuffer[len++] = '-';
+      u = 0 - u;
+   }
+
+   do
+   {
+      digits[n++] = char('0' + u % 10);
+      u /= 10;
+   } while (u != 0);
+
+   while (n > 0)
+   {
+      pBuffer[len++] = digits[--n];
+   }
+
+   return len;
+}
+
+//-----------------------------------------------------------------------------
+
+int NumberFormat::FormatFloat(char* pBuffer, double value, int precision)
+{
+   if (precision < 1) precision = 1;
+
+   if (precision > MAXFASTPRECISION || !(value == value) || fabs(value) > 1e300)
+   {
+      return _FormatPrintf(pBuffer, value, precision);  // nan, inf, huge values, high precision
+   }
+
+   int len = 0;
+   if (value < 0 || (value == 0 && 1.0/value < 0))
+   {
+      pBuffer[len++] = '-';
+   }
+
+   double a = fabs(value);
+   if (a == 0)
+   {
+      pBuffer[len++] = '0';
+      return len;
+   }
+
+   // [1] calculate the 'precision' significant digits and the decimal exponent
+   int e10 = (int)floor(log10(a));
+   double m;
+   if (!_Scale(a, e10, precision, m))
+   {
+      return _FormatPrintf(pBuffer, value, precision);
+   }
+
+   const double lower = s_pow10[precision-1];
+   const double upper = s_pow10[precision];
+
+   if (m < lower)
+   {
+      e10--;
+      if (!_Scale(a, e10, precision, m)) return _FormatPrintf(pBuffer, value, precision);
+   }
+   else if (m >= upper)
+   {
+      e10++;
+      if (!_Scale(a, e10, precision, m)) return _FormatPrintf(pBuffer, value, precision);
+   }
+
+   // scaled value has a relative error of 1 ulp. If it is too close to .5 the
+   // rounding direction is not known, printf computes it exactly.
+   double fl = floor(m);
+   double frac = m - fl;
+   if (fabs(frac - 0.5) < upper * 1e-15)
+   {
+      return _FormatPrintf(pBuffer, value, precision);
+   }
+
+   uint64 r = (uint64)fl + (frac > 0.5 ? 1 : 0);
+   if (r >= (uint64)upper)
+   {
+      r /= 10;
+      e10++;
+   }
+
+   char digits[MAXFASTPRECISION];
+   for (int i=precision-1;i>=0;i--)
+   {
+      digits[i] = char('0' + r % 10);
+      r /= 10;
+   }
+
+   // number of significant digits without trailing zeros
+   int nDigits = precision;
+   while (nDigits > 1 && digits[nDigits-1] == '0')
+   {
+      nDigits--;
+   }
+
+   // [2] write digits (same rules as %g)
+   if (e10 < -4 || e10 >= precision)
+   {
+      // exponential notation: d.ddde+XX
+      pBuffer[len++] = digits[0];
+      if (nDigits > 1)
+      {
+         pBuffer[len++] = '.';
+         for (int i=1;i<nDigits;i++)
+         {
+            pBuffer[len++] = digits[i];
+         }
+      }
+
+      pBuffer[len++] = 'e';
+      int e = e10;
+      if (e < 0)
+      {
+         pBuffer[len++] = '-';
+         e = -e;
+      }
+      else
+      {
+         pBuffer[len++] = '+';
+      }
+
+      if (e >= 100)
+      {
+         pBuffer[len++] = char('0' + e / 100);
+         e %= 100;
+      }
+      pBuffer[len++] = char('0' + e / 10);
+      pBuffer[len++] = char('0' + e % 10);
+   }
+   else if (e10 >= 0)
+   {
+      // fixed notation: ddd.ddd
+      for (int i=0;i<=e10;i++)
+      {
+         pBuffer[len++] = digits[i];
+      }
+      if (nDigits > e10+1)
+      {
+         pBuffer[len++] = '.';
+         for (int i=e10+1;i<nDigits;i++)
+         {
+            pBuffer[len++] = digits[i];
+         }
+      }
+   }
+   else
+   {
+      // fixed notation: 0.000ddd
+      pBuffer[len++] = '0';
+      pBuffer[len++] = '.';
+      for (int i=0;i<-e10-1;i++)
+      {
+         pBuffer[len++] = '0';
+      }
+      for (int i=0;i<nDigits;i++)
+      {
+         pBuffer[len++] = digits[i];
+      }
+   }
+
+   return len;
+}
+
+//-----------------------------------------------------------------------------
+
+double NumberFormat::ParseFloat(const char* pBegin, const char* pEnd)
+{
+   const char* p = pBegin;
+   while (p < pEnd && _IsSpace(*p))
+   {
+      p++;
+   }
+
+   bool bNegative = false;
+   if (p < pEnd && (*p == '-' || *p == '+'))
+   {
+      bNegative = (*p == '-');
+      p++;
+   }
+
+   // hex values
+   if (p+1 < pEnd && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+   {
+      return _ParseStrtod(pBegin, pEnd);
+   }
+
+   // mantissa: up to 19 significant digits are accumulated
+   uint64 m = 0;
+   int nDigits = 0;        // significant digits
+   int nExp = 0;           // decimal exponent of m
+   bool bDigits = false;   // atleast one digit
+
+   while (p < pEnd && *p == '0')
+   {
+      p++;
+      bDigits = true;
+   }
+   while (p < pEnd && _IsDigit(*p))
+   {
+      if (nDigits < 19) m = 10*m + (*p - '0'); else nExp++;
+      nDigits++;
+      p++;
+      bDigits = true;
+   }
+
+   if (p < pEnd && *p == '.')
+   {
+      p++;
+      if (nDigits == 0)
+      {
+         while (p < pEnd && *p == '0')
+         {
+            nExp--;
+            p++;
+            bDigits = true;
+         }
+      }
+      while (p < pEnd && _IsDigit(*p))
+      {
+         if (nDigits < 19) { m = 10*m + (*p - '0'); nExp--; }
+         nDigits++;
+         p++;
+         bDigits = true;
+      }
+   }
+
+   if (!bDigits)
+   {
+      // no number, or inf, nan or hex value
+      return _ParseStrtod(pBegin, pEnd);
+   }
+
+   // exponent (only if followed by digits)
+   if (p < pEnd && (*p == 'e' || *p == 'E'))
+   {
+      const char* q = p+1;
+      bool bNegativeExp = false;
+      if (q < pEnd && (*q == '-' || *q == '+'))
+      {
+         bNegativeExp = (*q == '-');
+         q++;
+      }
+      if (q < pEnd && _IsDigit(*q))
+      {
+         int e = 0;
+         while (q < pEnd && _IsDigit(*q))
+         {
+            if (e < 100000) e = 10*e + (*q - '0');
+            q++;
+         }
+         nExp += bNegativeExp ? -e : e;
+      }
+   }
+
+   // m and 10^nExp are exact doubles, so the result is correctly rounded
+   if (nDigits > 19 || m > (uint64(1) << 53) || nExp > MAXPOW10 || nExp < -MAXPOW10)
+   {
+      return _ParseStrtod(pBegin, pEnd);
+   }
+
+   double value = double(m);
+   if (nExp >= 0)
+   {
+      value *= s_pow10[nExp];
+   }
+   else
+   {
+      value /= s_pow10[-nExp];
+   }
+
+   return bNegative ? -value : value;
+}
+
+//-----------------------------------------------------------------------------
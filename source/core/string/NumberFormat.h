@@ -0,0 +1,67 @@
+/*******************************************************************************
+#      ____               __          __  _      _____ _       _               #
+#     / __ \              \ \        / / | |    / ____| |     | |              #
+#    | |  | |_ __   ___ _ __ \  /\  / /__| |__ | |  __| | ___ | |__   ___      #
+#    | |  | | '_ \ / _ \ '_ \ \/  \/ / _ \ '_ \| | |_ | |/ _ \| '_ \ / _ \     #
+#    | |__| | |_) |  __/ | | \  /\  /  __/ |_) | |__| | | (_) | |_) |  __/     #
+#     \____/| .__/ \___|_| |_|\/  \/ \___|_.__/ \_____|_|\___/|_.__/ \___|     #
+#           | |                                                                #
+#           |_|                                                                #
+#                                                                              #
+#                                (c) 2011 by                                   #
+#           University of Applied Sciences Northwestern Switzerland            #
+#                     Institute of Geomatics Engineering                       #
+#                           martin.christen@fhnw.ch                            #
+********************************************************************************
+*     Licensed under MIT License. Read the file LICENSE for more information   *
+*******************************************************************************/
+
+#ifndef _NUMBERFORMAT_H_
+#define _NUMBERFORMAT_H_
+
+#include "og.h"
+#include <string>
+
+//-----------------------------------------------------------------------------
+//! \brief Fast number to text and text to number conversion
+//! \ingroup string
+//! Output is identical to std::ostream with default float field and the
+//! same precision (printf "%.*g" and "%lld") in the "C" locale. Parsing is
+//! identical to atof in the "C" locale. The current locale is never used.
+class OPENGLOBE_API NumberFormat
+{
+public:
+   //! \brief Maximum number of characters written by Format functions.
+   enum { MAXLENGTH = 32 };
+
+   //! \brief Format floating point value like printf("%.*g", precision, value).
+   //! \param pBuffer output buffer (atleast MAXLENGTH chars), not zero terminated.
+   //! \return number of characters written
+   static int FormatFloat(char* pBuffer, double value, int precision);
+
+   //! \brief Format integer value.
+   //! \param pBuffer output buffer (atleast MAXLENGTH chars), not zero terminated.
+   //! \return number of characters written
+   static int FormatInt(char* pBuffer, int64 value);
+
+   //! \brief Parse floating point value at the beginning of [pBegin, pEnd) like atof:
+   //! the longest valid prefix is converted, 0 is returned if there is none. 
+   //! The decimal point is always '.', independent of the current locale.
+   static double ParseFloat(const char* pBegin, const char* pEnd);
+
+   //! \brief Append floating point value to string.
+   static void AppendFloat(std::string& s, double value, int precision)
+   {
+      char buffer[MAXLENGTH];
+      s.append(buffer, FormatFloat(buffer, value, precision));
+   }
+
+   //! \brief Append integer value to string.
+   static void AppendInt(std::string& s, int64 value)
+   {
+      char buffer[MAXLENGTH];
+      s.append(buffer, FormatInt(buffer, value));
+   }
+};
+
+#endif